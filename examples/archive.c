@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include <nexrad/archive.h>
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s archive create [-a] file ...\n", argv[0]);
+    fprintf(stderr, "       %s archive list\n", argv[0]);
+    fprintf(stderr, "       %s archive find station code [start end]\n", argv[0]);
+    exit(1);
+}
+
+static void print_entry(nexrad_archive *archive, const nexrad_catalog_entry *entry) {
+    nexrad_catalog *catalog = nexrad_archive_get_catalog(archive);
+    nexrad_message *message;
+    int type = -1;
+
+    if ((message = nexrad_archive_open_message(archive, entry, NULL)) != NULL) {
+        type = nexrad_message_get_product_type(message);
+
+        nexrad_message_destroy(message);
+    }
+
+    printf("%s %s %d %lld %lld %llu %llu %s%s\n",
+        entry->station, entry->product_code, entry->type,
+        (long long)entry->scan_timestamp, (long long)entry->gen_timestamp,
+        (unsigned long long)entry->offset, (unsigned long long)entry->size,
+        nexrad_catalog_entry_path(catalog, entry),
+        type == entry->type? "": " (unreadable)");
+}
+
+static int create(const char *path, int argc, char **argv) {
+    nexrad_archive_writer *writer;
+    int flags = 0, i = 0, added = 0;
+
+    if (argc > 0 && strcmp(argv[0], "-a") == 0) {
+        flags |= NEXRAD_ARCHIVE_ALIGN;
+        i++;
+    }
+
+    if ((writer = nexrad_archive_writer_create(path, flags)) == NULL) {
+        perror("nexrad_archive_writer_create()");
+        return -1;
+    }
+
+    for (; i<argc; i++) {
+        if (nexrad_archive_writer_add_file(writer, argv[i]) < 0) {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+            continue;
+        }
+
+        added++;
+    }
+
+    if (nexrad_archive_writer_close(writer) < 0) {
+        perror("nexrad_archive_writer_close()");
+        return -1;
+    }
+
+    printf("%d added\n", added);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    nexrad_archive *archive;
+    nexrad_catalog *catalog;
+
+    if (argc < 3) {
+        usage(argc, argv);
+    }
+
+    if (strcmp(argv[2], "create") == 0) {
+        return create(argv[1], argc - 3, argv + 3) < 0? 1: 0;
+    }
+
+    if ((archive = nexrad_archive_open(argv[1])) == NULL) {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        exit(1);
+    }
+
+    catalog = nexrad_archive_get_catalog(archive);
+
+    if (strcmp(argv[2], "list") == 0) {
+        size_t count = nexrad_catalog_count(catalog), i;
+
+        for (i=0; i<count; i++) {
+            print_entry(archive, nexrad_catalog_get_entry(catalog, i));
+        }
+    } else if (strcmp(argv[2], "find") == 0 && argc >= 5) {
+        const nexrad_catalog_entry *entries;
+        time_t start = argc > 6? atol(argv[5]): INT64_MIN,
+               end   = argc > 6? atol(argv[6]): INT64_MAX;
+        ssize_t count, i;
+
+        if ((count = nexrad_catalog_find(catalog, argv[3], argv[4], start, end, &entries)) < 0) {
+            perror("nexrad_catalog_find()");
+            exit(1);
+        }
+
+        for (i=0; i<count; i++) {
+            print_entry(archive, &entries[i]);
+        }
+    } else {
+        usage(argc, argv);
+    }
+
+    nexrad_archive_close(archive);
+
+    return 0;
+}
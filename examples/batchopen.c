@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+#include <nexrad/batch.h>
+
+/*
+ * Open every file given, or every file named on standard input, in bulk, and
+ * report the rate at which messages were opened.
+ */
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-t] [-l] [-d depth] [file.l3 ...]\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void opened(nexrad_message *message, const char *path, size_t index, int error, void *data) {
+    if (message == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(error));
+
+        return;
+    }
+
+    nexrad_message_destroy(message);
+}
+
+static char **read_paths(size_t *countp) {
+    char **paths = NULL, line[4096];
+    size_t count = 0, size = 0;
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+
+        if (count == size) {
+            size = size? size * 2: 1024;
+
+            if ((paths = realloc(paths, size * sizeof(char *))) == NULL) {
+                perror("realloc()");
+                exit(1);
+            }
+        }
+
+        paths[count++] = strdup(line);
+    }
+
+    *countp = count;
+
+    return paths;
+}
+
+int main(int argc, char **argv) {
+    enum nexrad_message_batch_backend backend = NEXRAD_MESSAGE_BATCH_AUTO;
+    nexrad_message_batch *batch;
+    nexrad_message_ctx *ctx;
+    char **paths;
+    size_t count;
+    ssize_t total;
+    double start, elapsed;
+    int depth = 0, c;
+
+    while ((c = getopt(argc, argv, "tld:")) != -1) {
+        switch (c) {
+            case 't': backend = NEXRAD_MESSAGE_BATCH_THREADS; break;
+            case 'l': backend = -1; break;
+            case 'd': depth = atoi(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind < argc) {
+        paths = argv + optind;
+        count = argc - optind;
+    } else {
+        paths = read_paths(&count);
+    }
+
+    if ((ctx = nexrad_message_ctx_create()) == NULL) {
+        perror("nexrad_message_ctx_create()");
+        exit(1);
+    }
+
+    nexrad_message_ctx_set_flags(ctx, NEXRAD_MESSAGE_LAZY);
+
+    start = now();
+
+    /*
+     * With -l, open messages one at a time for comparison.
+     */
+    if ((int)backend == -1) {
+        size_t i;
+
+        for (i=0, total=0; i<count; i++) {
+            nexrad_message *message;
+
+            if ((message = nexrad_message_open_ctx(paths[i], ctx)) == NULL) {
+                perror(paths[i]);
+
+                continue;
+            }
+
+            total++;
+
+            nexrad_message_destroy(message);
+        }
+
+        printf("backend: serial\n");
+    } else {
+        if ((batch = nexrad_message_batch_create(ctx, backend, depth)) == NULL) {
+            perror("nexrad_message_batch_create()");
+            exit(1);
+        }
+
+        if ((total = nexrad_message_batch_open(batch, (const char **)paths, count, opened, NULL)) < 0) {
+            perror("nexrad_message_batch_open()");
+            exit(1);
+        }
+
+        printf("backend: %s\n",
+            nexrad_message_batch_get_backend(batch) == NEXRAD_MESSAGE_BATCH_IO_URING?
+                "io_uring": "threads");
+
+        nexrad_message_batch_destroy(batch);
+    }
+
+    elapsed = now() - start;
+
+    printf("%zd/%zu messages in %.3f s: %.0f messages/s\n",
+        total, count, elapsed, total / elapsed);
+
+    nexrad_message_ctx_destroy(ctx);
+
+    return 0;
+}
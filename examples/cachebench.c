@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <nexrad/message.h>
+#include <nexrad/cache.h>
+
+/*
+ * Simulate several consumers opening the same fresh products at once, each in
+ * its own thread with its own decoding context, and compare the cost of every
+ * consumer decompressing each product for itself against sharing a single
+ * cache of decompressed bodies between them.
+ */
+
+struct consumer {
+    pthread_t              thread;
+    nexrad_message_cache * cache;
+    int                    iterations;
+    int                    count;
+    char **                files;
+    int                    error;
+};
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-n iterations] [-t threads] [-b budget] file.l3 ...\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *consume(void *data) {
+    struct consumer *consumer = data;
+    nexrad_message_ctx *ctx;
+    int i, f;
+
+    if ((ctx = nexrad_message_ctx_create()) == NULL) {
+        goto error_ctx_create;
+    }
+
+    nexrad_message_ctx_set_cache(ctx, consumer->cache);
+
+    for (i=0; i<consumer->iterations; i++) {
+        for (f=0; f<consumer->count; f++) {
+            nexrad_message *message;
+
+            if ((message = nexrad_message_open_ctx(consumer->files[f], ctx)) == NULL) {
+                perror(consumer->files[f]);
+
+                goto error_message_open;
+            }
+
+            nexrad_message_destroy(message);
+        }
+    }
+
+    nexrad_message_ctx_destroy(ctx);
+
+    return NULL;
+
+error_message_open:
+    nexrad_message_ctx_destroy(ctx);
+
+error_ctx_create:
+    consumer->error = 1;
+
+    return NULL;
+}
+
+static int bench(const char *name, nexrad_message_cache *cache, int threads, int iterations, int count, char **files) {
+    struct consumer *consumers;
+    double start, elapsed;
+    int i, started, ret = 0;
+
+    if ((consumers = calloc(threads, sizeof(*consumers))) == NULL) {
+        return -1;
+    }
+
+    start = now();
+
+    for (started=0; started<threads; started++) {
+        struct consumer *consumer = &consumers[started];
+
+        consumer->cache      = cache;
+        consumer->iterations = iterations;
+        consumer->count      = count;
+        consumer->files      = files;
+
+        if (pthread_create(&consumer->thread, NULL, consume, consumer) != 0) {
+            ret = -1;
+
+            break;
+        }
+    }
+
+    for (i=0; i<started; i++) {
+        pthread_join(consumers[i].thread, NULL);
+
+        if (consumers[i].error) {
+            ret = -1;
+        }
+    }
+
+    elapsed = now() - start;
+
+    free(consumers);
+
+    if (ret == 0) {
+        printf("%-6s %10.3f us/open\n",
+            name, elapsed * 1e6 / ((double)threads * iterations * count));
+    }
+
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    nexrad_message_cache *cache;
+    nexrad_message_cache_stats stats;
+    int iterations = 100, threads = 4, c;
+    size_t budget = 64 * 1024 * 1024;
+
+    while ((c = getopt(argc, argv, "n:t:b:")) != -1) {
+        switch (c) {
+            case 'n': iterations = atoi(optarg); break;
+            case 't': threads    = atoi(optarg); break;
+            case 'b': budget     = atol(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind >= argc || iterations < 1 || threads < 1) {
+        usage(argc, argv);
+    }
+
+    if (bench("none", NULL, threads, iterations, argc - optind, argv + optind) < 0) {
+        return 1;
+    }
+
+    if ((cache = nexrad_message_cache_create(budget)) == NULL) {
+        perror("nexrad_message_cache_create()");
+        return 1;
+    }
+
+    if (bench("cache", cache, threads, iterations, argc - optind, argv + optind) < 0) {
+        return 1;
+    }
+
+    nexrad_message_cache_get_stats(cache, &stats);
+
+    printf("%llu hits, %llu misses, %llu evictions, %zu bodies, %zu bytes\n",
+        (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+        (unsigned long long)stats.evictions, stats.entries, stats.bytes);
+
+    nexrad_message_cache_destroy(cache);
+
+    return 0;
+}
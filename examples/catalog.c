@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include <nexrad/catalog.h>
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s catalog scan dir [threads]\n", argv[0]);
+    fprintf(stderr, "       %s catalog find station code [start end]\n", argv[0]);
+    fprintf(stderr, "       %s catalog latest station code\n", argv[0]);
+    fprintf(stderr, "       %s catalog prune\n", argv[0]);
+    exit(1);
+}
+
+static void print_entry(nexrad_catalog *catalog, const nexrad_catalog_entry *entry) {
+    printf("%s %s %d %lld %lld %llu %llu %s\n",
+        entry->station, entry->product_code, entry->type,
+        (long long)entry->scan_timestamp, (long long)entry->gen_timestamp,
+        (unsigned long long)entry->offset, (unsigned long long)entry->size,
+        nexrad_catalog_entry_path(catalog, entry));
+}
+
+int main(int argc, char **argv) {
+    nexrad_catalog *catalog;
+
+    if (argc < 3) {
+        usage(argc, argv);
+    }
+
+    if ((catalog = nexrad_catalog_open(argv[1])) == NULL) {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        exit(1);
+    }
+
+    if (strcmp(argv[2], "scan") == 0 && argc >= 4) {
+        ssize_t added;
+
+        if ((added = nexrad_catalog_scan(catalog, argv[3], argc > 4? atoi(argv[4]): 1)) < 0) {
+            perror("nexrad_catalog_scan()");
+            exit(1);
+        }
+
+        if (nexrad_catalog_save(catalog, argv[1]) < 0) {
+            perror("nexrad_catalog_save()");
+            exit(1);
+        }
+
+        printf("%zd added, %zu total\n", added, nexrad_catalog_count(catalog));
+    } else if (strcmp(argv[2], "prune") == 0) {
+        ssize_t removed;
+
+        if ((removed = nexrad_catalog_prune(catalog)) < 0) {
+            perror("nexrad_catalog_prune()");
+            exit(1);
+        }
+
+        if (nexrad_catalog_save(catalog, argv[1]) < 0) {
+            perror("nexrad_catalog_save()");
+            exit(1);
+        }
+
+        printf("%zd removed, %zu total\n", removed, nexrad_catalog_count(catalog));
+    } else if (strcmp(argv[2], "find") == 0 && argc >= 5) {
+        const nexrad_catalog_entry *entries;
+        time_t start = argc > 6? atol(argv[5]): INT64_MIN,
+               end   = argc > 6? atol(argv[6]): INT64_MAX;
+        ssize_t count, i;
+
+        if ((count = nexrad_catalog_find(catalog, argv[3], argv[4], start, end, &entries)) < 0) {
+            perror("nexrad_catalog_find()");
+            exit(1);
+        }
+
+        for (i=0; i<count; i++) {
+            print_entry(catalog, &entries[i]);
+        }
+    } else if (strcmp(argv[2], "latest") == 0 && argc >= 5) {
+        const nexrad_catalog_entry *entry;
+
+        if ((entry = nexrad_catalog_find_latest(catalog, argv[3], argv[4])) != NULL) {
+            print_entry(catalog, entry);
+        }
+    } else {
+        usage(argc, argv);
+    }
+
+    nexrad_catalog_close(catalog);
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <nexrad/dedup.h>
+
+/*
+ * Report which of the message files given are duplicates of a message file
+ * given earlier, as an ingest process would upon receiving each in turn.
+ */
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-w window] [-c capacity] file.l3 ...\n", argv[0]);
+    exit(1);
+}
+
+static void *read_file(const char *path, size_t *lenp) {
+    struct stat st;
+    size_t offset = 0;
+    void *buf;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        goto error_fstat;
+    }
+
+    if ((buf = malloc(st.st_size)) == NULL) {
+        goto error_malloc;
+    }
+
+    while (offset < st.st_size) {
+        ssize_t len;
+
+        if ((len = read(fd, (char *)buf + offset, st.st_size - offset)) <= 0) {
+            goto error_read;
+        }
+
+        offset += len;
+    }
+
+    close(fd);
+
+    *lenp = offset;
+
+    return buf;
+
+error_read:
+    free(buf);
+
+error_malloc:
+error_fstat:
+    close(fd);
+
+error_open:
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    nexrad_dedup *dedup;
+    size_t capacity = 65536;
+    time_t window = 3600;
+    int duplicates = 0, c, i;
+
+    while ((c = getopt(argc, argv, "w:c:")) != -1) {
+        switch (c) {
+            case 'w': window   = atol(optarg); break;
+            case 'c': capacity = atol(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argc, argv);
+    }
+
+    if ((dedup = nexrad_dedup_create(capacity, window)) == NULL) {
+        perror("nexrad_dedup_create()");
+        exit(1);
+    }
+
+    for (i=optind; i<argc; i++) {
+        size_t len;
+        void *buf;
+        int ret;
+
+        if ((buf = read_file(argv[i], &len)) == NULL) {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+            continue;
+        }
+
+        if ((ret = nexrad_dedup_check_buf(dedup, buf, len)) < 0) {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+        } else if (ret) {
+            printf("%s: duplicate\n", argv[i]);
+
+            duplicates++;
+        }
+
+        free(buf);
+    }
+
+    printf("%d duplicates\n", duplicates);
+
+    nexrad_dedup_destroy(dedup);
+
+    return 0;
+}
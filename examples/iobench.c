@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+
+/*
+ * Compare the cost of opening message files when read into a buffer retained
+ * by a decoding context, against the cost of mapping them into memory, and
+ * against the automatic choice between the two.  Messages are opened lazily so
+ * that the time measured is dominated by I/O rather than decompression.
+ */
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-n iterations] file.l3 ...\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench(const char *name, enum nexrad_message_io io, int iterations, int count, char **files) {
+    nexrad_message_ctx *ctx;
+    double start, elapsed;
+    int i, f;
+
+    if ((ctx = nexrad_message_ctx_create()) == NULL) {
+        goto error_ctx_create;
+    }
+
+    nexrad_message_ctx_set_flags(ctx, NEXRAD_MESSAGE_LAZY);
+    nexrad_message_ctx_set_io(ctx, io, NEXRAD_MESSAGE_IO_THRESHOLD);
+
+    start = now();
+
+    for (i=0; i<iterations; i++) {
+        for (f=0; f<count; f++) {
+            nexrad_message *message;
+
+            if ((message = nexrad_message_open_ctx(files[f], ctx)) == NULL) {
+                perror(files[f]);
+
+                goto error_message_open;
+            }
+
+            nexrad_message_destroy(message);
+        }
+    }
+
+    elapsed = now() - start;
+
+    printf("%-6s %10.3f us/open\n",
+        name, elapsed * 1e6 / ((double)iterations * count));
+
+    nexrad_message_ctx_destroy(ctx);
+
+    return 0;
+
+error_message_open:
+    nexrad_message_ctx_destroy(ctx);
+
+error_ctx_create:
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    int iterations = 10000, c;
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n': iterations = atoi(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind >= argc || iterations < 1) {
+        usage(argc, argv);
+    }
+
+    if (bench("read", NEXRAD_MESSAGE_IO_READ, iterations, argc - optind, argv + optind) < 0) {
+        return 1;
+    }
+
+    if (bench("mmap", NEXRAD_MESSAGE_IO_MMAP, iterations, argc - optind, argv + optind) < 0) {
+        return 1;
+    }
+
+    if (bench("auto", NEXRAD_MESSAGE_IO_AUTO, iterations, argc - optind, argv + optind) < 0) {
+        return 1;
+    }
+
+    return 0;
+}
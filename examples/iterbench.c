@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+#include <nexrad/radial.h>
+#include <nexrad/raster.h>
+
+/*
+ * Walk every ray and raster line of the product symbology block of each
+ * message given, first with iterators allocated by the library, and then with
+ * caller-owned iterators kept on the stack, which decode without allocating
+ * any memory at all.
+ */
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-n iterations] file.l3 ...\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t walk_open(nexrad_symbology_block *symbology) {
+    nexrad_chunk *block, *layer;
+    size_t count = 0;
+
+    if ((block = nexrad_symbology_block_open(symbology)) == NULL) {
+        return 0;
+    }
+
+    while ((layer = nexrad_symbology_block_read_layer(block)) != NULL) {
+        nexrad_packet *packet;
+        size_t size;
+
+        while ((packet = nexrad_symbology_layer_read_packet(layer, &size)) != NULL) {
+            switch (nexrad_packet_get_type(packet)) {
+                case NEXRAD_PACKET_RADIAL:
+                case NEXRAD_PACKET_RADIAL_AF1F: {
+                    nexrad_radial *radial;
+
+                    if ((radial = nexrad_radial_packet_open((nexrad_radial_packet *)packet)) == NULL) {
+                        break;
+                    }
+
+                    while (nexrad_radial_read_ray(radial, NULL) != NULL) {
+                        count++;
+                    }
+
+                    nexrad_radial_close(radial);
+
+                    break;
+                }
+
+                case NEXRAD_PACKET_RASTER_BA0F:
+                case NEXRAD_PACKET_RASTER_BA07: {
+                    nexrad_raster *raster;
+
+                    if ((raster = nexrad_raster_packet_open((nexrad_raster_packet *)packet)) == NULL) {
+                        break;
+                    }
+
+                    while (nexrad_raster_read_line(raster, NULL, NULL) != NULL) {
+                        count++;
+                    }
+
+                    nexrad_raster_close(raster);
+
+                    break;
+                }
+
+                default: {
+                    break;
+                }
+            }
+        }
+
+        nexrad_symbology_layer_close(layer);
+    }
+
+    nexrad_symbology_block_close(block);
+
+    return count;
+}
+
+static size_t walk_init(nexrad_symbology_block *symbology) {
+    nexrad_chunk block, layer;
+    uint8_t values[NEXRAD_RADIAL_MAX_BINS];
+    size_t count = 0;
+
+    if (nexrad_symbology_block_init(&block, symbology) < 0) {
+        return 0;
+    }
+
+    while (nexrad_symbology_block_read_layer_init(&block, &layer) == 0) {
+        nexrad_packet *packet;
+        size_t size;
+
+        while ((packet = nexrad_symbology_layer_read_packet(&layer, &size)) != NULL) {
+            switch (nexrad_packet_get_type(packet)) {
+                case NEXRAD_PACKET_RADIAL:
+                case NEXRAD_PACKET_RADIAL_AF1F: {
+                    nexrad_radial radial;
+
+                    if (nexrad_radial_init(&radial, (nexrad_radial_packet *)packet, values) < 0) {
+                        break;
+                    }
+
+                    while (nexrad_radial_read_ray(&radial, NULL) != NULL) {
+                        count++;
+                    }
+
+                    break;
+                }
+
+                case NEXRAD_PACKET_RASTER_BA0F:
+                case NEXRAD_PACKET_RASTER_BA07: {
+                    nexrad_raster raster;
+
+                    if (nexrad_raster_init(&raster, (nexrad_raster_packet *)packet) < 0) {
+                        break;
+                    }
+
+                    while (nexrad_raster_read_line(&raster, NULL, NULL) != NULL) {
+                        count++;
+                    }
+
+                    break;
+                }
+
+                default: {
+                    break;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+static void bench(const char *name, size_t (*walk)(nexrad_symbology_block *), nexrad_symbology_block **blocks, int count, int iterations) {
+    double start, elapsed;
+    size_t total = 0;
+    int i, b;
+
+    start = now();
+
+    for (i=0; i<iterations; i++) {
+        for (b=0; b<count; b++) {
+            total += walk(blocks[b]);
+        }
+    }
+
+    elapsed = now() - start;
+
+    printf("%-5s %10.3f us/message, %zu rays and lines\n",
+        name, elapsed * 1e6 / ((double)iterations * count), total / iterations);
+}
+
+int main(int argc, char **argv) {
+    nexrad_message **messages;
+    nexrad_symbology_block **blocks;
+    int iterations = 1000, count = 0, c, i;
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n': iterations = atoi(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind >= argc || iterations < 1) {
+        usage(argc, argv);
+    }
+
+    if ((messages = calloc(argc - optind, sizeof(*messages))) == NULL) {
+        goto error_malloc_messages;
+    }
+
+    if ((blocks = calloc(argc - optind, sizeof(*blocks))) == NULL) {
+        goto error_malloc_blocks;
+    }
+
+    for (i=optind; i<argc; i++) {
+        nexrad_symbology_block *symbology;
+
+        if ((messages[count] = nexrad_message_open(argv[i])) == NULL) {
+            perror(argv[i]);
+            continue;
+        }
+
+        if ((symbology = nexrad_message_get_symbology_block(messages[count])) == NULL) {
+            nexrad_message_destroy(messages[count]);
+            continue;
+        }
+
+        blocks[count++] = symbology;
+    }
+
+    if (count == 0) {
+        goto error_no_messages;
+    }
+
+    bench("open", walk_open, blocks, count, iterations);
+    bench("init", walk_init, blocks, count, iterations);
+
+    for (i=0; i<count; i++) {
+        nexrad_message_destroy(messages[i]);
+    }
+
+    free(blocks);
+    free(messages);
+
+    return 0;
+
+error_no_messages:
+    free(blocks);
+
+error_malloc_blocks:
+    free(messages);
+
+error_malloc_messages:
+    return 1;
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+#include <nexrad/radial.h>
+#include <nexrad/level.h>
+
+/*
+ * Convert every rangebin of the radial product of each message given into
+ * physical units, as single precision floats and as scaled 16-bit integers,
+ * with the library, and with a plain loop over the same table, checking that
+ * the results agree.
+ */
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-n iterations] file.l3 ...\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *unit_name(enum nexrad_level_unit unit) {
+    switch (unit) {
+        case NEXRAD_LEVEL_UNIT_DBZ:    return "dBZ";
+        case NEXRAD_LEVEL_UNIT_M_S:    return "m/s";
+        case NEXRAD_LEVEL_UNIT_KG_M2:  return "kg/m2";
+        case NEXRAD_LEVEL_UNIT_FT:     return "ft";
+        case NEXRAD_LEVEL_UNIT_DB:     return "dB";
+        case NEXRAD_LEVEL_UNIT_RATIO:  return "ratio";
+        case NEXRAD_LEVEL_UNIT_DEG_KM: return "deg/km";
+
+        default: {
+            break;
+        }
+    }
+
+    return "none";
+}
+
+static void bench(const char *path, int iterations) {
+    nexrad_message *message;
+    nexrad_packet *packet;
+    nexrad_radial_grid *grid;
+    nexrad_level_table *table;
+
+    float lut[NEXRAD_LEVEL_TABLE_SIZE], *floats, *expected;
+    int16_t *shorts;
+    size_t count, i, mismatched = 0;
+    double start, plain, library, scaled, valid = 0, sum = 0;
+    int n;
+
+    if ((message = nexrad_message_open(path)) == NULL) {
+        perror(path);
+        return;
+    }
+
+    if ((packet = nexrad_message_find_symbology_packet_by_type(message, NEXRAD_PACKET_RADIAL)) == NULL
+      && (packet = nexrad_message_find_symbology_packet_by_type(message, NEXRAD_PACKET_RADIAL_AF1F)) == NULL) {
+        fprintf(stderr, "%s: No radial packet\n", path);
+        goto error_find_packet;
+    }
+
+    if ((table = nexrad_level_table_create(nexrad_message_get_product_description(message))) == NULL) {
+        perror("nexrad_level_table_create()");
+        goto error_level_table_create;
+    }
+
+    if ((grid = nexrad_radial_packet_resample((nexrad_radial_packet *)packet, 10)) == NULL) {
+        perror("nexrad_radial_packet_resample()");
+        goto error_resample;
+    }
+
+    count = grid->rows * grid->stride;
+
+    floats   = malloc(count * sizeof(float));
+    expected = malloc(count * sizeof(float));
+    shorts   = malloc(count * sizeof(int16_t));
+
+    if (floats == NULL || expected == NULL || shorts == NULL) {
+        perror("malloc()");
+        goto error_malloc;
+    }
+
+    for (i=0; i<NEXRAD_LEVEL_TABLE_SIZE; i++) {
+        lut[i] = nexrad_level_table_get_value(table, i);
+    }
+
+    start = now();
+
+    for (n=0; n<iterations; n++) {
+        for (i=0; i<count; i++) {
+            expected[i] = lut[grid->values[i]];
+        }
+    }
+
+    plain = now() - start;
+    start = now();
+
+    for (n=0; n<iterations; n++) {
+        nexrad_level_decode_float(table, floats, grid->values, count);
+    }
+
+    library = now() - start;
+    start   = now();
+
+    for (n=0; n<iterations; n++) {
+        nexrad_level_decode_int16(table, shorts, grid->values, count);
+    }
+
+    scaled = now() - start;
+
+    for (i=0; i<count; i++) {
+        float value = expected[i], diff;
+        int16_t want;
+
+        if (memcmp(&floats[i], &value, sizeof(value)) != 0) {
+            mismatched++;
+        }
+
+        if (value == NEXRAD_LEVEL_NO_DATA) {
+            want = NEXRAD_LEVEL_INT16_NO_DATA;
+        } else if (value == NEXRAD_LEVEL_RANGE_FOLDED) {
+            want = NEXRAD_LEVEL_INT16_RANGE_FOLDED;
+        } else {
+            want = shorts[i];
+            sum += value;
+            valid++;
+
+            diff = value * nexrad_level_table_get_int16_scale(table) - want;
+
+            if (diff > 1 || diff < -1) {
+                mismatched++;
+            }
+        }
+
+        if (shorts[i] != want) {
+            mismatched++;
+        }
+    }
+
+    printf("%s: %zu values in %s, mean %.2f\n", path, count,
+        unit_name(nexrad_level_table_get_unit(table)), valid? sum / valid: 0.0);
+
+    printf("  plain  %8.3f ns/value\n", plain   * 1e9 / ((double)iterations * count));
+    printf("  float  %8.3f ns/value\n", library * 1e9 / ((double)iterations * count));
+    printf("  int16  %8.3f ns/value, %zu mismatched\n", scaled * 1e9 / ((double)iterations * count), mismatched);
+
+error_malloc:
+    free(shorts);
+    free(expected);
+    free(floats);
+
+    nexrad_radial_grid_destroy(grid);
+
+error_resample:
+    nexrad_level_table_destroy(table);
+
+error_level_table_create:
+error_find_packet:
+    nexrad_message_destroy(message);
+}
+
+int main(int argc, char **argv) {
+    int iterations = 100, c, i;
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n': iterations = atoi(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind >= argc || iterations < 1) {
+        usage(argc, argv);
+    }
+
+    for (i=optind; i<argc; i++) {
+        bench(argv[i], iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <nexrad/message.h>
+
+/*
+ * Print a line of metadata for each product message file given, or for each
+ * file named on standard input, without opening or decompressing any of them.
+ */
+
+static void peek(const char *path) {
+    nexrad_message_info info;
+
+    if (nexrad_message_peek(path, &info) < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+
+        return;
+    }
+
+    printf("%s %s %s %d %u %u %u %ld %ld %zu\n",
+        path, info.station, info.product_code, info.type, info.mode,
+        info.vcp, info.scan, (long)info.scan_timestamp,
+        (long)info.gen_timestamp, info.size);
+}
+
+int main(int argc, char **argv) {
+    int i;
+
+    if (argc > 1) {
+        for (i=1; i<argc; i++) {
+            peek(argv[i]);
+        }
+    } else {
+        char line[4096];
+
+        while (fgets(line, sizeof(line), stdin) != NULL) {
+            line[strcspn(line, "\n")] = '\0';
+
+            peek(line);
+        }
+    }
+
+    return 0;
+}
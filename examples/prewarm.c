@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include <nexrad/catalog.h>
+#include <nexrad/store.h>
+
+/*
+ * Transcode every product in a catalog scanned within a range of dates into a
+ * store of decompressed messages, ahead of those products being read.
+ */
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-b budget] [-s station] [-p code] store catalog start end\n", argv[0]);
+    fprintf(stderr, "\nwhere start and end are given as YYYY-MM-DD[THH:MM:SS] in UTC\n");
+    exit(1);
+}
+
+static int parse_time(const char *text, time_t *timestamp) {
+    struct tm tm;
+    char *end;
+
+    memset(&tm, '\0', sizeof(tm));
+
+    if ((end = strptime(text, "%Y-%m-%d", &tm)) == NULL) {
+        return -1;
+    }
+
+    if (*end == 'T' && (end = strptime(end + 1, "%H:%M:%S", &tm)) == NULL) {
+        return -1;
+    }
+
+    if (*end != '\0') {
+        return -1;
+    }
+
+    *timestamp = timegm(&tm);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    nexrad_message_store *store;
+    nexrad_message_ctx *ctx;
+    nexrad_catalog *catalog;
+    const char *station = NULL, *code = NULL;
+    size_t budget = (size_t)4 << 30, count, i;
+    size_t added = 0, present = 0, failed = 0;
+    time_t start, end;
+    int c;
+
+    while ((c = getopt(argc, argv, "b:s:p:")) != -1) {
+        switch (c) {
+            case 'b': budget  = strtoull(optarg, NULL, 10); break;
+            case 's': station = optarg; break;
+            case 'p': code    = optarg; break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (argc - optind != 4) {
+        usage(argc, argv);
+    }
+
+    if (parse_time(argv[optind+2], &start) < 0 || parse_time(argv[optind+3], &end) < 0) {
+        usage(argc, argv);
+    }
+
+    if ((store = nexrad_message_store_open(argv[optind], budget)) == NULL) {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        exit(1);
+    }
+
+    if ((catalog = nexrad_catalog_open(argv[optind+1])) == NULL) {
+        fprintf(stderr, "%s: %s\n", argv[optind+1], strerror(errno));
+        exit(1);
+    }
+
+    if ((ctx = nexrad_message_ctx_create()) == NULL) {
+        perror("nexrad_message_ctx_create()");
+        exit(1);
+    }
+
+    count = nexrad_catalog_count(catalog);
+
+    for (i=0; i<count; i++) {
+        const nexrad_catalog_entry *entry = nexrad_catalog_get_entry(catalog, i);
+        const char *path;
+
+        /*
+         * Only whole message files may be transcoded; messages held within
+         * spool files or archives are skipped.
+         */
+        if (entry->offset != 0) {
+            continue;
+        }
+
+        if (entry->scan_timestamp < start || entry->scan_timestamp > end) {
+            continue;
+        }
+
+        if ((station && strcmp(entry->station, station) != 0)
+          || (code && strcmp(entry->product_code, code) != 0)) {
+            continue;
+        }
+
+        path = nexrad_catalog_entry_path(catalog, entry);
+
+        switch (nexrad_message_store_add(store, path, ctx)) {
+            case 1:  added++;   break;
+            case 0:  present++; break;
+
+            default: {
+                fprintf(stderr, "%s: %s\n", path, strerror(errno));
+
+                failed++;
+            }
+        }
+    }
+
+    printf("%zu added, %zu already present or uncompressed, %zu failed\n",
+        added, present, failed);
+
+    nexrad_message_ctx_destroy(ctx);
+    nexrad_catalog_close(catalog);
+    nexrad_message_store_close(store);
+
+    return failed? 1: 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "../src/util.h"
+
+#include <nexrad/message.h>
+#include <nexrad/radial.h>
+
+/*
+ * Compare the run length decoding of 0xaf1f radial rays by the library
+ * against a plain reference decoder, expanding one nibble pair at a time, over
+ * a synthetic radial product and the radial products of any messages given.
+ * The output of both is checked to be identical across every rangebin,
+ * including those beyond the end of the runs of each ray.
+ */
+
+#define SYNTHETIC_RAYS 360
+#define SYNTHETIC_BINS 460
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-n iterations] [file.l3 ...]\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static nexrad_radial_ray *reference_read_ray(nexrad_radial_packet *packet, nexrad_radial_ray *ray, uint8_t *values) {
+    uint16_t count = be16toh(ray->size) * 2;
+    uint16_t bins  = be16toh(packet->rangebin_count);
+
+    nexrad_radial_run *runs = (nexrad_radial_run *)(ray + 1);
+
+    uint16_t r, b;
+
+    for (r=0, b=0; r<count; r++) {
+        uint16_t i;
+
+        for (i=0; i<runs[r].length && b<bins; i++, b++) {
+            values[b] = NEXRAD_RADIAL_RLE_FACTOR * runs[r].level;
+        }
+    }
+
+    return (nexrad_radial_ray *)((char *)ray + sizeof(nexrad_radial_ray) + count);
+}
+
+static size_t reference_walk(nexrad_radial_packet *packet, uint8_t *values) {
+    nexrad_radial_ray *ray = (nexrad_radial_ray *)(packet + 1);
+    uint16_t rays = be16toh(packet->rays), i;
+
+    for (i=0; i<rays; i++) {
+        ray = reference_read_ray(packet, ray, values);
+    }
+
+    return rays;
+}
+
+static size_t library_walk(nexrad_radial_packet *packet, uint8_t *values) {
+    nexrad_radial radial;
+    size_t count = 0;
+
+    if (nexrad_radial_init(&radial, packet, values) < 0) {
+        return 0;
+    }
+
+    while (nexrad_radial_read_ray(&radial, NULL) != NULL) {
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * Build a run length encoded radial product of random runs, with each ray
+ * covering a random number of rangebins up to somewhat more than the number
+ * of rangebins in the product, so that some rays run short, and some run
+ * long and must be truncated.
+ */
+static nexrad_radial_packet *synthetic_packet(unsigned int seed) {
+    nexrad_radial_packet *packet;
+    size_t max = sizeof(*packet)
+        + SYNTHETIC_RAYS * (sizeof(nexrad_radial_ray) + SYNTHETIC_BINS + 64);
+    char *p;
+    int i;
+
+    if ((packet = malloc(max)) == NULL) {
+        return NULL;
+    }
+
+    packet->type           = htobe16(NEXRAD_PACKET_RADIAL_AF1F);
+    packet->rangebin_first = htobe16(0);
+    packet->rangebin_count = htobe16(SYNTHETIC_BINS);
+    packet->i              = htobe16(256);
+    packet->j              = htobe16(280);
+    packet->scale          = htobe16(999);
+    packet->rays           = htobe16(SYNTHETIC_RAYS);
+
+    p = (char *)(packet + 1);
+
+    for (i=0; i<SYNTHETIC_RAYS; i++) {
+        nexrad_radial_ray *ray = (nexrad_radial_ray *)p;
+        uint8_t *runs = (uint8_t *)(ray + 1);
+        int want = SYNTHETIC_BINS - 32 + rand_r(&seed) % 64,
+            bins = 0, count = 0;
+
+        while (bins < want) {
+            int length = 1 + rand_r(&seed) % 15,
+                level  = rand_r(&seed) % 16;
+
+            runs[count++] = (length << 4) | level;
+            bins += length;
+        }
+
+        if (count % 2) {
+            runs[count++] = 0;
+        }
+
+        ray->size        = htobe16(count / 2);
+        ray->angle_start = htobe16(i * 10);
+        ray->angle_delta = htobe16(10);
+
+        p += sizeof(nexrad_radial_ray) + count;
+    }
+
+    return packet;
+}
+
+static void bench(const char *name, nexrad_radial_packet *packet, int iterations) {
+    uint8_t expected[NEXRAD_RADIAL_MAX_BINS],
+            actual[NEXRAD_RADIAL_MAX_BINS];
+
+    nexrad_radial radial;
+    nexrad_radial_ray *ray = (nexrad_radial_ray *)(packet + 1);
+    uint16_t bins = be16toh(packet->rangebin_count),
+             rays = be16toh(packet->rays), i;
+
+    size_t total = 0, mismatched = 0;
+    double start, reference, library;
+    int n;
+
+    /*
+     * Start both decoders from the same arbitrary contents, so that any
+     * rangebins left untouched by either are compared as well.
+     */
+    memset(expected, 0xa5, sizeof(expected));
+    memset(actual,   0xa5, sizeof(actual));
+
+    if (nexrad_radial_init(&radial, packet, actual) < 0) {
+        fprintf(stderr, "%s: Invalid radial packet\n", name);
+        return;
+    }
+
+    for (i=0; i<rays; i++) {
+        ray = reference_read_ray(packet, ray, expected);
+
+        if (nexrad_radial_read_ray(&radial, NULL) == NULL) {
+            mismatched++;
+            break;
+        }
+
+        if (memcmp(expected, actual, bins) != 0) {
+            mismatched++;
+        }
+    }
+
+    start = now();
+
+    for (n=0; n<iterations; n++) {
+        total += reference_walk(packet, expected);
+    }
+
+    reference = now() - start;
+    start     = now();
+
+    for (n=0; n<iterations; n++) {
+        total += library_walk(packet, actual);
+    }
+
+    library = now() - start;
+
+    printf("%-24s %4d bins %8.2f ns/ray reference %8.2f ns/ray library %5.2fx, %zu mismatched\n",
+        name, bins,
+        reference * 1e9 / ((double)iterations * rays),
+        library   * 1e9 / ((double)iterations * rays),
+        reference / library, mismatched);
+}
+
+int main(int argc, char **argv) {
+    nexrad_radial_packet *packet;
+    int iterations = 2000, c, i;
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n': iterations = atoi(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (iterations < 1) {
+        usage(argc, argv);
+    }
+
+    if ((packet = synthetic_packet(1)) == NULL) {
+        perror("malloc()");
+        return 1;
+    }
+
+    bench("synthetic", packet, iterations);
+
+    free(packet);
+
+    for (i=optind; i<argc; i++) {
+        nexrad_message *message;
+        nexrad_packet *found;
+
+        if ((message = nexrad_message_open(argv[i])) == NULL) {
+            perror(argv[i]);
+            continue;
+        }
+
+        if ((found = nexrad_message_find_symbology_packet_by_type(message, NEXRAD_PACKET_RADIAL_AF1F)) == NULL) {
+            fprintf(stderr, "%s: No run length encoded radial packet\n", argv[i]);
+        } else {
+            bench(argv[i], (nexrad_radial_packet *)found, iterations);
+        }
+
+        nexrad_message_destroy(message);
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+#include <nexrad/radial.h>
+
+/*
+ * Compare the time taken to obtain the first and last rays of radial products
+ * when opening each message in full and then reading its rays, against
+ * streaming rays from a lazily opened message as they are decompressed.
+ */
+
+struct timing {
+    double start;
+    double first;
+    size_t rays;
+};
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-n iterations] file.l3 ...\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int receive_ray(nexrad_radial *radial, nexrad_radial_ray *ray, uint8_t *values, void *data) {
+    struct timing *timing = data;
+
+    if (timing->rays++ == 0) {
+        timing->first = now() - timing->start;
+    }
+
+    return 0;
+}
+
+static int bench(const char *name, nexrad_message_ctx *ctx, int iterations, int count, char **files) {
+    double first = 0, total = 0;
+    size_t rays = 0;
+    int i, f;
+
+    for (i=0; i<iterations; i++) {
+        for (f=0; f<count; f++) {
+            struct timing timing = { now(), 0, 0 };
+            nexrad_message *message;
+
+            if ((message = nexrad_message_open_ctx(files[f], ctx)) == NULL) {
+                perror(files[f]);
+
+                return -1;
+            }
+
+            if (nexrad_message_stream_rays(message, receive_ray, &timing) < 0) {
+                fprintf(stderr, "%s: No radial packet found\n", files[f]);
+
+                nexrad_message_destroy(message);
+
+                return -1;
+            }
+
+            total += now() - timing.start;
+            first += timing.first;
+            rays  += timing.rays;
+
+            nexrad_message_destroy(message);
+        }
+    }
+
+    printf("%-6s %10.3f us to first ray, %10.3f us to last, %zu rays\n",
+        name,
+        first * 1e6 / ((double)iterations * count),
+        total * 1e6 / ((double)iterations * count),
+        rays / iterations);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    nexrad_message_ctx *ctx;
+    int iterations = 20, c;
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n': iterations = atoi(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind >= argc || iterations < 1) {
+        usage(argc, argv);
+    }
+
+    if ((ctx = nexrad_message_ctx_create()) == NULL) {
+        perror("nexrad_message_ctx_create()");
+        return 1;
+    }
+
+    if (bench("full", ctx, iterations, argc - optind, argv + optind) < 0) {
+        goto error_bench;
+    }
+
+    nexrad_message_ctx_set_flags(ctx, NEXRAD_MESSAGE_LAZY);
+
+    if (bench("stream", ctx, iterations, argc - optind, argv + optind) < 0) {
+        goto error_bench;
+    }
+
+    nexrad_message_ctx_destroy(ctx);
+
+    return 0;
+
+error_bench:
+    nexrad_message_ctx_destroy(ctx);
+
+    return 1;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+#include <nexrad/radial.h>
+
+/*
+ * Open each message given from memory, index its packets and read every ray
+ * of its radial product, first with the usual validation of every header,
+ * block and packet, and then with NEXRAD_MESSAGE_TRUSTED set, as would be
+ * done for an archive of messages already validated upon ingest.
+ */
+
+struct corpus {
+    void ** bufs;
+    size_t * lens;
+    int      count;
+};
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-n iterations] file.l3 ...\n", argv[0]);
+    exit(1);
+}
+
+static double now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *slurp(const char *path, size_t *lenp) {
+    FILE *fh;
+    void *buf;
+    long len;
+
+    if ((fh = fopen(path, "r")) == NULL) {
+        goto error_fopen;
+    }
+
+    if (fseek(fh, 0, SEEK_END) < 0 || (len = ftell(fh)) <= 0) {
+        goto error_size;
+    }
+
+    rewind(fh);
+
+    if ((buf = malloc(len)) == NULL) {
+        goto error_malloc;
+    }
+
+    if (fread(buf, 1, len, fh) != (size_t)len) {
+        goto error_fread;
+    }
+
+    fclose(fh);
+
+    *lenp = len;
+
+    return buf;
+
+error_fread:
+    free(buf);
+
+error_malloc:
+error_size:
+    fclose(fh);
+
+error_fopen:
+    return NULL;
+}
+
+static int count_ray(nexrad_radial *radial, nexrad_radial_ray *ray, uint8_t *values, void *data) {
+    (*(size_t *)data)++;
+
+    return 0;
+}
+
+static void bench(const char *name, int flags, struct corpus *corpus, int iterations) {
+    nexrad_message_ctx *ctx;
+    double start, elapsed;
+    size_t rays = 0, failed = 0;
+    int i, m;
+
+    if ((ctx = nexrad_message_ctx_create()) == NULL) {
+        perror("nexrad_message_ctx_create()");
+        exit(1);
+    }
+
+    nexrad_message_ctx_set_flags(ctx, flags);
+
+    start = now();
+
+    for (i=0; i<iterations; i++) {
+        for (m=0; m<corpus->count; m++) {
+            const nexrad_packet_entry *entries;
+            nexrad_message *message;
+
+            if ((message = nexrad_message_open_buf_ctx(corpus->bufs[m], corpus->lens[m], ctx)) == NULL) {
+                failed++;
+                continue;
+            }
+
+            if (nexrad_message_get_packet_entries(message, &entries) < 0
+              || nexrad_message_stream_rays(message, count_ray, &rays) < 0) {
+                failed++;
+            }
+
+            nexrad_message_destroy(message);
+        }
+    }
+
+    elapsed = now() - start;
+
+    printf("%-7s %10.3f us/message, %zu rays, %zu failed\n",
+        name, elapsed * 1e6 / ((double)iterations * corpus->count),
+        rays / iterations, failed / iterations);
+
+    nexrad_message_ctx_destroy(ctx);
+}
+
+int main(int argc, char **argv) {
+    struct corpus corpus;
+    int iterations = 100, c, i;
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n': iterations = atoi(optarg); break;
+            default: usage(argc, argv);
+        }
+    }
+
+    if (optind >= argc || iterations < 1) {
+        usage(argc, argv);
+    }
+
+    corpus.count = 0;
+
+    if ((corpus.bufs = calloc(argc - optind, sizeof(*corpus.bufs))) == NULL) {
+        goto error_malloc_bufs;
+    }
+
+    if ((corpus.lens = calloc(argc - optind, sizeof(*corpus.lens))) == NULL) {
+        goto error_malloc_lens;
+    }
+
+    for (i=optind; i<argc; i++) {
+        if ((corpus.bufs[corpus.count] = slurp(argv[i], &corpus.lens[corpus.count])) == NULL) {
+            perror(argv[i]);
+            continue;
+        }
+
+        corpus.count++;
+    }
+
+    if (corpus.count == 0) {
+        goto error_no_messages;
+    }
+
+    bench("checked", 0, &corpus, iterations);
+    bench("trusted", NEXRAD_MESSAGE_TRUSTED, &corpus, iterations);
+
+    for (i=0; i<corpus.count; i++) {
+        free(corpus.bufs[i]);
+    }
+
+    free(corpus.lens);
+    free(corpus.bufs);
+
+    return 0;
+
+error_no_messages:
+    free(corpus.lens);
+
+error_malloc_lens:
+    free(corpus.bufs);
+
+error_malloc_bufs:
+    return 1;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <nexrad/message.h>
+#include <nexrad/wrapped.h>
+
+/*
+ * Print a line for each product message within the files given, each of
+ * which may be a message file, optionally gzip or bzip2 compressed, or with
+ * -t, a tar file of such messages, itself optionally compressed.
+ */
+
+static void usage(int argc, char **argv) {
+    fprintf(stderr, "usage: %s [-t] file ...\n", argv[0]);
+    exit(1);
+}
+
+static void show(const char *name, nexrad_message *message) {
+    char station[8];
+
+    if (nexrad_message_read_station(message, station, sizeof(station)) < 0) {
+        strcpy(station, "?");
+    }
+
+    printf("%s %s %d %ld\n",
+        name, station, nexrad_message_get_product_type(message),
+        (long)nexrad_message_get_scan_timestamp(message));
+}
+
+static int list_tar(const char *path, nexrad_message_ctx *ctx) {
+    nexrad_message_tar *tar;
+    nexrad_message *message;
+    const char *name;
+    int ret;
+
+    if ((tar = nexrad_message_tar_open(path, ctx)) == NULL) {
+        goto error_tar_open;
+    }
+
+    while ((ret = nexrad_message_tar_read(tar, &message, &name)) > 0) {
+        show(name, message);
+
+        nexrad_message_destroy(message);
+    }
+
+    nexrad_message_tar_close(tar);
+
+    return ret;
+
+error_tar_open:
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    nexrad_message_ctx *ctx;
+    int i, tar = 0, ret = 0;
+
+    if (argc > 1 && strcmp(argv[1], "-t") == 0) {
+        tar = 1;
+    }
+
+    if (argc < 2 + tar) {
+        usage(argc, argv);
+    }
+
+    if ((ctx = nexrad_message_ctx_create()) == NULL) {
+        perror("nexrad_message_ctx_create()");
+        return 1;
+    }
+
+    for (i=1+tar; i<argc; i++) {
+        nexrad_message *message;
+
+        if (tar) {
+            if (list_tar(argv[i], ctx) < 0) {
+                fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+
+                ret = 1;
+            }
+
+            continue;
+        }
+
+        if ((message = nexrad_message_open_wrapped_ctx(argv[i], ctx)) == NULL) {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+
+            ret = 1;
+
+            continue;
+        }
+
+        show(argv[i], message);
+
+        nexrad_message_destroy(message);
+    }
+
+    nexrad_message_ctx_destroy(ctx);
+
+    return ret;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_ARCHIVE_H
+#define _NEXRAD_ARCHIVE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+#include <nexrad/catalog.h>
+
+#define NEXRAD_ARCHIVE_PAGE_SIZE 4096
+
+/*!
+ * \file nexrad/archive.h
+ * \brief Single-file containers of many NEXRAD Level III product messages
+ *
+ * An interface for writing many NEXRAD Level III product messages into a
+ * single archive file, followed by a catalog of its contents, and for
+ * querying and opening the messages within an archive directly from its
+ * mapping in memory.
+ */
+
+typedef struct _nexrad_archive_writer nexrad_archive_writer;
+
+typedef struct _nexrad_archive nexrad_archive;
+
+enum nexrad_archive_flags {
+    NEXRAD_ARCHIVE_ALIGN = (1 << 0) /* Start each message on a page boundary */
+};
+
+/*!
+ * \defgroup archive NEXRAD Level III product message archive routines
+ */
+
+/*!
+ * \ingroup archive
+ * \brief Create a new archive file
+ * \param path A path at which to create the archive
+ * \param flags A bitwise OR of values from `enum nexrad_archive_flags`
+ * \return An archive writer, or NULL on failure
+ *
+ * Begin writing an archive.  The archive is written to a temporary file
+ * alongside `path`, and only renamed into place once completed with
+ * nexrad_archive_writer_close().  With `NEXRAD_ARCHIVE_ALIGN`, each message
+ * begins at a multiple of `NEXRAD_ARCHIVE_PAGE_SIZE` bytes into the archive.
+ */
+nexrad_archive_writer *nexrad_archive_writer_create(const char *path, int flags);
+
+/*!
+ * \ingroup archive
+ * \brief Add a product message in memory to an archive
+ * \param writer An archive writer
+ * \param name A name by which to record the message, such as its file name
+ * \param buf Pointer to the message, as it would be stored in a file
+ * \param len Size of the message in `buf`
+ * \return 0 on success, -1 on failure
+ *
+ * Validate the headers of the message in `buf`, and append it unchanged to
+ * the archive.  Should the message fail to be written, the writer refuses any
+ * further messages, and nexrad_archive_writer_close() fails.
+ */
+int nexrad_archive_writer_add_buf(nexrad_archive_writer *writer,
+    const char *name,
+    const void *buf,
+    size_t len
+);
+
+/*!
+ * \ingroup archive
+ * \brief Add a product message file to an archive
+ * \param writer An archive writer
+ * \param path A path to a product message file, by which it is also recorded
+ * \return 0 on success, -1 on failure
+ */
+int nexrad_archive_writer_add_file(nexrad_archive_writer *writer,
+    const char *path
+);
+
+/*!
+ * \ingroup archive
+ * \brief Complete an archive
+ * \param writer An archive writer
+ * \return 0 on success, -1 on failure
+ *
+ * Write the catalog of the messages added, rename the archive into place, and
+ * destroy the writer.  On failure, the temporary file is removed, and the
+ * writer is destroyed all the same.
+ */
+int nexrad_archive_writer_close(nexrad_archive_writer *writer);
+
+/*!
+ * \ingroup archive
+ * \brief Abandon an archive
+ * \param writer An archive writer
+ *
+ * Remove the temporary file of an incomplete archive, and destroy the writer.
+ */
+void nexrad_archive_writer_abort(nexrad_archive_writer *writer);
+
+/*!
+ * \ingroup archive
+ * \brief Open an archive file
+ * \param path A path to an archive file
+ * \return An archive object, or NULL on failure
+ *
+ * Map an archive into memory in its entirety.
+ */
+nexrad_archive *nexrad_archive_open(const char *path);
+
+/*!
+ * \ingroup archive
+ * \brief Obtain the catalog of messages in an archive
+ * \param archive An archive object
+ * \return The catalog of the archive, or NULL on failure
+ *
+ * Obtain the catalog of the archive, which may be queried with
+ * nexrad_catalog_find() and similar functions.  The path of each entry is the
+ * name given when the message was added; its offset is that of the message
+ * within the archive.  The catalog belongs to the archive, and must not be
+ * closed by the caller.
+ */
+nexrad_catalog *nexrad_archive_get_catalog(nexrad_archive *archive);
+
+/*!
+ * \ingroup archive
+ * \brief Open a message within an archive
+ * \param archive An archive object
+ * \param entry A catalog entry obtained from the catalog of `archive`
+ * \param ctx A decoding context, or NULL
+ * \return An object representing the message, or NULL on failure
+ *
+ * Open a message in place with nexrad_message_open_buf_ctx(), such that it
+ * refers to the mapping of the archive without copying.  Any messages opened
+ * must be closed before the archive itself.
+ */
+nexrad_message *nexrad_archive_open_message(nexrad_archive *archive,
+    const nexrad_catalog_entry *entry,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup archive
+ * \brief Close an archive
+ * \param archive An archive object
+ */
+void nexrad_archive_close(nexrad_archive *archive);
+
+#endif /* _NEXRAD_ARCHIVE_H */
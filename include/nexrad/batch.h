@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_BATCH_H
+#define _NEXRAD_BATCH_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <nexrad/message.h>
+
+#define NEXRAD_MESSAGE_BATCH_DEFAULT_DEPTH 64
+
+/*!
+ * \file nexrad/batch.h
+ * \brief Opening of NEXRAD Level III product message files in bulk
+ *
+ * An interface for opening large numbers of NEXRAD Level III product message
+ * files at once, keeping many opens and reads in flight through io_uring
+ * where available, or on a pool of threads performing blocking reads
+ * otherwise.
+ */
+
+typedef struct _nexrad_message_batch nexrad_message_batch;
+
+enum nexrad_message_batch_backend {
+    NEXRAD_MESSAGE_BATCH_AUTO     = 0, /* io_uring if available, else threads */
+    NEXRAD_MESSAGE_BATCH_IO_URING = 1, /* Submit I/O through io_uring */
+    NEXRAD_MESSAGE_BATCH_THREADS  = 2  /* Perform blocking I/O on threads */
+};
+
+/*!
+ * \ingroup batch
+ * \brief Function called upon completion of each file in a batch
+ * \param message The message opened, or NULL if the file could not be opened
+ * \param path The path to the file, as passed to the batch
+ * \param index The index of `path` within the list of paths
+ * \param error 0 if `message` was opened, or otherwise an errno value
+ *        indicating why the file could not be opened
+ * \param data The opaque pointer passed to the batch
+ *
+ * The callback receives ownership of `message`, and must close it with
+ * nexrad_message_destroy() once finished with it.  Files complete in no
+ * particular order.
+ */
+typedef void (*nexrad_message_batch_callback)(nexrad_message *message,
+    const char *path,
+    size_t index,
+    int error,
+    void *data
+);
+
+/*!
+ * \defgroup batch NEXRAD Level III bulk product message file opening routines
+ */
+
+/*!
+ * \ingroup batch
+ * \brief Create an object for opening product message files in bulk
+ * \param ctx A decoding context, or NULL
+ * \param backend The means by which to perform I/O
+ * \param depth The maximum number of files to have in flight at once, or 0
+ *        for `NEXRAD_MESSAGE_BATCH_DEFAULT_DEPTH`
+ * \return A new batch object, or NULL on failure
+ *
+ * Create an object for opening many files at once.  With
+ * `NEXRAD_MESSAGE_BATCH_AUTO`, io_uring is used if the running kernel
+ * supports every operation needed, and otherwise `depth` threads are
+ * started for each batch to perform blocking reads.  Requesting
+ * `NEXRAD_MESSAGE_BATCH_IO_URING` where it is unavailable fails with
+ * `ENOSYS`.  Messages are indexed, and decompressed, with the flags of and
+ * buffers lent by `ctx`.
+ */
+nexrad_message_batch *nexrad_message_batch_create(nexrad_message_ctx *ctx,
+    enum nexrad_message_batch_backend backend,
+    int depth
+);
+
+/*!
+ * \ingroup batch
+ * \brief Obtain the means by which a batch object performs I/O
+ * \param batch A batch object
+ * \return `NEXRAD_MESSAGE_BATCH_IO_URING` or `NEXRAD_MESSAGE_BATCH_THREADS`
+ */
+enum nexrad_message_batch_backend nexrad_message_batch_get_backend(nexrad_message_batch *batch);
+
+/*!
+ * \ingroup batch
+ * \brief Open a list of product message files
+ * \param batch A batch object
+ * \param paths A list of paths to product message files
+ * \param count The number of paths in `paths`
+ * \param callback Function to call upon completion of each file
+ * \param data An opaque pointer passed to `callback`
+ * \return The number of messages successfully opened, or -1 on failure
+ *
+ * Open every file in `paths`, calling `callback` once for each.  Whichever
+ * backend is used, indexing and decompression of messages, and every call to
+ * `callback`, take place on the calling thread, while further files are read
+ * in the background.  Returns once every file has been processed.  Should
+ * the backend fail partway through, `callback` is still called once for
+ * every file, with an error for each file not opened.
+ */
+ssize_t nexrad_message_batch_open(nexrad_message_batch *batch,
+    const char **paths,
+    size_t count,
+    nexrad_message_batch_callback callback,
+    void *data
+);
+
+/*!
+ * \ingroup batch
+ * \brief Open a list of product message files relative to a directory
+ * \param batch A batch object
+ * \param dirfd A file descriptor referring to a directory, or `AT_FDCWD`
+ * \param paths A list of paths to product message files, relative to `dirfd`
+ * \param count The number of paths in `paths`
+ * \param callback Function to call upon completion of each file
+ * \param data An opaque pointer passed to `callback`
+ * \return The number of messages successfully opened, or -1 on failure
+ *
+ * Like nexrad_message_batch_open(), but resolves relative paths against the
+ * directory `dirfd` as per openat(2).
+ */
+ssize_t nexrad_message_batch_openat(nexrad_message_batch *batch,
+    int dirfd,
+    const char **paths,
+    size_t count,
+    nexrad_message_batch_callback callback,
+    void *data
+);
+
+/*!
+ * \ingroup batch
+ * \brief Destroy a batch object
+ * \param batch A batch object
+ */
+void nexrad_message_batch_destroy(nexrad_message_batch *batch);
+
+#endif /* _NEXRAD_BATCH_H */
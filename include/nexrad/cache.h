@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_CACHE_H
+#define _NEXRAD_CACHE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <nexrad/message.h>
+
+/*!
+ * \file nexrad/cache.h
+ * \brief Shared cache of decompressed NEXRAD Level III message bodies
+ *
+ * A thread-safe cache of decompressed product message bodies, which may be
+ * shared between decoding contexts in any number of threads, so that a
+ * product opened by many consumers in quick succession is only decompressed
+ * once.
+ */
+
+typedef struct _nexrad_message_cache nexrad_message_cache;
+
+typedef struct _nexrad_message_cache_stats {
+    uint64_t hits;      /* Bodies found in the cache */
+    uint64_t misses;    /* Bodies decompressed and added to the cache */
+    uint64_t evictions; /* Bodies evicted to remain within budget */
+    size_t   entries;   /* Bodies presently cached */
+    size_t   bytes;     /* Total size of bodies presently cached, and their keys */
+    size_t   budget;    /* Maximum total size of bodies cached, and their keys */
+} nexrad_message_cache_stats;
+
+/*!
+ * \defgroup cache NEXRAD Level III message body cache routines
+ */
+
+/*!
+ * \ingroup cache
+ * \brief Create a cache of decompressed message bodies
+ * \param budget The maximum total size, in bytes, of bodies to retain
+ * \return A new cache, or NULL on failure
+ *
+ * Create a cache of decompressed message bodies, keyed by the contents of the
+ * compressed bodies from which they were produced, which are kept alongside
+ * them and compared in full upon each lookup.  Once the total size of cached
+ * bodies, and of the compressed bodies kept as their keys, exceeds `budget`,
+ * the least recently used bodies are evicted;
+ * bodies still in use by open messages are freed once the last such message
+ * is destroyed.
+ *
+ * A cache is attached to any number of decoding contexts with
+ * nexrad_message_ctx_set_cache(), and may be shared between threads.
+ */
+nexrad_message_cache *nexrad_message_cache_create(size_t budget);
+
+/*!
+ * \ingroup cache
+ * \brief Attach a body cache to a decoding context
+ * \param ctx A decoding context
+ * \param cache A body cache, or NULL to detach any cache from `ctx`
+ * \return 0 on success, -1 on failure
+ *
+ * Cause compressed messages opened with `ctx` to obtain their bodies from
+ * `cache`, decompressing and adding them to the cache upon a miss.  When
+ * another thread is decompressing the same body, the caller waits for that
+ * body rather than decompressing it again.
+ */
+int nexrad_message_ctx_set_cache(nexrad_message_ctx *ctx, nexrad_message_cache *cache);
+
+/*!
+ * \ingroup cache
+ * \brief Obtain statistics about the usage of a body cache
+ * \param cache A body cache
+ * \param stats Structure to which statistics are written
+ */
+void nexrad_message_cache_get_stats(nexrad_message_cache *cache,
+    nexrad_message_cache_stats *stats
+);
+
+/*!
+ * \ingroup cache
+ * \brief Destroy a body cache
+ * \param cache A body cache
+ *
+ * Free every body held by a cache.  A cache must outlive every decoding
+ * context to which it is attached, and every message opened with those
+ * contexts.
+ */
+void nexrad_message_cache_destroy(nexrad_message_cache *cache);
+
+#endif /* _NEXRAD_CACHE_H */
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_CATALOG_H
+#define _NEXRAD_CATALOG_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <nexrad/message.h>
+
+/*!
+ * \file nexrad/catalog.h
+ * \brief Persistent index of NEXRAD Level III product message files
+ *
+ * An interface for building, updating and querying an index of the NEXRAD
+ * Level III product message files within a directory tree, keyed by station,
+ * product code and scan time.  The index is stored as a single file which is
+ * mapped into memory as-is, such that queries may be answered by binary
+ * search without reading or opening any product files.
+ */
+
+typedef struct _nexrad_catalog nexrad_catalog;
+
+#pragma pack(push)
+#pragma pack(1)
+
+typedef struct _nexrad_catalog_entry {
+    char     station[5];      /* WSR-88D station identifier, such as KTLX */
+    char     product_code[4]; /* WMO product code, such as N0Q */
+    uint8_t  _padding[3];
+     int32_t type;            /* Product type code */
+     int64_t scan_timestamp;  /* Start of scan */
+     int64_t gen_timestamp;   /* Time of product generation */
+    uint64_t offset;          /* Offset of message within file */
+    uint64_t size;            /* Size of message from message header onward */
+    uint32_t path;            /* Offset of path within catalog string table */
+    uint32_t _reserved;
+} nexrad_catalog_entry;
+
+#pragma pack(pop)
+
+/*!
+ * \defgroup catalog NEXRAD Level III product message catalog routines
+ */
+
+/*!
+ * \ingroup catalog
+ * \brief Open a catalog file
+ * \param path A path to a catalog file, which need not yet exist
+ * \return A catalog object, or NULL on failure
+ *
+ * Map an existing catalog file into memory, or create an empty catalog if no
+ * file exists at `path`.  Changes made to the catalog are held in memory
+ * until written with nexrad_catalog_save().  A catalog is not safe to use
+ * from multiple threads at once.
+ */
+nexrad_catalog *nexrad_catalog_open(const char *path);
+
+/*!
+ * \ingroup catalog
+ * \brief Add every product message file within a directory tree to a catalog
+ * \param catalog A catalog object
+ * \param dir A path to a directory
+ * \param threads Number of threads with which to read files
+ * \return The number of files added, or -1 on failure
+ *
+ * Walk the directory tree at `dir`, reading the headers of every file not
+ * already in the catalog with nexrad_message_peek() on up to `threads`
+ * threads, and adding those which are valid product messages.  As files
+ * already in the catalog are skipped without being read, this may be called
+ * repeatedly to pick up new files as they appear.  Files whose names start
+ * with a period are ignored.
+ */
+ssize_t nexrad_catalog_scan(nexrad_catalog *catalog,
+    const char *dir,
+    int threads
+);
+
+/*!
+ * \ingroup catalog
+ * \brief Add a single product message file to a catalog
+ * \param catalog A catalog object
+ * \param path A path to a product message file
+ * \return 1 if the file was added, 0 if it was already present, or -1 on
+ *         failure
+ */
+int nexrad_catalog_add(nexrad_catalog *catalog, const char *path);
+
+/*!
+ * \ingroup catalog
+ * \brief Add a product message with known metadata to a catalog
+ * \param catalog A catalog object
+ * \param path A path to the file containing the message
+ * \param offset Offset of the message within the file
+ * \param info Metadata of the message, as from nexrad_message_peek_buf()
+ * \return 1 if the message was added, 0 if it was already present, or -1 on
+ *         failure
+ *
+ * Add a message to the catalog without reading it, as is useful for messages
+ * held within spool or archive files at offsets other than zero.
+ */
+int nexrad_catalog_add_info(nexrad_catalog *catalog,
+    const char *path,
+    uint64_t offset,
+    nexrad_message_info *info
+);
+
+/*!
+ * \ingroup catalog
+ * \brief Remove entries for files which no longer exist
+ * \param catalog A catalog object
+ * \return The number of entries removed, or -1 on failure
+ */
+ssize_t nexrad_catalog_prune(nexrad_catalog *catalog);
+
+/*!
+ * \ingroup catalog
+ * \brief Write a catalog to disk
+ * \param catalog A catalog object
+ * \param path A path to write the catalog file to
+ * \return 0 on success, -1 on failure
+ *
+ * Write the catalog to a temporary file alongside `path`, and rename it into
+ * place, such that readers of `path` see either the old or new catalog in
+ * its entirety.
+ */
+int nexrad_catalog_save(nexrad_catalog *catalog, const char *path);
+
+/*!
+ * \ingroup catalog
+ * \brief Obtain the number of entries in a catalog
+ * \param catalog A catalog object
+ * \return The number of entries in the catalog
+ */
+size_t nexrad_catalog_count(nexrad_catalog *catalog);
+
+/*!
+ * \ingroup catalog
+ * \brief Obtain a catalog entry by position
+ * \param catalog A catalog object
+ * \param i Index of the entry, less than nexrad_catalog_count()
+ * \return The entry at position `i` in sorted order, or NULL if out of range
+ *
+ * The pointer returned remains valid until the catalog is next modified or
+ * closed.
+ */
+const nexrad_catalog_entry *nexrad_catalog_get_entry(nexrad_catalog *catalog,
+    size_t i
+);
+
+/*!
+ * \ingroup catalog
+ * \brief Find catalog entries for a station and product within a time range
+ * \param catalog A catalog object
+ * \param station A WSR-88D station identifier, such as KTLX
+ * \param product_code A WMO product code, such as N0Q
+ * \param start Earliest scan time to find, inclusive
+ * \param end Latest scan time to find, inclusive
+ * \param entries Pointer to an entry pointer to store the first entry found
+ * \return The number of entries found, or -1 on failure
+ *
+ * Find every entry for the product given with a scan time between `start` and
+ * `end`.  The entries found are stored contiguously in order of scan time,
+ * then generation time; the pointer returned in `entries` remains valid
+ * until the catalog is next modified or closed.
+ */
+ssize_t nexrad_catalog_find(nexrad_catalog *catalog,
+    const char *station,
+    const char *product_code,
+    time_t start,
+    time_t end,
+    const nexrad_catalog_entry **entries
+);
+
+/*!
+ * \ingroup catalog
+ * \brief Find the most recent catalog entry for a station and product
+ * \param catalog A catalog object
+ * \param station A WSR-88D station identifier, such as KTLX
+ * \param product_code A WMO product code, such as N0Q
+ * \return The entry with the latest scan time, or NULL if none was found
+ */
+const nexrad_catalog_entry *nexrad_catalog_find_latest(nexrad_catalog *catalog,
+    const char *station,
+    const char *product_code
+);
+
+/*!
+ * \ingroup catalog
+ * \brief Obtain the path of the file referred to by a catalog entry
+ * \param catalog A catalog object
+ * \param entry An entry within the catalog
+ * \return The path of the file containing the message
+ */
+const char *nexrad_catalog_entry_path(nexrad_catalog *catalog,
+    const nexrad_catalog_entry *entry
+);
+
+/*!
+ * \ingroup catalog
+ * \brief Close a catalog
+ * \param catalog A catalog object
+ *
+ * Close a catalog, discarding any changes not written with
+ * nexrad_catalog_save().
+ */
+void nexrad_catalog_close(nexrad_catalog *catalog);
+
+#endif /* _NEXRAD_CATALOG_H */
@@ -38,13 +38,34 @@ enum nexrad_chunk_type {
     NEXRAD_CHUNK_GRAPHIC_PACKET
 };
 
-typedef struct _nexrad_chunk nexrad_chunk;
+/*
+ * Iterator state is public so that callers may keep iterators on the stack or
+ * in an arena of their own, using nexrad_chunk_init() in lieu of
+ * nexrad_chunk_open().
+ */
+typedef struct _nexrad_chunk {
+    enum nexrad_chunk_type type;
+
+    void * current;    /* The current chunk within the parent block */
+    size_t bytes_left; /* Number of bytes left in parent block */
+} nexrad_chunk;
 
 /*
  * Generic interface for reading radar product data chunks
  */
 nexrad_chunk *nexrad_chunk_open(void *chunk, enum nexrad_chunk_type type);
 
+/*
+ * Prepare the caller-owned iterator in `iterator` to read the children of the
+ * chunk given, without allocating any memory.  Returns 0 on success, or -1 if
+ * the chunk is invalid.  Iterators so prepared must not be passed to
+ * nexrad_chunk_close().
+ */
+int nexrad_chunk_init(nexrad_chunk *iterator,
+    void *chunk,
+    enum nexrad_chunk_type type
+);
+
 void *nexrad_chunk_peek(nexrad_chunk *iterator,
     size_t *size,
     size_t *payload,
@@ -63,6 +84,16 @@ nexrad_chunk *nexrad_chunk_read_block_layer(nexrad_chunk *block,
     enum nexrad_chunk_type type
 );
 
+/*
+ * Read the next child of `block`, and prepare the caller-owned iterator in
+ * `layer` to read the children thereof.  Returns 0 on success, or -1 when no
+ * valid children are left in `block`.
+ */
+int nexrad_chunk_read_block_layer_init(nexrad_chunk *block,
+    nexrad_chunk *layer,
+    enum nexrad_chunk_type type
+);
+
 void nexrad_chunk_close(nexrad_chunk *iterator);
 
 #endif /* _NEXRAD_CHUNK_H */
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_DEDUP_H
+#define _NEXRAD_DEDUP_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+/*!
+ * \file nexrad/dedup.h
+ * \brief Detection of duplicate NEXRAD Level III product messages
+ *
+ * A concurrent set of recently seen product messages, allowing duplicate
+ * deliveries of a product to be rejected at ingest, before any decompression
+ * or further processing takes place.
+ */
+
+typedef struct _nexrad_dedup nexrad_dedup;
+
+/*!
+ * \defgroup dedup NEXRAD Level III duplicate product detection routines
+ */
+
+/*!
+ * \ingroup dedup
+ * \brief Create a set of recently seen product messages
+ * \param capacity The number of distinct messages to track at once
+ * \param window The number of seconds for which a message is remembered
+ * \return A new set, or NULL on failure
+ *
+ * Create a set in which each message seen is remembered for `window` seconds
+ * following the last time it was seen.  `capacity` is rounded up to a power of
+ * two, and should comfortably exceed the number of distinct messages expected
+ * within any one window; should the set become too crowded to record a new
+ * message, that message is reported as new, but not remembered.
+ *
+ * A set may be shared between any number of threads without locking.
+ */
+nexrad_dedup *nexrad_dedup_create(size_t capacity, time_t window);
+
+/*!
+ * \ingroup dedup
+ * \brief Check whether a product message has been seen recently
+ * \param dedup A set of recently seen product messages
+ * \param buf Pointer to a message, as it would be stored in a file
+ * \param len Size of the message in `buf`
+ * \return 1 if the message is a duplicate, 0 if the message is new, or -1 if
+ *         the message headers are invalid
+ *
+ * Identify a message by its station, product code, scan time, sequence number
+ * and generation time, along with a 64-bit hash of the message from its
+ * message header onward, and record it as seen.  The unknown and WMO headers
+ * are excluded, as these may differ between deliveries of one product by way
+ * of different uplinks.  Only the message headers are validated, and the body
+ * of the message is never decompressed.
+ */
+int nexrad_dedup_check_buf(nexrad_dedup *dedup, const void *buf, size_t len);
+
+/*!
+ * \ingroup dedup
+ * \brief Destroy a set of recently seen product messages
+ * \param dedup A set of recently seen product messages
+ */
+void nexrad_dedup_destroy(nexrad_dedup *dedup);
+
+#endif /* _NEXRAD_DEDUP_H */
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_FEED_H
+#define _NEXRAD_FEED_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <nexrad/header.h>
+#include <nexrad/product.h>
+#include <nexrad/message.h>
+
+/*!
+ * \file nexrad/feed.h
+ * \brief Incremental parsing of NEXRAD Level III product messages
+ *
+ * An interface for parsing NEXRAD Level III product messages as they arrive
+ * in arbitrarily sized pieces, such as from a socket, decompressing message
+ * bodies as compressed data arrives rather than once the entire message has
+ * been received.
+ */
+
+typedef struct _nexrad_message_feed nexrad_message_feed;
+
+enum nexrad_message_feed_state {
+    NEXRAD_MESSAGE_FEED_ERROR       = -1, /* Message was invalid, and dropped */
+    NEXRAD_MESSAGE_FEED_NONE        =  0, /* Awaiting start of a message */
+    NEXRAD_MESSAGE_FEED_HEADER      =  1, /* WMO and message headers available */
+    NEXRAD_MESSAGE_FEED_DESCRIPTION =  2, /* Product description available */
+    NEXRAD_MESSAGE_FEED_COMPLETE    =  3  /* Entire message available */
+};
+
+/*!
+ * \defgroup feed NEXRAD Level III incremental product message parsing routines
+ */
+
+/*!
+ * \ingroup feed
+ * \brief Create an incremental product message parser
+ * \param ctx A decoding context, or NULL
+ * \return A new incremental parser, or NULL on failure
+ *
+ * Create an incremental parser for NEXRAD Level III product messages.  Any
+ * number of messages may be pushed through the parser back to back; data
+ * between messages, such as the unknown footer, is skipped.  Messages are
+ * opened with the flags of, and decompressed into buffers lent by, `ctx`.
+ */
+nexrad_message_feed *nexrad_message_feed_create(nexrad_message_ctx *ctx);
+
+/*!
+ * \ingroup feed
+ * \brief Push data into an incremental product message parser
+ * \param feed An incremental parser
+ * \param buf Pointer to data received
+ * \param len Size of data in `buf`
+ * \return The state of the parser after handling the data pushed
+ *
+ * Push a piece of a product message stream of any size into the parser.  The
+ * data is copied, and parsed as far as possible; compressed message bodies
+ * are decompressed as their data arrives.  Once `NEXRAD_MESSAGE_FEED_COMPLETE`
+ * is returned, the message must be obtained with
+ * nexrad_message_feed_read_message() before any further messages will be
+ * parsed, though data may continue to be pushed.  When
+ * `NEXRAD_MESSAGE_FEED_ERROR` is returned, the message currently being
+ * parsed was found to be invalid, and has been discarded.
+ */
+enum nexrad_message_feed_state nexrad_message_feed_push(nexrad_message_feed *feed,
+    const void *buf,
+    size_t len
+);
+
+/*!
+ * \ingroup feed
+ * \brief Obtain the state of an incremental product message parser
+ * \param feed An incremental parser
+ * \return The state of the parser
+ */
+enum nexrad_message_feed_state nexrad_message_feed_get_state(nexrad_message_feed *feed);
+
+/*!
+ * \ingroup feed
+ * \brief Obtain the WMO header of the message being parsed
+ * \param feed An incremental parser
+ * \return The WMO header of the current message, or NULL if not yet available
+ *
+ * Obtain the WMO header of the current message, once the parser has reached
+ * the state `NEXRAD_MESSAGE_FEED_HEADER`.  The pointer returned is valid only
+ * until the next call to nexrad_message_feed_push() or
+ * nexrad_message_feed_read_message().
+ */
+nexrad_wmo_header *nexrad_message_feed_get_wmo_header(nexrad_message_feed *feed);
+
+/*!
+ * \ingroup feed
+ * \brief Obtain the message header of the message being parsed
+ * \param feed An incremental parser
+ * \return The message header of the current message, or NULL if not yet
+ *         available
+ *
+ * Obtain the message header of the current message, once the parser has
+ * reached the state `NEXRAD_MESSAGE_FEED_HEADER`.  The pointer returned is
+ * valid only until the next call to nexrad_message_feed_push() or
+ * nexrad_message_feed_read_message().
+ */
+nexrad_message_header *nexrad_message_feed_get_header(nexrad_message_feed *feed);
+
+/*!
+ * \ingroup feed
+ * \brief Obtain the product description of the message being parsed
+ * \param feed An incremental parser
+ * \return The product description of the current message, or NULL if not yet
+ *         available
+ *
+ * Obtain the product description of the current message, once the parser has
+ * reached the state `NEXRAD_MESSAGE_FEED_DESCRIPTION`.  The pointer returned
+ * is valid only until the next call to nexrad_message_feed_push() or
+ * nexrad_message_feed_read_message().
+ */
+nexrad_product_description *nexrad_message_feed_get_product_description(nexrad_message_feed *feed);
+
+/*!
+ * \ingroup feed
+ * \brief Obtain a complete message from an incremental parser
+ * \param feed An incremental parser
+ * \return A message object, or NULL if no complete message is available
+ *
+ * Obtain the message most recently completed by the parser, and begin
+ * parsing any data pushed after it.  As that data may itself contain a
+ * complete message, the state of the parser should be checked again with
+ * nexrad_message_feed_get_state() afterwards.  The message returned owns its
+ * data, and remains valid after the parser is destroyed.
+ */
+nexrad_message *nexrad_message_feed_read_message(nexrad_message_feed *feed);
+
+/*!
+ * \ingroup feed
+ * \brief Destroy an incremental product message parser
+ * \param feed An incremental parser
+ *
+ * Destroy an incremental parser, discarding any partially parsed message.
+ */
+void nexrad_message_feed_destroy(nexrad_message_feed *feed);
+
+#endif /* _NEXRAD_FEED_H */
@@ -63,8 +63,8 @@ typedef struct _nexrad_geo_cartesian {
  * \brief Geodesic calculations and geographic projection support
  */
 
-#pragma pack(1)
 #pragma pack(push)
+#pragma pack(1)
 
 typedef struct _nexrad_geo_projection_header {
     char     magic[4];
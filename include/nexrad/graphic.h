@@ -48,8 +48,16 @@ typedef struct _nexrad_graphic_page {
 
 nexrad_chunk *nexrad_graphic_block_open(nexrad_graphic_block *block);
 
+int nexrad_graphic_block_init(nexrad_chunk *iterator,
+    nexrad_graphic_block *block
+);
+
 nexrad_chunk *nexrad_graphic_block_read_page(nexrad_chunk *block);
 
+int nexrad_graphic_block_read_page_init(nexrad_chunk *block,
+    nexrad_chunk *page
+);
+
 void nexrad_graphic_page_next_packet(nexrad_chunk *page, size_t size);
 
 nexrad_packet *nexrad_graphic_page_peek_packet(nexrad_chunk *page, size_t *size);
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_LEVEL_H
+#define _NEXRAD_LEVEL_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <nexrad/product.h>
+
+#define NEXRAD_LEVEL_TABLE_SIZE 256
+
+#define NEXRAD_LEVEL_NO_DATA       (-9999.0f)
+#define NEXRAD_LEVEL_RANGE_FOLDED  (-9998.0f)
+
+#define NEXRAD_LEVEL_INT16_NO_DATA       INT16_MIN
+#define NEXRAD_LEVEL_INT16_RANGE_FOLDED  (INT16_MIN + 1)
+
+/*!
+ * \file nexrad/level.h
+ * \brief Conversion of NEXRAD Level III data levels to physical units
+ *
+ * Provides routines for converting the 8-bit rangebin values of radial and
+ * raster products into physical units, such as dBZ or m/s, by way of a
+ * lookup table built once from the product description of a message.
+ */
+
+/*!
+ * \defgroup level NEXRAD Level III data level conversion routines
+ */
+
+enum nexrad_level_unit {
+    NEXRAD_LEVEL_UNIT_NONE   = 0,
+    NEXRAD_LEVEL_UNIT_DBZ    = 1, /* Reflectivity, dBZ */
+    NEXRAD_LEVEL_UNIT_M_S    = 2, /* Velocity or spectrum width, m/s */
+    NEXRAD_LEVEL_UNIT_KG_M2  = 3, /* Vertically integrated liquid, kg/m² */
+    NEXRAD_LEVEL_UNIT_FT     = 4, /* Echo tops, feet above mean sea level */
+    NEXRAD_LEVEL_UNIT_DB     = 5, /* Differential reflectivity, dB */
+    NEXRAD_LEVEL_UNIT_RATIO  = 6, /* Correlation coefficient */
+    NEXRAD_LEVEL_UNIT_DEG_KM = 7  /* Specific differential phase, °/km */
+};
+
+typedef struct _nexrad_level_table nexrad_level_table;
+
+/*!
+ * \ingroup level
+ * \brief Build a data level conversion table for a product
+ * \param description The product description of a message
+ * \return A new data level conversion table, or NULL on failure
+ *
+ * Build a table of the physical value of each of the 256 possible rangebin
+ * values of the product described.  For the 256 level digital products, such
+ * as 94, 99, 153 and 154, values are derived from the minimum value and
+ * increment given in the product description; for dual polarization products
+ * 159, 161 and 163, from the scale and offset given therein; and for the
+ * 16 level products, from the data level thresholds, indexed by rangebin
+ * values as expanded by nexrad_radial_read_ray(), scaled from 0-15 to 0-255.
+ * Legacy velocity thresholds in knots are converted to m/s, and echo tops in
+ * thousands of feet are converted to feet.
+ *
+ * Values denoting an absence of data are given as `NEXRAD_LEVEL_NO_DATA`,
+ * and those denoting range folding as `NEXRAD_LEVEL_RANGE_FOLDED`.
+ *
+ * Returns NULL, with `errno` set to `EINVAL`, for products whose data levels
+ * are not understood.
+ */
+nexrad_level_table *nexrad_level_table_create(nexrad_product_description *description);
+
+/*!
+ * \ingroup level
+ * \brief Determine the physical unit of a data level conversion table
+ * \param table A data level conversion table
+ * \return The unit of values produced by the table
+ */
+enum nexrad_level_unit nexrad_level_table_get_unit(nexrad_level_table *table);
+
+/*!
+ * \ingroup level
+ * \brief Obtain the physical value of a single rangebin value
+ * \param table A data level conversion table
+ * \param v 8-bit rangebin value
+ * \return The physical value, or a sentinel value
+ */
+float nexrad_level_table_get_value(nexrad_level_table *table, uint8_t v);
+
+/*!
+ * \ingroup level
+ * \brief Set the scale of values produced by nexrad_level_decode_int16()
+ * \param table A data level conversion table
+ * \param scale Factor by which physical values are multiplied
+ * \return 0 on success, or -1 on failure
+ *
+ * Set the factor by which physical values are multiplied and rounded to yield
+ * 16-bit integers, which saturate at the limits of `int16_t`.  The default
+ * scale depends on the unit: 10 for dBZ, m/s and kg/m²; 0.01 for feet; 100
+ * for dB and °/km; and 1000 for correlation coefficient.
+ */
+int nexrad_level_table_set_int16_scale(nexrad_level_table *table, float scale);
+
+/*!
+ * \ingroup level
+ * \brief Get the scale of values produced by nexrad_level_decode_int16()
+ * \param table A data level conversion table
+ * \return The factor by which physical values are multiplied
+ */
+float nexrad_level_table_get_int16_scale(nexrad_level_table *table);
+
+/*!
+ * \ingroup level
+ * \brief Convert rangebin values to physical values
+ * \param table A data level conversion table
+ * \param dest Destination for `count` physical values
+ * \param values 8-bit rangebin values, such as a ray or a polar grid
+ * \param count Number of values to convert
+ *
+ * Convert `count` rangebin values to physical values in single precision.
+ * Where the processor supports it, AVX2 gathers from the table are used.
+ */
+void nexrad_level_decode_float(nexrad_level_table *table,
+    float *dest,
+    const uint8_t *values,
+    size_t count
+);
+
+/*!
+ * \ingroup level
+ * \brief Convert rangebin values to scaled 16-bit physical values
+ * \param table A data level conversion table
+ * \param dest Destination for `count` scaled values
+ * \param values 8-bit rangebin values, such as a ray or a polar grid
+ * \param count Number of values to convert
+ *
+ * Convert `count` rangebin values to physical values multiplied by the scale
+ * set with nexrad_level_table_set_int16_scale().  Values denoting an absence
+ * of data are given as `NEXRAD_LEVEL_INT16_NO_DATA`, and those denoting range
+ * folding as `NEXRAD_LEVEL_INT16_RANGE_FOLDED`.
+ */
+void nexrad_level_decode_int16(nexrad_level_table *table,
+    int16_t *dest,
+    const uint8_t *values,
+    size_t count
+);
+
+/*!
+ * \ingroup level
+ * \brief Destroy a data level conversion table
+ * \param table A data level conversion table
+ */
+void nexrad_level_table_destroy(nexrad_level_table *table);
+
+#endif /* _NEXRAD_LEVEL_H */
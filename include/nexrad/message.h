@@ -38,6 +38,18 @@
 #define NEXRAD_MESSAGE_MAX_BODY_SIZE 8388608
 #define NEXRAD_MESSAGE_MAX_SIZE     10485760
 
+#define NEXRAD_MESSAGE_IO_THRESHOLD 262144
+
+#define NEXRAD_MESSAGE_UNKNOWN_FOOTER "\x0d\x0d\x0a\x03"
+
+/*
+ * The most data preceding the end of the product description of a message,
+ * when the unknown header is present.
+ */
+#define NEXRAD_MESSAGE_PEEK_SIZE \
+    (sizeof(nexrad_unknown_header) + sizeof(nexrad_wmo_header) + \
+     sizeof(nexrad_message_header) + sizeof(nexrad_product_description))
+
 /*!
  * \file nexrad/message.h
  * \brief Interface to NEXRAD Level III product message files
@@ -49,6 +61,93 @@
 
 typedef struct _nexrad_message nexrad_message;
 
+typedef struct _nexrad_message_ctx nexrad_message_ctx;
+
+enum nexrad_message_flags {
+    NEXRAD_MESSAGE_LAZY    = (1 << 0), /* Defer decompression and block indexing */
+    NEXRAD_MESSAGE_TRUSTED = (1 << 1)  /* Skip validation of input known good */
+};
+
+typedef struct _nexrad_message_info {
+    char     station[5];      /* WSR-88D station identifier, such as KTLX */
+    char     product_code[4]; /* WMO product code, such as N0Q */
+    int      type;            /* Product type code */
+    uint16_t mode;            /* Radar operational mode */
+    uint16_t vcp;             /* Volume coverage pattern */
+    int16_t  seq;             /* Request sequence number */
+    uint16_t scan;            /* Volume scan number */
+    time_t   scan_timestamp;  /* Start of current scan */
+    time_t   gen_timestamp;   /* Time of product generation */
+    size_t   size;            /* Size of message from message header onward */
+} nexrad_message_info;
+
+/*
+ * An entry in the table of contents of packets within the product symbology
+ * and graphic alphanumeric blocks of a message.
+ */
+typedef struct _nexrad_packet_entry {
+    uint32_t offset; /* Offset of packet from start of message body */
+    uint32_t size;   /* Size of packet, including its header */
+    uint32_t next;   /* Index of next entry of same type, if any */
+    uint16_t type;   /* Packet type, as per enum nexrad_packet_type */
+    uint16_t layer;  /* Index of symbology layer or graphic page */
+    uint8_t  block;  /* NEXRAD_BLOCK_SYMBOLOGY or NEXRAD_BLOCK_GRAPHIC */
+} nexrad_packet_entry;
+
+#define NEXRAD_PACKET_ENTRY_NONE 0xffffffff
+
+/*
+ * A callback invoked by nexrad_message_visit() for each packet of a given
+ * type, along with its table of contents entry.  Returns 0 to continue the
+ * traversal, or any other value to stop it.
+ */
+typedef int (*nexrad_packet_visitor)(nexrad_packet *packet,
+    const nexrad_packet_entry *entry,
+    void *data
+);
+
+/*
+ * A callback invoked by nexrad_message_stream_rays() for each ray of a radial
+ * packet, along with the reader of that packet, and the rangebin values of the
+ * ray as decoded by nexrad_radial_read_ray().  Returns 0 to continue, or any
+ * other value to stop.  The reader is only valid for the duration of the call,
+ * and is released once the last ray has been delivered.
+ */
+struct _nexrad_radial;
+struct _nexrad_radial_ray;
+
+typedef int (*nexrad_ray_callback)(struct _nexrad_radial *radial,
+    struct _nexrad_radial_ray *ray,
+    uint8_t *values,
+    void *data
+);
+
+/*
+ * A table of callbacks for nexrad_message_visit(), any of which may be NULL,
+ * in which case packets or lines of the corresponding kind are skipped.
+ */
+typedef struct _nexrad_message_visitor {
+    nexrad_packet_visitor radial; /* Digital and RLE-encoded radial packets */
+    nexrad_packet_visitor raster; /* RLE-encoded raster packets */
+    nexrad_packet_visitor text;   /* Text packets */
+    nexrad_packet_visitor vector; /* Vector packets */
+    nexrad_packet_visitor cell;   /* Storm cell packets */
+    nexrad_packet_visitor hail;   /* Hail packets */
+    nexrad_packet_visitor other;  /* Packets of any other type */
+
+    /*
+     * Invoked for each line of text in the tabular alphanumeric block, after
+     * all packets have been visited.
+     */
+    int (*tabular)(char *line, size_t len, int page, int number, void *data);
+} nexrad_message_visitor;
+
+enum nexrad_message_io {
+    NEXRAD_MESSAGE_IO_AUTO = 0, /* Read files up to a threshold, map others */
+    NEXRAD_MESSAGE_IO_READ = 1, /* Always read files into a buffer */
+    NEXRAD_MESSAGE_IO_MMAP = 2  /* Always map files into memory */
+};
+
 /*!
  * \defgroup message NEXRAD Level III product message functions
  */
@@ -74,14 +173,319 @@ nexrad_message *nexrad_message_open_buf(void *buf, size_t len);
  */
 nexrad_message *nexrad_message_open(const char *path);
 
+/*!
+ * \ingroup message
+ * \brief Create a decoding context for opening NEXRAD Level III messages
+ * \return A new decoding context, or NULL on failure
+ *
+ * Create a decoding context which retains decompression buffers and bzip2
+ * decompressor state between calls to nexrad_message_open_ctx() or
+ * nexrad_message_open_buf_ctx().  When a message opened with a context is
+ * closed, its decompressed body is returned to the context and reused for the
+ * next message, so that a loop which opens and closes messages one at a time
+ * does not allocate in the steady state.
+ *
+ * A decoding context is not safe to share between threads; one context should
+ * be created per thread.  A context must outlive every message opened with it.
+ */
+nexrad_message_ctx *nexrad_message_ctx_create();
+
+/*!
+ * \ingroup message
+ * \brief Destroy a decoding context
+ * \param ctx A decoding context
+ *
+ * Free all buffers and decompressor state retained by a decoding context.
+ */
+void nexrad_message_ctx_destroy(nexrad_message_ctx *ctx);
+
+/*!
+ * \ingroup message
+ * \brief Set flags governing how messages are opened with a decoding context
+ * \param ctx A decoding context
+ * \param flags A bitwise OR of values from `enum nexrad_message_flags`
+ *
+ * Set the flags applied to every message subsequently opened with `ctx`.
+ *
+ * When `NEXRAD_MESSAGE_LAZY` is set, only the WMO header, message header and
+ * product description are validated upon open.  Decompression of the message
+ * body and location of the product symbology, graphic and tabular blocks are
+ * deferred until the first call to nexrad_message_get_symbology_block(),
+ * nexrad_message_get_graphic_block(), nexrad_message_get_tabular_block() or
+ * any function which relies on them.  Functions which only read header
+ * information, such as nexrad_message_read_station() or
+ * nexrad_message_read_station_location(), never cause the body to be
+ * decompressed.
+ *
+ * When `NEXRAD_MESSAGE_TRUSTED` is set, messages are assumed to have been
+ * validated already, such as when they are read back from an archive which
+ * was checked upon ingest.  The signatures, sizes and dividers of the headers
+ * and blocks are not checked upon open, nor are the headers of radial
+ * packets read by nexrad_message_stream_rays(); only those checks needed to
+ * locate each part of the message, and to keep writes within bounds, are
+ * performed.  Malformed input opened this way may cause reads outside of the
+ * message, so this flag must never be set for untrusted input.
+ */
+void nexrad_message_ctx_set_flags(nexrad_message_ctx *ctx, int flags);
+
+/*!
+ * \ingroup message
+ * \brief Get flags governing how messages are opened with a decoding context
+ * \param ctx A decoding context
+ * \return A bitwise OR of values from `enum nexrad_message_flags`, or -1 on
+ *         failure
+ */
+int nexrad_message_ctx_get_flags(nexrad_message_ctx *ctx);
+
+/*!
+ * \ingroup message
+ * \brief Set the number of threads used to decompress message bodies
+ * \param ctx A decoding context
+ * \param threads Maximum number of threads to decompress with, including the
+ *        calling thread
+ * \return 0 on success, -1 on failure
+ *
+ * Large products, such as super-resolution base data, are compressed as a
+ * single bzip2 stream consisting of several independent bzip2 blocks.  When
+ * `threads` is greater than 1, the blocks of such streams are located and
+ * decompressed concurrently on up to `threads` threads, reducing the time
+ * taken to open a single large message.  Streams consisting of one block, or
+ * whose block boundaries cannot be determined, are decompressed serially.
+ * The default is 1.
+ */
+int nexrad_message_ctx_set_threads(nexrad_message_ctx *ctx, int threads);
+
+/*!
+ * \ingroup message
+ * \brief Set how message files are loaded into memory
+ * \param ctx A decoding context
+ * \param io The manner in which to load message files
+ * \param threshold The largest file size, in bytes, which
+ *        `NEXRAD_MESSAGE_IO_AUTO` reads rather than maps
+ * \return 0 on success, -1 on failure
+ *
+ * Message files opened with `ctx` are either read into a buffer which the
+ * context retains for reuse by the next message, or mapped into memory.
+ * Reading avoids the cost of establishing and tearing down a mapping, which
+ * dominates for the small files typical of most products, whereas mapping
+ * avoids copying the contents of large files.  The default is
+ * `NEXRAD_MESSAGE_IO_AUTO`, with a threshold of
+ * `NEXRAD_MESSAGE_IO_THRESHOLD`; messages opened without a context are
+ * loaded likewise.
+ */
+int nexrad_message_ctx_set_io(nexrad_message_ctx *ctx,
+    enum nexrad_message_io io,
+    size_t threshold
+);
+
+/*!
+ * \ingroup message
+ * \brief Load a NEXRAD Level III product message from memory with a context
+ * \param buf Pointer to a memory buffer
+ * \param len Size of memory buffer in `len`
+ * \param ctx A decoding context, or NULL
+ * \return An object representing a NEXRAD Level III product message file
+ *
+ * Like nexrad_message_open_buf(), but decompresses the message body, if any,
+ * into a buffer lent by the decoding context `ctx`.
+ */
+nexrad_message *nexrad_message_open_buf_ctx(void *buf,
+    size_t len,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup message
+ * \brief Load a NEXRAD Level III product message from memory, taking ownership
+ * \param buf Pointer to a memory buffer allocated with malloc()
+ * \param len Size of memory buffer in `len`
+ * \return An object representing a NEXRAD Level III product message file
+ *
+ * Like nexrad_message_open_buf(), but upon success, the message takes
+ * ownership of `buf`, which is freed once the last reference to the message
+ * is dropped.  Upon failure, `buf` remains the responsibility of the caller.
+ */
+nexrad_message *nexrad_message_adopt_buf(void *buf, size_t len);
+
+/*!
+ * \ingroup message
+ * \brief Load a NEXRAD Level III product message from memory with a context,
+ *        taking ownership
+ * \param buf Pointer to a memory buffer allocated with malloc()
+ * \param len Size of memory buffer in `len`
+ * \param ctx A decoding context, or NULL
+ * \return An object representing a NEXRAD Level III product message file
+ *
+ * Like nexrad_message_adopt_buf(), but decodes the message with `ctx` as per
+ * nexrad_message_open_buf_ctx().
+ */
+nexrad_message *nexrad_message_adopt_buf_ctx(void *buf,
+    size_t len,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup message
+ * \brief Load a NEXRAD Level III product message file from disk with a context
+ * \param path A path to a NEXRAD Level III product message file on disk
+ * \param ctx A decoding context, or NULL
+ * \return An object representing a NEXRAD Level III Product message file
+ *
+ * Like nexrad_message_open(), but decompresses the message body, if any, into
+ * a buffer lent by the decoding context `ctx`.
+ */
+nexrad_message *nexrad_message_open_ctx(const char *path,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup message
+ * \brief Load a NEXRAD Level III product message file relative to a directory
+ * \param dirfd A file descriptor referring to a directory, or `AT_FDCWD`
+ * \param path A path to a NEXRAD Level III product message file, relative to
+ *        `dirfd`
+ * \param ctx A decoding context, or NULL
+ * \return An object representing a NEXRAD Level III Product message file
+ *
+ * Like nexrad_message_open_ctx(), but resolves relative paths against the
+ * directory `dirfd` as per openat(2), sparing callers walking a directory the
+ * cost of resolving the full path to each file within.
+ */
+nexrad_message *nexrad_message_openat_ctx(int dirfd,
+    const char *path,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup message
+ * \brief Load a NEXRAD Level III product message file from a file descriptor
+ * \param fd A file descriptor open for reading
+ * \return An object representing a NEXRAD Level III Product message file
+ *
+ * Load a message from the entirety of the file referred to by `fd`, which is
+ * read from its start regardless of the current file offset.  The file
+ * descriptor is not retained, and may be closed once this function returns.
+ */
+nexrad_message *nexrad_message_open_fd(int fd);
+
+/*!
+ * \ingroup message
+ * \brief Load a NEXRAD Level III product message file from a file descriptor
+ *        with a context
+ * \param fd A file descriptor open for reading
+ * \param ctx A decoding context, or NULL
+ * \return An object representing a NEXRAD Level III Product message file
+ *
+ * Like nexrad_message_open_fd(), but loads and decompresses the message as
+ * configured by the decoding context `ctx`.
+ */
+nexrad_message *nexrad_message_open_fd_ctx(int fd,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup message
+ * \brief Obtain metadata of a NEXRAD Level III product message in memory
+ * \param buf Pointer to a memory buffer holding at least the start of a message
+ * \param len Size of memory buffer in `buf`
+ * \param info Pointer to a structure to fill with message metadata
+ * \return 0 on success, -1 on failure
+ *
+ * Validate the headers and product description at the start of `buf`, and
+ * fill `info` with the metadata found within, without opening a message or
+ * decompressing its body.  Only the first `NEXRAD_MESSAGE_PEEK_SIZE` bytes of
+ * the message are needed.
+ */
+int nexrad_message_peek_buf(const void *buf,
+    size_t len,
+    nexrad_message_info *info
+);
+
+/*!
+ * \ingroup message
+ * \brief Obtain metadata of a NEXRAD Level III product message file
+ * \param path A path to a NEXRAD Level III product message file on disk
+ * \param info Pointer to a structure to fill with message metadata
+ * \return 0 on success, -1 on failure
+ *
+ * Like nexrad_message_peek_buf(), but reads the start of the file at `path`
+ * with a single read into a buffer on the stack.  Nothing is allocated or
+ * mapped, making this suitable for scanning large numbers of files.
+ */
+int nexrad_message_peek(const char *path, nexrad_message_info *info);
+
+/*!
+ * \ingroup message
+ * \brief Obtain metadata of a NEXRAD Level III product message file relative
+ *        to a directory
+ * \param dirfd A file descriptor referring to a directory, or `AT_FDCWD`
+ * \param path A path to a NEXRAD Level III product message file, relative to
+ *        `dirfd`
+ * \param info Pointer to a structure to fill with message metadata
+ * \return 0 on success, -1 on failure
+ */
+int nexrad_message_peekat(int dirfd,
+    const char *path,
+    nexrad_message_info *info
+);
+
+/*!
+ * \ingroup message
+ * \brief Obtain metadata of a NEXRAD Level III product message file from a
+ *        file descriptor
+ * \param fd A file descriptor open for reading
+ * \param info Pointer to a structure to fill with message metadata
+ * \return 0 on success, -1 on failure
+ *
+ * Like nexrad_message_peek(), but reads from the start of the file referred
+ * to by `fd`, regardless of the current file offset.
+ */
+int nexrad_message_peek_fd(int fd, nexrad_message_info *info);
+
+/*!
+ * \ingroup message
+ * \brief Take a new reference to a message
+ * \param message An opened NEXRAD Level III message file
+ * \return `message`, or NULL if the message could not be indexed
+ *
+ * Take an additional reference to a message, which may then be handed to
+ * another thread, and which is dropped with nexrad_message_unref().  The
+ * message, and every packet, block, radial or raster reader and iterator
+ * derived from it, remain valid for as long as any reference is held.
+ *
+ * When the caller holds the only reference, the message is first indexed in
+ * full, including any work deferred by `NEXRAD_MESSAGE_LAZY`, and detached
+ * from its decoding context, if any; thus the context need not outlive it,
+ * and all threads may read the message concurrently without locking.  Should
+ * the body fail to decompress, or its blocks or packets fail to be indexed,
+ * no reference is taken, and NULL is returned with `errno` set accordingly.
+ * Only a thread already holding a reference may take another.
+ */
+nexrad_message *nexrad_message_ref(nexrad_message *message);
+
+/*!
+ * \ingroup message
+ * \brief Drop a reference to a message
+ * \param message An opened NEXRAD Level III message file
+ *
+ * Drop a reference to a message, destroying it as per
+ * nexrad_message_destroy() once the last reference is dropped.  This may be
+ * called from any thread.
+ */
+void nexrad_message_unref(nexrad_message *message);
+
 /*!
  * \ingroup message
  * \brief Destroy a nexrad_message object
  * \param message An opened NEXRAD Level III message file
  *
- * Free any state associated with an opened message file, and deallocate the
- * memory storing the object itself.  Furthermore, any memory-mapped state is
- * unmapped from the address space.
+ * Drop the reference to a message held by the caller.  Once no references
+ * remain, free any state associated with an opened message file, and
+ * deallocate the memory storing the object itself.  Furthermore, any
+ * memory-mapped state is unmapped from the address space.  If the message was
+ * opened with a decoding context and was never shared with
+ * nexrad_message_ref(), its file buffer and decompressed body are returned to
+ * that context for reuse.
  */
 void nexrad_message_destroy(nexrad_message *message);
 
@@ -218,4 +622,125 @@ nexrad_packet *nexrad_message_find_symbology_packet_by_type(nexrad_message *mess
     enum nexrad_packet_type type
 );
 
+/*!
+ * \ingroup message
+ * \brief Obtain the table of contents of packets within a message
+ * \param message An opened NEXRAD Level III message file
+ * \param entries Pointer to which the address of the table is written
+ * \return The number of entries in the table, or -1 on failure
+ *
+ * Obtain a table of every packet within the product symbology and graphic
+ * alphanumeric blocks of a message, in the order in which they occur.  The
+ * table is built upon first use, and is retained by the message until it is
+ * destroyed.
+ */
+ssize_t nexrad_message_get_packet_entries(nexrad_message *message,
+    const nexrad_packet_entry **entries
+);
+
+/*!
+ * \ingroup message
+ * \brief Find the first packet of a given type within a message
+ * \param message An opened NEXRAD Level III message file
+ * \param type A packet type
+ * \return The table of contents entry of the first packet of type `type`, or
+ *         NULL if there is none
+ *
+ * Find the first packet of type `type` in the table of contents of a message,
+ * in constant time.  Further packets of the same type are found by passing the
+ * entry returned to nexrad_message_next_packet_entry().
+ */
+const nexrad_packet_entry *nexrad_message_find_packet_entry(nexrad_message *message,
+    enum nexrad_packet_type type
+);
+
+/*!
+ * \ingroup message
+ * \brief Find the next packet of the same type as a given packet
+ * \param message An opened NEXRAD Level III message file
+ * \param entry A table of contents entry within `message`
+ * \return The table of contents entry of the next packet of the same type, or
+ *         NULL if there is none
+ */
+const nexrad_packet_entry *nexrad_message_next_packet_entry(nexrad_message *message,
+    const nexrad_packet_entry *entry
+);
+
+/*!
+ * \ingroup message
+ * \brief Count the packets of a given type within a message
+ * \param message An opened NEXRAD Level III message file
+ * \param type A packet type
+ * \return The number of packets of type `type`, or -1 on failure
+ */
+ssize_t nexrad_message_count_packets(nexrad_message *message,
+    enum nexrad_packet_type type
+);
+
+/*!
+ * \ingroup message
+ * \brief Obtain the packet described by a table of contents entry
+ * \param message An opened NEXRAD Level III message file
+ * \param entry A table of contents entry within `message`
+ * \return Pointer to the packet within the message body
+ */
+nexrad_packet *nexrad_message_get_packet(nexrad_message *message,
+    const nexrad_packet_entry *entry
+);
+
+/*!
+ * \ingroup message
+ * \brief Visit every packet and line of text within a message in one pass
+ * \param message An opened NEXRAD Level III message file
+ * \param visitor A table of callbacks to dispatch to
+ * \param data Opaque pointer passed to each callback
+ * \return 0 when the whole message has been visited, -1 on failure, or
+ *         otherwise the nonzero value returned by the callback which stopped
+ *         the traversal
+ *
+ * Walk the product symbology, graphic alphanumeric and tabular alphanumeric
+ * blocks of a message once, in the order in which their contents occur,
+ * invoking the callback in `visitor` corresponding to each packet type found,
+ * and then the tabular callback for each line of text.  Packets are located
+ * by way of the table of contents of the message, and so are not validated
+ * again on subsequent traversals.
+ */
+int nexrad_message_visit(nexrad_message *message,
+    const nexrad_message_visitor *visitor,
+    void *data
+);
+
+/*!
+ * \ingroup message
+ * \brief Deliver the rays of a radial product as they are decompressed
+ * \param message A NEXRAD Level III message opened with `NEXRAD_MESSAGE_LAZY`
+ * \param callback A function to receive each ray
+ * \param data Opaque pointer passed to `callback`
+ * \return 0 when every ray has been delivered, -1 on failure, or otherwise
+ *         the nonzero value returned by `callback` to stop early
+ *
+ * Invoke `callback` for each ray of the first radial packet of a message.
+ * When the body of the message is compressed and has yet to be decompressed,
+ * as is the case for messages opened with `NEXRAD_MESSAGE_LAZY`, the body is
+ * decompressed on another thread, and each ray is delivered as soon as it has
+ * been decompressed, so that the work of the consumer overlaps with that of
+ * the decompressor.  Once every ray has been delivered, the body is retained
+ * by the message as though it had been decompressed upon opening.  Otherwise,
+ * the rays are simply read from the body already present.
+ *
+ * The decoding context of the message, if any, is used by the decompressing
+ * thread while this function runs, and so must not be used by `callback`.
+ *
+ * While rays are delivered as they are decompressed, those past the current
+ * ray may not yet be readable, and so the reader passed to `callback` refuses
+ * any operation which reads other rays of the packet, such as reading ahead
+ * with nexrad_radial_read_ray(), rewinding with nexrad_radial_reset(), azimuth
+ * lookups with nexrad_radial_find_ray() or nexrad_radial_get_rangebin(),
+ * unpacking, resampling or rendering, which fail with `errno` set to `EBUSY`.
+ */
+int nexrad_message_stream_rays(nexrad_message *message,
+    nexrad_ray_callback callback,
+    void *data
+);
+
 #endif /* _NEXRAD_MESSAGE_H */
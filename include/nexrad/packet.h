@@ -25,6 +25,7 @@
 #define _NEXRAD_PACKET_H
 
 #include <stdint.h>
+#include <sys/types.h>
 
 #include <nexrad/vector.h>
 
@@ -96,6 +97,14 @@ typedef struct _nexrad_vector_packet {
 
 enum nexrad_packet_type nexrad_packet_get_type(nexrad_packet *packet);
 
+/*
+ * Determine the size of a packet, including its header, given that `len`
+ * bytes are available from the start of the packet.  Radial and raster packets
+ * do not carry a size in their header, and are measured by walking each of
+ * their rays or lines.  Returns -1 if the packet does not fit within `len`.
+ */
+ssize_t nexrad_packet_find_size(nexrad_packet *packet, size_t len);
+
 int nexrad_packet_find_text_data(nexrad_packet *packet,
     int *i, int *j, int *color, char **data, size_t *textlen
 );
@@ -33,6 +33,8 @@
 #define NEXRAD_RADIAL_RLE_FACTOR     16
 #define NEXRAD_RADIAL_AZIMUTH_FACTOR  0.1
 #define NEXRAD_RADIAL_RANGE_FACTOR    0.001
+#define NEXRAD_RADIAL_MAX_BINS     1840
+#define NEXRAD_RADIAL_AZIMUTH_SLOTS 3600
 
 enum nexrad_radial_type {
     NEXRAD_RADIAL_RLE     = 0xaf1f,
@@ -49,8 +51,8 @@ enum nexrad_radial_type {
  * length-encoded format.
  */
 
-#pragma pack(1)
 #pragma pack(push)
+#pragma pack(1)
 
 typedef struct _nexrad_radial_packet {
     uint16_t type;           /* 16 or 0xaf1f */
@@ -75,12 +77,49 @@ typedef struct _nexrad_radial_run { /* For 0xaf1f */
 
 #pragma pack(pop)
 
-typedef struct _nexrad_radial nexrad_radial;
+typedef struct _nexrad_radial {
+    nexrad_radial_packet *  packet;
+    enum nexrad_radial_type type;
+    nexrad_radial_ray *     current;
+
+    size_t bytes_read;
+    size_t rays_left;
+
+    uint16_t  bins;
+    uint8_t * values; /* Scratch space for one ray of rangebin values */
+
+    uint32_t * index;   /* Ray offsets by tenth of a degree, built on demand */
+    int        partial; /* Rays past the current one may not be readable */
+} nexrad_radial;
 
 typedef struct _nexrad_radial_buffer {
     uint16_t rays, bins, first, _unused;
 } nexrad_radial_buffer;
 
+#define NEXRAD_RADIAL_GRID_ALIGN 64
+#define NEXRAD_RADIAL_GRID_NONE  0xffff
+
+typedef struct _nexrad_radial_grid {
+    uint16_t rows;       /* Number of rows of rangebin values, one per ray */
+    uint16_t bins;       /* Number of rangebins in each row */
+    uint16_t first;      /* Index of first rangebin */
+    uint16_t resolution; /* Width of each azimuth slot in tenths of a degree */
+    uint16_t slots;      /* Number of azimuth slots about the full circle */
+    size_t   stride;     /* Distance between rows, a multiple of 64 bytes */
+
+    uint16_t * remap;  /* Row covering each azimuth slot, or NEXRAD_RADIAL_GRID_NONE */
+    uint8_t *  values; /* Rows of rangebin values, 64-byte aligned */
+} nexrad_radial_grid;
+
+typedef struct _nexrad_radial_sector {
+    uint16_t rows;  /* Number of rays within the sector */
+    uint16_t gates; /* Number of rangebins in each row */
+    uint16_t first; /* Index within each ray of the first rangebin of each row */
+
+    uint16_t * azimuths; /* Start angle of the ray of each row, in tenths of a degree */
+    uint8_t *  values;   /* Rangebin values, `gates` per row */
+} nexrad_radial_sector;
+
 /*!
  * \defgroup radial NEXRAD Level III radial data handling routines
  */
@@ -95,9 +134,82 @@ typedef struct _nexrad_radial_buffer {
  * generate a buffer with 8-bit data values, which can be used for O(1) lookups
  * with polar coordinates accurate to 0.1°.  RLE-encoded values are scaled from
  * rangebin values of 0-15 to 0-255.
+ *
+ * The buffer so produced repeats each ray once for every tenth of a degree it
+ * spans; nexrad_radial_packet_resample() offers the same lookups at a tenth
+ * of the size.
  */
 nexrad_radial_buffer *nexrad_radial_packet_unpack(nexrad_radial_packet *packet);
 
+/*!
+ * \ingroup radial
+ * \brief Resample a radial packet onto a uniform polar grid
+ * \param radial A radial packet reader object
+ * \param resolution Width of each azimuth slot of the grid, in tenths of a
+ *        degree, which must evenly divide 3600
+ * \return A new polar grid, or NULL on failure
+ *
+ * Decode every ray of the radial packet, whether RLE- or digitally-encoded,
+ * into a row of its own, and build a table mapping each azimuth slot of
+ * `resolution` tenths of a degree to the row of the ray covering the middle
+ * of that slot.  A `resolution` of 10 yields a grid of 360 slots, and a
+ * `resolution` of 5 one of 720 slots, suitable for super resolution products.
+ *
+ * Rows are stored contiguously, each starting on a 64 byte boundary, and are
+ * padded with zeroes from the end of the ray to the start of the next row.
+ * RLE-encoded values are scaled from rangebin values of 0-15 to 0-255.  The
+ * position of `radial` in the packet is left unchanged.
+ */
+nexrad_radial_grid *nexrad_radial_resample(nexrad_radial *radial,
+    int resolution
+);
+
+/*!
+ * \ingroup radial
+ * \brief Resample any radial packet onto a uniform polar grid
+ * \param packet A RLE or digitally-encoded radial packet
+ * \param resolution Width of each azimuth slot of the grid, in tenths of a
+ *        degree, which must evenly divide 3600
+ * \return A new polar grid, or NULL on failure
+ *
+ * Like nexrad_radial_resample(), but for a bare radial packet.
+ */
+nexrad_radial_grid *nexrad_radial_packet_resample(nexrad_radial_packet *packet,
+    int resolution
+);
+
+/*!
+ * \ingroup radial
+ * \brief Find the row of a polar grid covering a given azimuth
+ * \param grid A polar grid
+ * \param azimuth Azimuth in degrees, wrapped to 0-360
+ * \return Pointer to `grid->bins` rangebin values, or NULL if no ray covers
+ *         the azimuth
+ */
+uint8_t *nexrad_radial_grid_get_row(nexrad_radial_grid *grid,
+    double azimuth
+);
+
+/*!
+ * \ingroup radial
+ * \brief Determine a rangebin value of a polar grid
+ * \param grid A polar grid
+ * \param azimuth Azimuth in degrees, wrapped to 0-360
+ * \param range Index of rangebin within the row
+ * \return An integer 0-255 denoting the observed value, or -1 on failure
+ */
+int nexrad_radial_grid_get_rangebin(nexrad_radial_grid *grid,
+    double azimuth,
+    int range
+);
+
+/*!
+ * \ingroup radial
+ * \brief Destroy a polar grid
+ * \param grid A polar grid
+ */
+void nexrad_radial_grid_destroy(nexrad_radial_grid *grid);
+
 /*!
  * \ingroup radial
  * \brief Open a NEXRAD Level III radial packet for reading
@@ -110,6 +222,40 @@ nexrad_radial_buffer *nexrad_radial_packet_unpack(nexrad_radial_packet *packet);
  */
 nexrad_radial *nexrad_radial_packet_open(nexrad_radial_packet *packet);
 
+/*!
+ * \ingroup radial
+ * \brief Prepare a caller-owned radial packet reader object
+ * \param radial A `nexrad_radial` object to initialize
+ * \param packet Pointer to a raw NEXRAD Level III radial packet
+ * \param values Scratch space for one ray of rangebin values
+ * \return 0 on success, or -1 if the radial packet is invalid
+ *
+ * Prepare a `nexrad_radial` object provided by the caller, on the stack or
+ * otherwise, to read the radial packet given, without allocating any memory.
+ * Rangebin values of each ray read are decoded into `values`, which must be
+ * at least as long as the number of rangebins in the packet; a buffer of
+ * `NEXRAD_RADIAL_MAX_BINS` bytes suffices for any valid packet.  Objects so
+ * prepared must not be passed to nexrad_radial_close() nor
+ * nexrad_radial_destroy().  Should rays be looked up by azimuth, such as with
+ * nexrad_radial_get_ray(), then the azimuth index built to do so must be
+ * released with nexrad_radial_release().
+ */
+int nexrad_radial_init(nexrad_radial *radial,
+    nexrad_radial_packet *packet,
+    uint8_t *values
+);
+
+/*!
+ * \ingroup radial
+ * \brief Release state built on demand by a caller-owned radial packet reader
+ * \param radial A `nexrad_radial` object prepared with nexrad_radial_init()
+ *
+ * Free the azimuth index built upon the first lookup of a ray by azimuth, if
+ * any.  The object may be used again afterwards, and the index is rebuilt
+ * should it be needed.
+ */
+void nexrad_radial_release(nexrad_radial *radial);
+
 /*!
  * \ingroup radial
  * \brief Determine how many bytes of a radial packet have been read
@@ -133,7 +279,8 @@ size_t nexrad_radial_bytes_read(nexrad_radial *radial);
  *
  * Reset a `nexrad_radial` object state to the beginning of a radial packet, in
  * case one wants to reuse the same `nexrad_radial` object to make multiple
- * passes over a single radial packet.
+ * passes over a single radial packet.  Readers passed to the callback of
+ * nexrad_message_stream_rays() are left as-is, with `errno` set to `EBUSY`.
  */
 void nexrad_radial_reset(nexrad_radial *radial);
 
@@ -164,23 +311,78 @@ void nexrad_radial_destroy(nexrad_radial *radial);
  * \brief Search radial packet for radial ray at given azimuth
  * \param radial A radial reader object
  * \param azimuth The azimuth 0-359 of the desired ray
- * \param values Pointer to write address of digitally encoded rangebin values
- *               to
+ * \param values Pointer to write address of rangebin values to
  * \return A radial ray object
  *
- * With the aid of the radial packet reader in `radial`, search for, and return
- * the NEXRAD Level III radial ray whose azimuth is at the desired value.  A
- * pointer to uint8_t values containing one 1km rangebin value per byte is
- * written in `values` just prior to return.
+ * With the aid of the radial packet reader in `radial`, return the NEXRAD
+ * Level III radial ray which covers the desired azimuth, whether the packet
+ * is digitally or run length encoded.  A pointer to uint8_t values containing
+ * one rangebin value per byte is written in `values` just prior to return.
+ *
+ * Upon the first call, an index of rays by tenth of a degree of azimuth is
+ * built in a single pass over the packet; every lookup thereafter takes
+ * constant time.
  *
  * Note that the data returned in `values` is only valid until the next call to
- * nexrad_radial_get_ray() or nexrad_radial_read_ray().
+ * nexrad_radial_get_ray(), nexrad_radial_find_ray() or
+ * nexrad_radial_read_ray().
  */
 nexrad_radial_ray *nexrad_radial_get_ray(nexrad_radial *radial,
     int azimuth,
     uint8_t **values
 );
 
+/*!
+ * \ingroup radial
+ * \brief Search radial packet for radial ray at a fractional azimuth
+ * \param radial A radial reader object
+ * \param azimuth Azimuth in degrees, wrapped to 0-360
+ * \param values Pointer to write address of rangebin values to
+ * \return A radial ray object, or NULL if no ray covers the azimuth
+ *
+ * Like nexrad_radial_get_ray(), but with an azimuth accurate to 0.1 degrees,
+ * such that every ray of a super resolution product, such as one of 720 rays
+ * each 0.5 degrees wide, may be found.
+ */
+nexrad_radial_ray *nexrad_radial_find_ray(nexrad_radial *radial,
+    double azimuth,
+    uint8_t **values
+);
+
+/*!
+ * \ingroup radial
+ * \brief Decode only those rangebins within a sector of a radial packet
+ * \param radial A radial reader object
+ * \param azimuth Azimuth in degrees at which the sector starts
+ * \param width Width of the sector in degrees, clockwise from `azimuth`, up
+ *        to 360
+ * \param first Index of the first rangebin wanted from each ray
+ * \param gates Number of rangebins wanted from each ray
+ * \return A new sector, or NULL on failure
+ *
+ * Decode rangebins `first` through `first + gates - 1` of each ray covering
+ * any part of the sector given into a dense buffer of `gates` values per ray,
+ * in order of azimuth.  Rays are found by way of the azimuth index used by
+ * nexrad_radial_get_ray(), so rays outside of the sector are never visited;
+ * for run length encoded rays, runs preceding the first rangebin are skipped
+ * without being expanded, and decoding stops at the last.  The number of
+ * gates is reduced should the sector extend beyond the last rangebin of the
+ * packet, and rangebins beyond the end of a ray are zero.
+ */
+nexrad_radial_sector *nexrad_radial_read_sector(nexrad_radial *radial,
+    double azimuth,
+    double width,
+    int first,
+    int gates
+);
+
+/*!
+ * \ingroup radial
+ * \brief Destroy a sector of a radial packet
+ * \param sector A sector obtained with nexrad_radial_read_sector()
+ */
+void nexrad_radial_sector_destroy(nexrad_radial_sector *sector);
+
 /*!
  * \ingroup radial
  * \brief Determine the azimuth of a given NEXRAD Level III radial ray
@@ -216,7 +418,9 @@ int nexrad_radial_get_rangebin(nexrad_radial *radial,
  * \return A NEXRAD Level III radial ray, or NULL if no more rays are available
  *
  * Read the next available ray in a NEXRAD Level III radial packet.  If no more
- * rays are available to be read, then NULL will be returned instead.
+ * rays are available to be read, then NULL will be returned instead.  Readers
+ * passed to the callback of nexrad_message_stream_rays() may not be advanced
+ * by the callback, and NULL is returned with `errno` set to `EBUSY`.
  */
 nexrad_radial_ray *nexrad_radial_read_ray(nexrad_radial *radial,
     uint8_t **values
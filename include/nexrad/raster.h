@@ -31,8 +31,8 @@
 
 #define NEXRAD_RASTER_RLE_FACTOR 16
 
-#pragma pack(1)
 #pragma pack(push)
+#pragma pack(1)
 
 typedef struct _nexrad_raster_packet {
     uint16_t type;         /* 0xba0f or 0xba07 */
@@ -59,10 +59,24 @@ typedef struct _nexrad_raster_run {
 
 #pragma pack(pop)
 
-typedef struct _nexrad_raster nexrad_raster;
+typedef struct _nexrad_raster {
+    nexrad_raster_packet * packet;
+    size_t                 bytes_read;
+    uint16_t               lines_left;
+    nexrad_raster_line *   current;
+} nexrad_raster;
 
 nexrad_raster *nexrad_raster_packet_open(nexrad_raster_packet *packet);
 
+/*
+ * Prepare the caller-owned raster packet reader in `raster` without allocating
+ * any memory.  Returns 0 on success, or -1 if the raster packet is invalid.
+ * Readers so prepared must not be passed to nexrad_raster_close().
+ */
+int nexrad_raster_init(nexrad_raster *raster,
+    nexrad_raster_packet *packet
+);
+
 size_t nexrad_raster_bytes_read(nexrad_raster *raster);
 
 void nexrad_raster_close(nexrad_raster *raster);
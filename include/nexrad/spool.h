@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_SPOOL_H
+#define _NEXRAD_SPOOL_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <nexrad/message.h>
+
+/*!
+ * \file nexrad/spool.h
+ * \brief Splitting of concatenated NEXRAD Level III product message streams
+ *
+ * An interface for locating the boundaries of NEXRAD Level III product
+ * messages within a buffer or spool file holding many products back to back,
+ * as is the case with LDM and NOAAPort feeds, and for obtaining message
+ * objects which refer directly to the memory of the spool, without copying.
+ */
+
+typedef struct _nexrad_spool nexrad_spool;
+
+/*!
+ * \defgroup spool NEXRAD Level III product message stream splitting routines
+ */
+
+/*!
+ * \ingroup spool
+ * \brief Open a memory buffer containing concatenated product messages
+ * \param buf Pointer to a memory buffer
+ * \param len Size of memory buffer in `buf`
+ * \return An object for iterating over the product messages in `buf`
+ *
+ * Open a memory buffer holding any number of NEXRAD Level III product
+ * messages, each of which may be preceded by the unknown header prepended by
+ * LDM and NOAAPort feeds, and followed by the trailing unknown footer.  The
+ * buffer is not copied, and must remain valid until the spool, and every
+ * message obtained from it, is closed.
+ */
+nexrad_spool *nexrad_spool_open_buf(void *buf, size_t len);
+
+/*!
+ * \ingroup spool
+ * \brief Open a spool file containing concatenated product messages
+ * \param path A path to a spool file on disk
+ * \return An object for iterating over the product messages in the file
+ *
+ * Map a spool file into memory in its entirety, for iterating over the NEXRAD
+ * Level III product messages contained therein.
+ */
+nexrad_spool *nexrad_spool_open(const char *path);
+
+/*!
+ * \ingroup spool
+ * \brief Locate the next product message in a spool
+ * \param spool A spool object
+ * \param len Pointer to a size_t to write size of message to, in bytes
+ * \return Pointer to the start of the next message within the spool, or NULL
+ *         when no further messages are available
+ *
+ * Locate the next product message in a spool, starting at either the unknown
+ * header or WMO header of the message and ending at the end of the message
+ * itself, or its unknown footer, when present.  Any data between messages
+ * which does not appear to be part of a valid product message is skipped.
+ * A message which is not followed by its footer, another message, or the end
+ * of the spool, and within which another message begins, is taken to have been
+ * cut short, and is likewise skipped.  The region returned may be passed as-is to nexrad_message_open_buf().
+ */
+void *nexrad_spool_find_message(nexrad_spool *spool, size_t *len);
+
+/*!
+ * \ingroup spool
+ * \brief Open the next product message in a spool
+ * \param spool A spool object
+ * \param ctx A decoding context, or NULL
+ * \return An object representing the next NEXRAD Level III product message in
+ *         the spool, or NULL when no further messages are available
+ *
+ * Open the next product message in a spool with nexrad_message_open_buf_ctx(),
+ * such that the message refers to the memory of the spool itself.  Messages
+ * which fail to open are skipped.
+ */
+nexrad_message *nexrad_spool_read_message(nexrad_spool *spool,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup spool
+ * \brief Obtain the current offset into a spool
+ * \param spool A spool object
+ * \return Offset, in bytes, of the end of the last message found
+ *
+ * Should the spool end partway through a message, with no other message
+ * beginning after it, the offset is that of the start of the incomplete
+ * message instead, so that a caller following a growing spool file may resume
+ * reading from there once it is complete.
+ */
+size_t nexrad_spool_get_offset(nexrad_spool *spool);
+
+/*!
+ * \ingroup spool
+ * \brief Close a spool
+ * \param spool A spool object
+ *
+ * Close a spool, unmapping any spool file mapped into memory.  Any messages
+ * obtained from the spool must be closed beforehand.
+ */
+void nexrad_spool_close(nexrad_spool *spool);
+
+#endif /* _NEXRAD_SPOOL_H */
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_STORE_H
+#define _NEXRAD_STORE_H
+
+#include <sys/types.h>
+
+#include <nexrad/message.h>
+
+/*!
+ * \file nexrad/store.h
+ * \brief On-disk store of decompressed NEXRAD Level III product messages
+ *
+ * A directory of product messages transcoded with their bodies decompressed,
+ * kept alongside an archive of compressed products, so that products read
+ * repeatedly are only ever decompressed once.
+ */
+
+typedef struct _nexrad_message_store nexrad_message_store;
+
+/*!
+ * \defgroup store NEXRAD Level III transcoded message store routines
+ */
+
+/*!
+ * \ingroup store
+ * \brief Open a store of transcoded product messages
+ * \param dir Path to the store directory, which is created if need be
+ * \param budget The maximum total size, in bytes, of transcoded messages
+ * \return A store object, or NULL on failure
+ *
+ * Open a directory of transcoded product messages.  Each transcoded message
+ * is a copy of an original product message file, with its body decompressed
+ * and its product description marked as uncompressed, and is named for the
+ * device, inode, size and modification time of the original, such that a
+ * modified original is never matched to a stale transcoded copy.
+ *
+ * Once the total size of transcoded messages exceeds `budget`, the least
+ * recently used are removed.  A store may be shared between threads, and a
+ * store directory between processes.
+ */
+nexrad_message_store *nexrad_message_store_open(const char *dir, size_t budget);
+
+/*!
+ * \ingroup store
+ * \brief Open a product message file by way of a store
+ * \param store A store object
+ * \param path Path to an original product message file
+ * \param ctx A decoding context, or NULL
+ * \return An object representing a NEXRAD Level III Product message file
+ *
+ * Open the transcoded copy of the message file at `path`, if it is present in
+ * the store, such that the message is opened without decompression.
+ * Otherwise, open and decompress the original, and add a transcoded copy to
+ * the store for next time.  Products which are not compressed are always
+ * opened from the original.
+ */
+nexrad_message *nexrad_message_store_open_message(nexrad_message_store *store,
+    const char *path,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup store
+ * \brief Add a product message file to a store
+ * \param store A store object
+ * \param path Path to an original product message file
+ * \param ctx A decoding context, or NULL
+ * \return 1 if a transcoded copy was added, 0 if the store already held one
+ *         or the product is not compressed, or -1 on failure
+ *
+ * Add a transcoded copy of the message file at `path` to the store, if one is
+ * not already present, in advance of the message being opened.
+ */
+int nexrad_message_store_add(nexrad_message_store *store,
+    const char *path,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup store
+ * \brief Remove transcoded messages from a store to remain within budget
+ * \param store A store object
+ * \return The number of transcoded messages removed, or -1 on failure
+ *
+ * Remove the least recently used transcoded messages from the store until
+ * their total size falls below its budget.  This is performed automatically
+ * as messages are added to the store, but may be called to account for other
+ * processes sharing the same store directory.
+ */
+ssize_t nexrad_message_store_evict(nexrad_message_store *store);
+
+/*!
+ * \ingroup store
+ * \brief Close a store of transcoded product messages
+ * \param store A store object
+ *
+ * Close a store.  Messages opened by way of the store remain valid.
+ */
+void nexrad_message_store_close(nexrad_message_store *store);
+
+#endif /* _NEXRAD_STORE_H */
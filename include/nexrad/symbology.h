@@ -48,8 +48,16 @@ typedef struct _nexrad_symbology_layer {
 
 nexrad_chunk *nexrad_symbology_block_open(nexrad_symbology_block *block);
 
+int nexrad_symbology_block_init(nexrad_chunk *iterator,
+    nexrad_symbology_block *block
+);
+
 nexrad_chunk *nexrad_symbology_block_read_layer(nexrad_chunk *block);
 
+int nexrad_symbology_block_read_layer_init(nexrad_chunk *block,
+    nexrad_chunk *layer
+);
+
 void nexrad_symbology_layer_next_packet(nexrad_chunk *layer, size_t size);
 
 nexrad_packet *nexrad_symbology_layer_peek_packet(nexrad_chunk *layer, size_t *size);
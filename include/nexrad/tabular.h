@@ -67,6 +67,15 @@ typedef struct _nexrad_tabular_text {
 
 nexrad_tabular_text *nexrad_tabular_block_open(nexrad_tabular_block *block);
 
+/*
+ * Prepare the caller-owned text reader in `text` without allocating any
+ * memory.  Returns 0 on success, or -1 on invalid input.  Readers so prepared
+ * must not be passed to nexrad_tabular_block_close().
+ */
+int nexrad_tabular_block_init(nexrad_tabular_text *text,
+    nexrad_tabular_block *block
+);
+
 ssize_t nexrad_tabular_block_read_line(nexrad_tabular_text *text,
     char **data,
     int *page,
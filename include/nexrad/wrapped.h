@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _NEXRAD_WRAPPED_H
+#define _NEXRAD_WRAPPED_H
+
+#include <sys/types.h>
+
+#include <nexrad/message.h>
+
+/*!
+ * \file nexrad/wrapped.h
+ * \brief Reading of NEXRAD Level III product messages in gzip, bzip2 and tar
+ *        containers
+ *
+ * Product messages are often distributed individually wrapped in gzip or
+ * bzip2 compression, or bundled many to a tar file, itself possibly
+ * compressed.  These routines read such messages in a single sequential pass
+ * directly into memory, without unpacking them to temporary files.
+ */
+
+typedef struct _nexrad_message_tar nexrad_message_tar;
+
+/*!
+ * \defgroup wrapped NEXRAD Level III wrapped and bundled message routines
+ */
+
+/*!
+ * \ingroup wrapped
+ * \brief Open a product message file which may be gzip or bzip2 wrapped
+ * \param path Path to a product message file, possibly compressed
+ * \param ctx A decoding context, or NULL
+ * \return An object representing a NEXRAD Level III product message file
+ *
+ * Open the product message file at `path`.  Should the file be compressed
+ * with gzip or bzip2 as a whole, it is decompressed into a buffer lent by
+ * `ctx` as it is read; otherwise, it is opened as per
+ * nexrad_message_open_ctx().
+ */
+nexrad_message *nexrad_message_open_wrapped_ctx(const char *path,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup wrapped
+ * \brief Open a product message file which may be gzip or bzip2 wrapped
+ * \param path Path to a product message file, possibly compressed
+ * \return An object representing a NEXRAD Level III product message file
+ */
+nexrad_message *nexrad_message_open_wrapped(const char *path);
+
+/*!
+ * \ingroup wrapped
+ * \brief Open a tar file of product messages for reading
+ * \param path Path to a tar file, possibly gzip or bzip2 compressed
+ * \param ctx A decoding context used to open each message, or NULL
+ * \return A tar reader object, or NULL on failure
+ *
+ * Open a tar file, which may itself be compressed with gzip or bzip2, such
+ * that the product messages within may be read in order.
+ */
+nexrad_message_tar *nexrad_message_tar_open(const char *path,
+    nexrad_message_ctx *ctx
+);
+
+/*!
+ * \ingroup wrapped
+ * \brief Read the next product message from a tar file
+ * \param tar A tar reader object
+ * \param message Pointer to which the next message is written
+ * \param name Pointer to which the name of the tar member is written, or NULL
+ * \return 1 if a message was read, 0 at the end of the tar file, or -1 on
+ *         failure
+ *
+ * Read the next regular file in a tar file which holds a valid product
+ * message, itself optionally gzip or bzip2 wrapped, skipping any other
+ * members.  The message is read into a buffer lent by the decoding context of
+ * the reader, and is destroyed by the caller as usual.  The member name
+ * written to `name` is valid until the next call.
+ */
+int nexrad_message_tar_read(nexrad_message_tar *tar,
+    nexrad_message **message,
+    const char **name
+);
+
+/*!
+ * \ingroup wrapped
+ * \brief Close a tar reader object
+ * \param tar A tar reader object
+ */
+void nexrad_message_tar_close(nexrad_message_tar *tar);
+
+#endif /* _NEXRAD_WRAPPED_H */
@@ -0,0 +1,519 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "catalog_internal.h"
+#include "message_internal.h"
+
+#include <nexrad/header.h>
+#include <nexrad/archive.h>
+
+#define ARCHIVE_MAGIC         "NXARCHIV"
+#define ARCHIVE_TRAILER_MAGIC "NXARCEND"
+#define ARCHIVE_VERSION       1
+#define ARCHIVE_BYTE_ORDER    0x01020304
+#define ARCHIVE_ALIGNMENT     8
+
+#pragma pack(push)
+#pragma pack(1)
+
+struct archive_header {
+    char     magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t _reserved;
+};
+
+struct archive_trailer {
+    uint64_t catalog_offset; /* Offset of catalog within archive */
+    uint64_t catalog_size;   /* Size of catalog */
+    char     magic[8];
+};
+
+#pragma pack(pop)
+
+struct _nexrad_archive_writer {
+    FILE *           fh;
+    char *           path;
+    char *           tmp;
+    int              flags;
+    int              error; /* errno of a failed write, if any */
+    uint64_t         offset;
+    nexrad_catalog * catalog;
+};
+
+struct _nexrad_archive {
+    uint8_t *        data;
+    size_t           size;
+    size_t           end; /* End of message data, and start of catalog */
+    nexrad_catalog * catalog;
+};
+
+/*
+ * Append data to an archive.  Once any write fails, the position within the
+ * file no longer matches the offset of the writer, and so the writer refuses
+ * any further writes, and the archive is never completed.
+ */
+static int _writer_write(nexrad_archive_writer *writer, const void *buf, size_t len) {
+    if (writer->error) {
+        errno = writer->error;
+
+        return -1;
+    }
+
+    errno = 0;
+
+    if (len > 0 && fwrite(buf, len, 1, writer->fh) != 1) {
+        writer->error = errno = errno? errno: EIO;
+
+        return -1;
+    }
+
+    writer->offset += len;
+
+    return 0;
+}
+
+static int _writer_pad(nexrad_archive_writer *writer, size_t alignment) {
+    static const char zeroes[NEXRAD_ARCHIVE_PAGE_SIZE];
+    size_t pad = (alignment - (writer->offset % alignment)) % alignment;
+
+    return _writer_write(writer, zeroes, pad);
+}
+
+nexrad_archive_writer *nexrad_archive_writer_create(const char *path, int flags) {
+    nexrad_archive_writer *writer;
+    struct archive_header header;
+    size_t len;
+
+    if (path == NULL) {
+        errno = EINVAL;
+
+        goto error_invalid;
+    }
+
+    if ((writer = calloc(1, sizeof(*writer))) == NULL) {
+        goto error_calloc;
+    }
+
+    len = strlen(path) + 32;
+
+    if ((writer->path = strdup(path)) == NULL) {
+        goto error_strdup;
+    }
+
+    if ((writer->tmp = malloc(len)) == NULL) {
+        goto error_malloc_tmp;
+    }
+
+    snprintf(writer->tmp, len, "%s.%d.tmp", path, (int)getpid());
+
+    if ((writer->catalog = catalog_create()) == NULL) {
+        goto error_catalog_create;
+    }
+
+    if ((writer->fh = fopen(writer->tmp, "w")) == NULL) {
+        goto error_fopen;
+    }
+
+    memset(&header, '\0', sizeof(header));
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+
+    header.byte_order = ARCHIVE_BYTE_ORDER;
+    header.version    = ARCHIVE_VERSION;
+    header.flags      = flags;
+
+    if (fwrite(&header, sizeof(header), 1, writer->fh) != 1) {
+        goto error_write;
+    }
+
+    writer->flags  = flags;
+    writer->error  = 0;
+    writer->offset = sizeof(header);
+
+    return writer;
+
+error_write:
+    fclose(writer->fh);
+    unlink(writer->tmp);
+
+error_fopen:
+    nexrad_catalog_close(writer->catalog);
+
+error_catalog_create:
+    free(writer->tmp);
+
+error_malloc_tmp:
+    free(writer->path);
+
+error_strdup:
+    free(writer);
+
+error_calloc:
+error_invalid:
+    return NULL;
+}
+
+int nexrad_archive_writer_add_buf(nexrad_archive_writer *writer, const char *name, const void *buf, size_t len) {
+    nexrad_message_info info;
+    uint64_t offset;
+    size_t expected;
+
+    if (writer == NULL || buf == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (nexrad_message_peek_buf(buf, len, &info) < 0) {
+        return -1;
+    }
+
+    /*
+     * Messages are located within an archive by the size given in their
+     * message header, so ensure that size accounts for the entire buffer,
+     * save for any unknown footer.
+     */
+    expected = message_header_offset(buf, len) + info.size;
+
+    if (len != expected && !(len == expected + 4
+      && memcmp((char *)buf + expected, NEXRAD_MESSAGE_UNKNOWN_FOOTER, 4) == 0)) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (writer->flags & NEXRAD_ARCHIVE_ALIGN) {
+        if (_writer_pad(writer, NEXRAD_ARCHIVE_PAGE_SIZE) < 0) {
+            return -1;
+        }
+    }
+
+    offset = writer->offset;
+
+    /*
+     * Only record the message in the catalog once it has been written in
+     * full, lest the catalog refer to data which is not there.
+     */
+    if (_writer_write(writer, buf, len) < 0) {
+        return -1;
+    }
+
+    if (nexrad_catalog_add_info(writer->catalog, name? name: "", offset, &info) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int nexrad_archive_writer_add_file(nexrad_archive_writer *writer, const char *path) {
+    struct stat st;
+    size_t offset = 0;
+    void *buf;
+    int fd, ret;
+
+    if (writer == NULL || path == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        goto error_fstat;
+    }
+
+    if (st.st_size > NEXRAD_MESSAGE_MAX_SIZE) {
+        errno = EFBIG;
+
+        goto error_efbig;
+    }
+
+    if ((buf = malloc(st.st_size)) == NULL) {
+        goto error_malloc;
+    }
+
+    while (offset < st.st_size) {
+        ssize_t len;
+
+        if ((len = read(fd, (char *)buf + offset, st.st_size - offset)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            goto error_read;
+        } else if (len == 0) {
+            errno = EINVAL;
+
+            goto error_read;
+        }
+
+        offset += len;
+    }
+
+    close(fd);
+
+    ret = nexrad_archive_writer_add_buf(writer, path, buf, st.st_size);
+
+    free(buf);
+
+    return ret;
+
+error_read:
+    free(buf);
+
+error_malloc:
+error_efbig:
+error_fstat:
+    close(fd);
+
+error_open:
+    return -1;
+}
+
+static void _writer_destroy(nexrad_archive_writer *writer) {
+    nexrad_catalog_close(writer->catalog);
+
+    free(writer->tmp);
+    free(writer->path);
+
+    memset(writer, '\0', sizeof(*writer));
+
+    free(writer);
+}
+
+int nexrad_archive_writer_close(nexrad_archive_writer *writer) {
+    struct archive_trailer trailer;
+    ssize_t size;
+
+    if (writer == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (_writer_pad(writer, ARCHIVE_ALIGNMENT) < 0) {
+        goto error_write;
+    }
+
+    if ((size = catalog_write(writer->catalog, writer->fh)) < 0) {
+        goto error_write;
+    }
+
+    memcpy(trailer.magic, ARCHIVE_TRAILER_MAGIC, sizeof(trailer.magic));
+
+    trailer.catalog_offset = writer->offset;
+    trailer.catalog_size   = size;
+
+    if (_writer_write(writer, &trailer, sizeof(trailer)) < 0) {
+        goto error_write;
+    }
+
+    if (fflush(writer->fh) != 0 || fsync(fileno(writer->fh)) < 0) {
+        goto error_write;
+    }
+
+    if (fclose(writer->fh) != 0) {
+        goto error_fclose;
+    }
+
+    if (rename(writer->tmp, writer->path) < 0) {
+        goto error_rename;
+    }
+
+    _writer_destroy(writer);
+
+    return 0;
+
+error_write:
+    fclose(writer->fh);
+
+error_fclose:
+error_rename:
+    unlink(writer->tmp);
+
+    _writer_destroy(writer);
+
+    return -1;
+}
+
+void nexrad_archive_writer_abort(nexrad_archive_writer *writer) {
+    if (writer == NULL) {
+        return;
+    }
+
+    fclose(writer->fh);
+    unlink(writer->tmp);
+
+    _writer_destroy(writer);
+}
+
+nexrad_archive *nexrad_archive_open(const char *path) {
+    nexrad_archive *archive;
+    struct archive_header *header;
+    struct archive_trailer *trailer;
+    struct stat st;
+    int fd;
+
+    if ((archive = calloc(1, sizeof(*archive))) == NULL) {
+        goto error_calloc;
+    }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        goto error_fstat;
+    }
+
+    if (st.st_size < sizeof(*header) + sizeof(*trailer)) {
+        errno = EINVAL;
+
+        goto error_invalid;
+    }
+
+    if ((archive->data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        archive->data = NULL;
+
+        goto error_mmap;
+    }
+
+    archive->size = st.st_size;
+
+    close(fd);
+
+    header  = (struct archive_header *)archive->data;
+    trailer = (struct archive_trailer *)(archive->data + archive->size - sizeof(*trailer));
+
+    if (memcmp(header->magic, ARCHIVE_MAGIC, sizeof(header->magic)) != 0
+      || memcmp(trailer->magic, ARCHIVE_TRAILER_MAGIC, sizeof(trailer->magic)) != 0
+      || header->byte_order != ARCHIVE_BYTE_ORDER
+      || header->version != ARCHIVE_VERSION) {
+        errno = EINVAL;
+
+        goto error_invalid_archive;
+    }
+
+    if (trailer->catalog_offset < sizeof(*header)
+      || trailer->catalog_offset > archive->size - sizeof(*trailer)
+      || trailer->catalog_size != archive->size - sizeof(*trailer) - trailer->catalog_offset) {
+        errno = EINVAL;
+
+        goto error_invalid_archive;
+    }
+
+    archive->end = trailer->catalog_offset;
+
+    if ((archive->catalog = catalog_open_buf(archive->data + trailer->catalog_offset, trailer->catalog_size)) == NULL) {
+        goto error_catalog_open;
+    }
+
+    return archive;
+
+error_catalog_open:
+error_invalid_archive:
+    nexrad_archive_close(archive);
+
+    return NULL;
+
+error_mmap:
+error_invalid:
+error_fstat:
+    close(fd);
+
+error_open:
+    free(archive);
+
+error_calloc:
+    return NULL;
+}
+
+nexrad_catalog *nexrad_archive_get_catalog(nexrad_archive *archive) {
+    if (archive == NULL) {
+        return NULL;
+    }
+
+    return archive->catalog;
+}
+
+nexrad_message *nexrad_archive_open_message(nexrad_archive *archive, const nexrad_catalog_entry *entry, nexrad_message_ctx *ctx) {
+    uint8_t *buf;
+    size_t len;
+
+    if (archive == NULL || entry == NULL) {
+        errno = EINVAL;
+
+        return NULL;
+    }
+
+    if (entry->offset >= archive->end) {
+        errno = EINVAL;
+
+        return NULL;
+    }
+
+    buf = archive->data + entry->offset;
+    len = message_header_offset(buf, archive->end - entry->offset) + entry->size;
+
+    if (len > archive->end - entry->offset) {
+        errno = EINVAL;
+
+        return NULL;
+    }
+
+    if (len + 4 <= archive->end - entry->offset
+      && memcmp(buf + len, NEXRAD_MESSAGE_UNKNOWN_FOOTER, 4) == 0) {
+        len += 4;
+    }
+
+    return nexrad_message_open_buf_ctx(buf, len, ctx);
+}
+
+void nexrad_archive_close(nexrad_archive *archive) {
+    if (archive == NULL) {
+        return;
+    }
+
+    nexrad_catalog_close(archive->catalog);
+
+    if (archive->data) {
+        munmap(archive->data, archive->size);
+    }
+
+    memset(archive, '\0', sizeof(*archive));
+
+    free(archive);
+}
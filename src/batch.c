@@ -0,0 +1,1003 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "util.h"
+#include "message_internal.h"
+
+#ifdef HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/stat.h>
+#include <linux/io_uring.h>
+
+#ifndef AT_EMPTY_PATH
+#define AT_EMPTY_PATH 0x1000
+#endif /* AT_EMPTY_PATH */
+#endif /* HAVE_IO_URING */
+
+#include <nexrad/batch.h>
+
+struct batch_result {
+    size_t index;
+    void * buf;
+    size_t size;
+    int    error;
+};
+
+#ifdef HAVE_IO_URING
+enum batch_slot_state {
+    BATCH_SLOT_FREE,
+    BATCH_SLOT_OPEN,
+    BATCH_SLOT_STAT,
+    BATCH_SLOT_READ,
+    BATCH_SLOT_CLOSE
+};
+
+struct batch_slot {
+    enum batch_slot_state state;
+    int                   inflight; /* Used only when recovering from failure */
+
+    size_t       index;
+    int          fd;
+    struct statx stx;
+    void *       buf;
+    size_t       size;
+    size_t       offset;
+};
+
+struct batch_ring {
+    int fd;
+
+    unsigned int *        sq_head;
+    unsigned int *        sq_tail;
+    unsigned int *        sq_mask;
+    unsigned int *        sq_array;
+    struct io_uring_sqe * sqes;
+
+    unsigned int *        cq_head;
+    unsigned int *        cq_tail;
+    unsigned int *        cq_mask;
+    struct io_uring_cqe * cqes;
+
+    void * sq_ptr;
+    size_t sq_len;
+    void * cq_ptr;
+    size_t cq_len;
+    size_t sqes_len;
+
+    unsigned int tail;    /* Tail of submission queue, once entries queued */
+    unsigned int pending; /* Entries queued but not yet submitted */
+};
+#endif /* HAVE_IO_URING */
+
+struct _nexrad_message_batch {
+    nexrad_message_ctx *              ctx;
+    enum nexrad_message_batch_backend backend;
+    int                               depth;
+
+#ifdef HAVE_IO_URING
+    struct batch_ring ring;
+#endif /* HAVE_IO_URING */
+};
+
+/*
+ * Open the message whose file contents were read into `result`, and hand it
+ * to the caller.  Returns 1 if a message was opened, or 0 otherwise.
+ */
+static int _batch_deliver(nexrad_message_batch *batch, struct batch_result *result, const char **paths, nexrad_message_batch_callback callback, void *data) {
+    nexrad_message *message = NULL;
+    int error = result->error;
+
+    if (error == 0) {
+        /*
+         * Not every way in which a message may fail to open sets errno, so
+         * clear it beforehand, rather than report a stale error.
+         */
+        errno = 0;
+
+        if ((message = message_open_decoded(result->buf, result->size, NULL, 0, 0, batch->ctx)) == NULL) {
+            error = errno? errno: EINVAL;
+
+            free(result->buf);
+        }
+    }
+
+    result->buf = NULL;
+
+    callback(message, paths[result->index], result->index, error, data);
+
+    return message != NULL;
+}
+
+static int _batch_check_size(size_t size) {
+    if (size > NEXRAD_MESSAGE_MAX_SIZE) {
+        return EFBIG;
+    }
+
+    if (size < MESSAGE_MIN_SIZE) {
+        return EINVAL;
+    }
+
+    return 0;
+}
+
+/*
+ * Allocate a buffer for the contents of a file of `size` bytes, followed by
+ * the zeroed slack expected of message data read from a file.
+ */
+static void *_batch_buf(size_t size) {
+    void *buf;
+
+    if ((buf = malloc(size + MESSAGE_READ_SLACK)) == NULL) {
+        return NULL;
+    }
+
+    memset((char *)buf + size, '\0', MESSAGE_READ_SLACK);
+
+    return buf;
+}
+
+#ifdef HAVE_IO_URING
+static int _ring_setup(struct batch_ring *ring, int depth) {
+    struct io_uring_params params;
+    struct io_uring_probe *probe;
+    size_t probe_size = sizeof(*probe) + 256 * sizeof(struct io_uring_probe_op);
+    int ops[] = {
+        IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE
+    };
+    size_t i;
+
+    memset(ring, '\0', sizeof(*ring));
+    memset(&params, '\0', sizeof(params));
+
+    if ((ring->fd = syscall(__NR_io_uring_setup, depth, &params)) < 0) {
+        goto error_setup;
+    }
+
+    /*
+     * Make sure the running kernel supports every operation needed to open
+     * and read a file, which were not all introduced at once.
+     */
+    if ((probe = calloc(1, probe_size)) == NULL) {
+        goto error_probe_alloc;
+    }
+
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        goto error_probe;
+    }
+
+    for (i=0; i<sizeof(ops) / sizeof(ops[0]); i++) {
+        if (ops[i] > probe->last_op || !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED)) {
+            errno = ENOSYS;
+
+            goto error_probe;
+        }
+    }
+
+    free(probe);
+
+    ring->sq_len   = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cq_len   = params.cq_off.cqes  + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_len > ring->sq_len) {
+            ring->sq_len = ring->cq_len;
+        }
+
+        ring->cq_len = 0;
+    }
+
+    if ((ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING)) == MAP_FAILED) {
+        goto error_mmap_sq;
+    }
+
+    if (ring->cq_len == 0) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else if ((ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING)) == MAP_FAILED) {
+        goto error_mmap_cq;
+    }
+
+    if ((ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES)) == MAP_FAILED) {
+        goto error_mmap_sqes;
+    }
+
+    ring->sq_head  = (unsigned int *)((char *)ring->sq_ptr + params.sq_off.head);
+    ring->sq_tail  = (unsigned int *)((char *)ring->sq_ptr + params.sq_off.tail);
+    ring->sq_mask  = (unsigned int *)((char *)ring->sq_ptr + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned int *)((char *)ring->sq_ptr + params.sq_off.array);
+
+    ring->cq_head  = (unsigned int *)((char *)ring->cq_ptr + params.cq_off.head);
+    ring->cq_tail  = (unsigned int *)((char *)ring->cq_ptr + params.cq_off.tail);
+    ring->cq_mask  = (unsigned int *)((char *)ring->cq_ptr + params.cq_off.ring_mask);
+    ring->cqes     = (struct io_uring_cqe *)((char *)ring->cq_ptr + params.cq_off.cqes);
+
+    ring->tail    = *ring->sq_tail;
+    ring->pending = 0;
+
+    return 0;
+
+error_mmap_sqes:
+    if (ring->cq_len) {
+        munmap(ring->cq_ptr, ring->cq_len);
+    }
+
+error_mmap_cq:
+    munmap(ring->sq_ptr, ring->sq_len);
+
+error_mmap_sq:
+    close(ring->fd);
+
+    ring->fd = -1;
+
+    return -1;
+
+error_probe:
+    free(probe);
+
+error_probe_alloc:
+    close(ring->fd);
+
+error_setup:
+    ring->fd = -1;
+
+    return -1;
+}
+
+static void _ring_teardown(struct batch_ring *ring) {
+    if (ring->fd < 0) {
+        return;
+    }
+
+    munmap(ring->sqes, ring->sqes_len);
+
+    if (ring->cq_len) {
+        munmap(ring->cq_ptr, ring->cq_len);
+    }
+
+    munmap(ring->sq_ptr, ring->sq_len);
+
+    close(ring->fd);
+
+    ring->fd = -1;
+}
+
+/*
+ * Obtain the next free submission queue entry.  As every slot has at most one
+ * operation in flight, and the submission queue has at least one entry per
+ * slot, the queue can never be full.
+ */
+static struct io_uring_sqe *_ring_sqe(struct batch_ring *ring, struct batch_slot *slot, int op) {
+    unsigned int index = ring->tail++ & *ring->sq_mask;
+
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, '\0', sizeof(*sqe));
+
+    sqe->opcode    = op;
+    sqe->user_data = (uint64_t)(uintptr_t)slot;
+
+    ring->sq_array[index] = index;
+    ring->pending++;
+
+    return sqe;
+}
+
+static int _ring_enter(struct batch_ring *ring, unsigned int wait) {
+    int ret;
+
+    __atomic_store_n(ring->sq_tail, ring->tail, __ATOMIC_RELEASE);
+
+    for (;;) {
+        if ((ret = syscall(__NR_io_uring_enter, ring->fd, ring->pending, wait, IORING_ENTER_GETEVENTS, NULL, 0)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -1;
+        }
+
+        ring->pending -= ret;
+
+        return 0;
+    }
+}
+
+static void _slot_open(struct batch_ring *ring, struct batch_slot *slot, int dirfd, const char *path) {
+    struct io_uring_sqe *sqe = _ring_sqe(ring, slot, IORING_OP_OPENAT);
+
+    sqe->fd         = dirfd;
+    sqe->addr       = (uint64_t)(uintptr_t)path;
+    sqe->open_flags = O_RDONLY;
+
+    slot->state = BATCH_SLOT_OPEN;
+}
+
+static void _slot_stat(struct batch_ring *ring, struct batch_slot *slot) {
+    struct io_uring_sqe *sqe = _ring_sqe(ring, slot, IORING_OP_STATX);
+
+    sqe->fd          = slot->fd;
+    sqe->addr        = (uint64_t)(uintptr_t)"";
+    sqe->len         = STATX_SIZE;
+    sqe->off         = (uint64_t)(uintptr_t)&slot->stx;
+    sqe->statx_flags = AT_EMPTY_PATH;
+
+    slot->state = BATCH_SLOT_STAT;
+}
+
+static void _slot_read(struct batch_ring *ring, struct batch_slot *slot) {
+    struct io_uring_sqe *sqe = _ring_sqe(ring, slot, IORING_OP_READ);
+
+    sqe->fd   = slot->fd;
+    sqe->addr = (uint64_t)(uintptr_t)((char *)slot->buf + slot->offset);
+    sqe->len  = slot->size - slot->offset;
+    sqe->off  = slot->offset;
+
+    slot->state = BATCH_SLOT_READ;
+}
+
+static void _slot_close(struct batch_ring *ring, struct batch_slot *slot) {
+    struct io_uring_sqe *sqe = _ring_sqe(ring, slot, IORING_OP_CLOSE);
+
+    sqe->fd = slot->fd;
+
+    slot->state = BATCH_SLOT_CLOSE;
+}
+
+/*
+ * Advance a slot to its next operation upon completion of its previous one.
+ * Once the file has been read in its entirety, or has failed, its result is
+ * written to `result`, and 1 is returned.
+ */
+static int _slot_complete(struct batch_ring *ring, struct batch_slot *slot, int res, struct batch_result *result) {
+    result->index = slot->index;
+    result->buf   = NULL;
+    result->size  = 0;
+    result->error = 0;
+
+    switch (slot->state) {
+        case BATCH_SLOT_OPEN: {
+            if (res < 0) {
+                result->error = -res;
+                slot->state   = BATCH_SLOT_FREE;
+
+                return 1;
+            }
+
+            slot->fd = res;
+
+            _slot_stat(ring, slot);
+
+            return 0;
+        }
+
+        case BATCH_SLOT_STAT: {
+            if (res < 0) {
+                result->error = -res;
+
+                break;
+            }
+
+            if ((result->error = _batch_check_size(slot->stx.stx_size)) != 0) {
+                break;
+            }
+
+            slot->size   = slot->stx.stx_size;
+            slot->offset = 0;
+
+            if ((slot->buf = _batch_buf(slot->size)) == NULL) {
+                result->error = ENOMEM;
+
+                break;
+            }
+
+            _slot_read(ring, slot);
+
+            return 0;
+        }
+
+        case BATCH_SLOT_READ: {
+            if (res <= 0) {
+                result->error = res < 0? -res: EINVAL;
+
+                free(slot->buf);
+
+                slot->buf = NULL;
+
+                break;
+            }
+
+            slot->offset += res;
+
+            if (slot->offset < slot->size) {
+                _slot_read(ring, slot);
+
+                return 0;
+            }
+
+            result->buf  = slot->buf;
+            result->size = slot->size;
+
+            slot->buf = NULL;
+
+            break;
+        }
+
+        case BATCH_SLOT_CLOSE: {
+            slot->state = BATCH_SLOT_FREE;
+
+            return 0;
+        }
+
+        default: {
+            return 0;
+        }
+    }
+
+    /*
+     * The file has either been read or has failed; either way, the slot
+     * remains occupied until its file descriptor is closed.
+     */
+    _slot_close(ring, slot);
+
+    return 1;
+}
+
+/*
+ * Recover every slot from a ring which has failed to accept operations.
+ * Operations queued but not yet submitted are withdrawn, and those already
+ * submitted are waited upon, such that afterwards the state of each slot
+ * reflects what has actually been done: slots still in BATCH_SLOT_OPEN hold
+ * no file, while those in any other state besides BATCH_SLOT_FREE hold an
+ * open file descriptor.  Should the ring fail while waiting, the `inflight`
+ * flag is left set on every slot whose operation may yet complete.
+ */
+static void _ring_drain(struct batch_ring *ring, struct batch_slot *slots, int depth) {
+    size_t inflight = 0;
+    int i;
+
+    for (i=0; i<depth; i++) {
+        slots[i].inflight = slots[i].state != BATCH_SLOT_FREE;
+    }
+
+    /*
+     * As the kernel has not consumed the entries queued since the last
+     * successful submission, they may simply be taken back off the queue.
+     */
+    for (; ring->pending > 0; ring->pending--) {
+        struct io_uring_sqe *sqe = &ring->sqes[--ring->tail & *ring->sq_mask];
+
+        ((struct batch_slot *)(uintptr_t)sqe->user_data)->inflight = 0;
+    }
+
+    __atomic_store_n(ring->sq_tail, ring->tail, __ATOMIC_RELEASE);
+
+    for (i=0; i<depth; i++) {
+        inflight += slots[i].inflight;
+    }
+
+    while (inflight > 0) {
+        unsigned int head = *ring->cq_head,
+                     tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+        if (head == tail) {
+            if (syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR) {
+                return;
+            }
+
+            continue;
+        }
+
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            struct batch_slot *slot  = (struct batch_slot *)(uintptr_t)cqe->user_data;
+
+            slot->inflight = 0;
+            inflight--;
+
+            if (slot->state == BATCH_SLOT_OPEN && cqe->res >= 0) {
+                slot->fd    = cqe->res;
+                slot->state = BATCH_SLOT_STAT;
+            } else if (slot->state == BATCH_SLOT_CLOSE) {
+                slot->state = BATCH_SLOT_FREE;
+            }
+        }
+
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+
+static ssize_t _batch_open_ring(nexrad_message_batch *batch, int dirfd, const char **paths, size_t count, nexrad_message_batch_callback callback, void *data) {
+    struct batch_ring *ring = &batch->ring;
+    struct batch_slot *slots;
+    struct batch_result *results;
+    size_t next = 0, busy = 0, ready = 0, r;
+    ssize_t opened = 0;
+    int i, error;
+
+    if ((slots = calloc(batch->depth, sizeof(*slots))) == NULL) {
+        goto error_calloc_slots;
+    }
+
+    if ((results = calloc(batch->depth, sizeof(*results))) == NULL) {
+        goto error_calloc_results;
+    }
+
+    while (next < count || busy > 0) {
+        unsigned int head, tail;
+
+        ready = 0;
+
+        for (i=0; i<batch->depth && next < count; i++) {
+            if (slots[i].state != BATCH_SLOT_FREE) {
+                continue;
+            }
+
+            slots[i].index = next;
+
+            _slot_open(ring, &slots[i], dirfd, paths[next++]);
+
+            busy++;
+        }
+
+        if (_ring_enter(ring, 1) < 0) {
+            goto error_ring_enter;
+        }
+
+        head = *ring->cq_head;
+        tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            struct batch_slot *slot  = (struct batch_slot *)(uintptr_t)cqe->user_data;
+
+            if (_slot_complete(ring, slot, cqe->res, &results[ready])) {
+                ready++;
+            }
+
+            if (slot->state == BATCH_SLOT_FREE) {
+                busy--;
+            }
+        }
+
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+        /*
+         * Get the operations which follow on from those just completed under
+         * way before decoding any messages read, so that the kernel may
+         * perform them in the meantime.
+         */
+        if (ready > 0 && ring->pending > 0) {
+            if (_ring_enter(ring, 0) < 0) {
+                goto error_ring_enter;
+            }
+        }
+
+        for (r=0; r<ready; r++) {
+            opened += _batch_deliver(batch, &results[r], paths, callback, data);
+        }
+    }
+
+    free(results);
+    free(slots);
+
+    return opened;
+
+error_ring_enter:
+    error = errno? errno: EIO;
+
+    /*
+     * The ring can no longer be relied upon to carry out any further
+     * operations, so wait for those already under way, then tear it down and
+     * finish each file by hand: files read in full are delivered as usual,
+     * while every other file, including those never started, is reported to
+     * the callback as having failed.
+     */
+    _ring_drain(ring, slots, batch->depth);
+
+    _ring_teardown(ring);
+
+    batch->backend = NEXRAD_MESSAGE_BATCH_THREADS;
+
+    for (r=0; r<ready; r++) {
+        opened += _batch_deliver(batch, &results[r], paths, callback, data);
+    }
+
+    for (i=0; i<batch->depth; i++) {
+        struct batch_slot *slot = &slots[i];
+
+        if (slot->state == BATCH_SLOT_FREE) {
+            continue;
+        }
+
+        /*
+         * Should the ring have failed while waiting, the file descriptor of
+         * an operation still in flight may yet be closed, or a read may yet
+         * be made into its buffer, so both are left be.
+         */
+        if (slot->state != BATCH_SLOT_OPEN && !(slot->inflight && slot->state == BATCH_SLOT_CLOSE)) {
+            close(slot->fd);
+        }
+
+        if (!slot->inflight) {
+            free(slot->buf);
+        }
+
+        if (slot->state != BATCH_SLOT_CLOSE) {
+            callback(NULL, paths[slot->index], slot->index, error, data);
+        }
+    }
+
+    for (; next < count; next++) {
+        callback(NULL, paths[next], next, error, data);
+    }
+
+    free(results);
+    free(slots);
+
+    errno = error;
+
+    return -1;
+
+error_calloc_results:
+    free(slots);
+
+error_calloc_slots:
+    return -1;
+}
+#endif /* HAVE_IO_URING */
+
+struct batch_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t  ready;
+    pthread_cond_t  space;
+
+    int          dirfd;
+    const char **paths;
+    size_t       count;
+    size_t       next;
+
+    struct batch_result * results; /* Ring of files read, awaiting delivery */
+    size_t                size;
+    size_t                head;
+    size_t                queued;
+};
+
+static int _batch_read_file(int dirfd, const char *path, void **bufp, size_t *sizep) {
+    struct stat st;
+    size_t offset = 0;
+    void *buf;
+    int fd, error;
+
+    if ((fd = openat(dirfd, path, O_RDONLY)) < 0) {
+        error = errno;
+
+        goto error_open;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        error = errno;
+
+        goto error_fstat;
+    }
+
+    if ((error = _batch_check_size(st.st_size)) != 0) {
+        goto error_check_size;
+    }
+
+    if ((buf = _batch_buf(st.st_size)) == NULL) {
+        error = ENOMEM;
+
+        goto error_buf;
+    }
+
+    while (offset < st.st_size) {
+        ssize_t len;
+
+        if ((len = pread(fd, (char *)buf + offset, st.st_size - offset, offset)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            error = errno;
+
+            goto error_pread;
+        } else if (len == 0) {
+            error = EINVAL;
+
+            goto error_pread;
+        }
+
+        offset += len;
+    }
+
+    close(fd);
+
+    *bufp  = buf;
+    *sizep = st.st_size;
+
+    return 0;
+
+error_pread:
+    free(buf);
+
+error_buf:
+error_check_size:
+error_fstat:
+    close(fd);
+
+error_open:
+    return error;
+}
+
+static void *_batch_worker(void *data) {
+    struct batch_pool *pool = data;
+
+    for (;;) {
+        struct batch_result result;
+
+        pthread_mutex_lock(&pool->lock);
+
+        if (pool->next == pool->count) {
+            pthread_mutex_unlock(&pool->lock);
+
+            break;
+        }
+
+        result.index = pool->next++;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        result.buf   = NULL;
+        result.size  = 0;
+        result.error = _batch_read_file(pool->dirfd, pool->paths[result.index], &result.buf, &result.size);
+
+        pthread_mutex_lock(&pool->lock);
+
+        while (pool->queued == pool->size) {
+            pthread_cond_wait(&pool->space, &pool->lock);
+        }
+
+        pool->results[(pool->head + pool->queued++) % pool->size] = result;
+
+        pthread_cond_signal(&pool->ready);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+/*
+ * Read and open each file in turn on the calling thread, for want of any
+ * worker threads to read them in the background.
+ */
+static ssize_t _batch_open_serial(nexrad_message_batch *batch, int dirfd, const char **paths, size_t count, nexrad_message_batch_callback callback, void *data) {
+    ssize_t opened = 0;
+    size_t i;
+
+    for (i=0; i<count; i++) {
+        struct batch_result result;
+
+        result.index = i;
+        result.buf   = NULL;
+        result.size  = 0;
+        result.error = _batch_read_file(dirfd, paths[i], &result.buf, &result.size);
+
+        opened += _batch_deliver(batch, &result, paths, callback, data);
+    }
+
+    return opened;
+}
+
+static ssize_t _batch_open_threads(nexrad_message_batch *batch, int dirfd, const char **paths, size_t count, nexrad_message_batch_callback callback, void *data) {
+    struct batch_pool pool;
+    pthread_t *workers;
+    size_t done = 0;
+    ssize_t opened = 0;
+    int threads = batch->depth, started, i;
+
+    if (count < (size_t)threads) {
+        threads = count;
+    }
+
+    pool.dirfd  = dirfd;
+    pool.paths  = paths;
+    pool.count  = count;
+    pool.next   = 0;
+    pool.size   = batch->depth;
+    pool.head   = 0;
+    pool.queued = 0;
+
+    if ((pool.results = calloc(pool.size, sizeof(*pool.results))) == NULL) {
+        goto error_calloc_results;
+    }
+
+    if ((workers = calloc(threads, sizeof(*workers))) == NULL) {
+        goto error_calloc_workers;
+    }
+
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.ready, NULL);
+    pthread_cond_init(&pool.space, NULL);
+
+    for (started=0; started<threads; started++) {
+        if (pthread_create(&workers[started], NULL, _batch_worker, &pool) != 0) {
+            break;
+        }
+    }
+
+    if (started == 0 && count > 0) {
+        goto error_pthread_create;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+
+    while (done < count) {
+        struct batch_result result;
+
+        while (pool.queued == 0) {
+            pthread_cond_wait(&pool.ready, &pool.lock);
+        }
+
+        result = pool.results[pool.head];
+
+        pool.head = (pool.head + 1) % pool.size;
+        pool.queued--;
+
+        pthread_cond_signal(&pool.space);
+        pthread_mutex_unlock(&pool.lock);
+
+        opened += _batch_deliver(batch, &result, paths, callback, data);
+        done++;
+
+        pthread_mutex_lock(&pool.lock);
+    }
+
+    pthread_mutex_unlock(&pool.lock);
+
+    for (i=0; i<started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool.space);
+    pthread_cond_destroy(&pool.ready);
+    pthread_mutex_destroy(&pool.lock);
+
+    free(workers);
+    free(pool.results);
+
+    return opened;
+
+error_pthread_create:
+    pthread_cond_destroy(&pool.space);
+    pthread_cond_destroy(&pool.ready);
+    pthread_mutex_destroy(&pool.lock);
+
+    free(workers);
+
+error_calloc_workers:
+    free(pool.results);
+
+error_calloc_results:
+    /*
+     * Should no worker threads be available, carry on without them, so that
+     * the callback is still called once for every file.
+     */
+    return _batch_open_serial(batch, dirfd, paths, count, callback, data);
+}
+
+nexrad_message_batch *nexrad_message_batch_create(nexrad_message_ctx *ctx, enum nexrad_message_batch_backend backend, int depth) {
+    nexrad_message_batch *batch;
+
+    if (depth < 0) {
+        errno = EINVAL;
+
+        goto error_invalid_depth;
+    }
+
+    if ((batch = malloc(sizeof(*batch))) == NULL) {
+        goto error_malloc;
+    }
+
+    batch->ctx     = ctx;
+    batch->backend = NEXRAD_MESSAGE_BATCH_THREADS;
+    batch->depth   = depth? depth: NEXRAD_MESSAGE_BATCH_DEFAULT_DEPTH;
+
+#ifdef HAVE_IO_URING
+    batch->ring.fd = -1;
+
+    if (backend != NEXRAD_MESSAGE_BATCH_THREADS) {
+        if (_ring_setup(&batch->ring, batch->depth) == 0) {
+            batch->backend = NEXRAD_MESSAGE_BATCH_IO_URING;
+        }
+    }
+#endif /* HAVE_IO_URING */
+
+    if (backend == NEXRAD_MESSAGE_BATCH_IO_URING && batch->backend != backend) {
+        errno = ENOSYS;
+
+        goto error_io_uring;
+    }
+
+    return batch;
+
+error_io_uring:
+    free(batch);
+
+error_malloc:
+error_invalid_depth:
+    return NULL;
+}
+
+enum nexrad_message_batch_backend nexrad_message_batch_get_backend(nexrad_message_batch *batch) {
+    if (batch == NULL) {
+        return NEXRAD_MESSAGE_BATCH_AUTO;
+    }
+
+    return batch->backend;
+}
+
+ssize_t nexrad_message_batch_openat(nexrad_message_batch *batch, int dirfd, const char **paths, size_t count, nexrad_message_batch_callback callback, void *data) {
+    if (batch == NULL || (paths == NULL && count > 0) || callback == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+#ifdef HAVE_IO_URING
+    if (batch->backend == NEXRAD_MESSAGE_BATCH_IO_URING) {
+        return _batch_open_ring(batch, dirfd, paths, count, callback, data);
+    }
+#endif /* HAVE_IO_URING */
+
+    return _batch_open_threads(batch, dirfd, paths, count, callback, data);
+}
+
+ssize_t nexrad_message_batch_open(nexrad_message_batch *batch, const char **paths, size_t count, nexrad_message_batch_callback callback, void *data) {
+    return nexrad_message_batch_openat(batch, AT_FDCWD, paths, count, callback, data);
+}
+
+void nexrad_message_batch_destroy(nexrad_message_batch *batch) {
+    if (batch == NULL) {
+        return;
+    }
+
+#ifdef HAVE_IO_URING
+    _ring_teardown(&batch->ring);
+#endif /* HAVE_IO_URING */
+
+    memset(batch, '\0', sizeof(*batch));
+
+    free(batch);
+}
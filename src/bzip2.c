@@ -0,0 +1,566 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <bzlib.h>
+
+#include "bzip2.h"
+
+#define BZIP2_HEADER_SIZE 4
+#define BZIP2_MAGIC_BITS  48
+#define BZIP2_CRC_BITS    32
+#define BZIP2_MAGIC_MASK  0xffffffffffffULL
+#define BZIP2_BLOCK_MAGIC 0x314159265359ULL
+#define BZIP2_END_MAGIC   0x177245385090ULL
+
+/*
+ * The uncompressed size of a bzip2 block is at most the block size indicated
+ * in the stream header, in units of 100,000 bytes, prior to the initial run
+ * length encoding stage; this is used as a starting point for the size of
+ * per-block output buffers, which are grown as needed.
+ */
+#define BZIP2_BLOCK_SIZE_UNIT 100000
+
+struct bzip2_block {
+    uint64_t start; /* Bit offset of block magic within stream */
+    uint64_t end;   /* Bit offset of the magic following the block */
+
+    void * in;      /* Standalone stream holding only this block */
+    size_t insize;  /* Size of buffer holding standalone stream */
+    void * out;     /* Decompressed data, if not written to destination */
+    size_t outsize; /* Size of buffer holding decompressed data */
+    size_t outlen;  /* Number of bytes decompressed */
+    int    error;
+};
+
+struct bzip2_job {
+    uint8_t * src;
+    size_t    srclen;
+    void *    dest;
+    size_t    limit;
+
+    struct bzip2_block * blocks;
+    size_t               count;
+    size_t               next;
+};
+
+/*
+ * Worker threads, and the per-block buffers they decompress into, are kept
+ * between calls so that neither threads nor buffers need be created anew for
+ * each message.
+ */
+struct _bzip2_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t  work; /* Signalled when a new job is posted */
+    pthread_cond_t  idle; /* Signalled when the last busy worker finishes */
+
+    pthread_t * workers;
+    int         started;
+    int         busy;       /* Workers currently taking blocks from the job */
+    unsigned    generation; /* Incremented for each job posted */
+    int         stop;
+
+    struct bzip2_job job;
+    size_t           size; /* Number of block slots allocated */
+};
+
+static uint32_t _read_bits(uint8_t *src, uint64_t offset, int bits) {
+    uint32_t ret = 0;
+    int i;
+
+    for (i=0; i<bits; i++, offset++) {
+        ret = (ret << 1) | ((src[offset >> 3] >> (7 - (offset & 7))) & 1);
+    }
+
+    return ret;
+}
+
+static void _write_bits(uint8_t *dest, uint64_t *offset, uint64_t value, int bits) {
+    int i;
+
+    for (i=bits-1; i>=0; i--, (*offset)++) {
+        if ((value >> i) & 1) {
+            dest[*offset >> 3] |= 0x80 >> (*offset & 7);
+        }
+    }
+}
+
+/*
+ * Locate the bit offsets of every block within a bzip2 stream, as well as the
+ * offset of the end-of-stream marker.  As the block and end-of-stream magic
+ * numbers are not byte aligned, and may in principle occur by chance within
+ * the Huffman coded data of a block, the stream CRC, a combination of the CRC
+ * of every block, is verified against the blocks found.  The block slots in
+ * `blocksp`, of which `*sizep` are allocated, are grown as needed; buffers
+ * held by existing slots are retained for reuse.
+ */
+static ssize_t _find_blocks(uint8_t *src, size_t srclen, struct bzip2_block **blocksp, size_t *sizep) {
+    struct bzip2_block *blocks = *blocksp;
+    size_t count = 0, size = *sizep, i;
+    uint64_t reg = 0;
+    uint32_t crc = 0;
+
+    if (srclen < BZIP2_HEADER_SIZE || memcmp(src, "BZh", 3) != 0
+      || src[3] < '1' || src[3] > '9') {
+        goto error_bad_header;
+    }
+
+    for (i=BZIP2_HEADER_SIZE; i<srclen; i++) {
+        int shift;
+
+        reg = (reg << 8) | src[i];
+
+        if (i < BZIP2_HEADER_SIZE + BZIP2_MAGIC_BITS / 8 - 1) {
+            continue;
+        }
+
+        for (shift=7; shift>=0; shift--) {
+            uint64_t magic  = (reg >> shift) & BZIP2_MAGIC_MASK;
+            uint64_t offset = (uint64_t)(i + 1) * 8 - shift - BZIP2_MAGIC_BITS;
+
+            if (magic == BZIP2_BLOCK_MAGIC) {
+                if (count == size) {
+                    struct bzip2_block *tmp;
+                    size_t newsize = size? size * 2: 16;
+
+                    if ((tmp = realloc(blocks, newsize * sizeof(*blocks))) == NULL) {
+                        goto error_realloc;
+                    }
+
+                    memset(tmp + size, '\0', (newsize - size) * sizeof(*blocks));
+
+                    blocks = tmp;
+                    size   = newsize;
+
+                    *blocksp = blocks;
+                    *sizep   = size;
+                }
+
+                if (count > 0) {
+                    blocks[count-1].end = offset;
+                }
+
+                blocks[count].start  = offset;
+                blocks[count].outlen = 0;
+                blocks[count].error  = 0;
+
+                count++;
+            } else if (magic == BZIP2_END_MAGIC) {
+                if (count == 0 || offset + BZIP2_MAGIC_BITS + BZIP2_CRC_BITS > (uint64_t)srclen * 8) {
+                    goto error_bad_stream;
+                }
+
+                blocks[count-1].end = offset;
+
+                goto found_end;
+            }
+        }
+    }
+
+    goto error_bad_stream;
+
+found_end:
+    if (blocks[0].start != BZIP2_HEADER_SIZE * 8) {
+        goto error_bad_stream;
+    }
+
+    for (i=0; i<count; i++) {
+        crc = ((crc << 1) | (crc >> 31))
+            ^ _read_bits(src, blocks[i].start + BZIP2_MAGIC_BITS, BZIP2_CRC_BITS);
+    }
+
+    if (crc != _read_bits(src, blocks[count-1].end + BZIP2_MAGIC_BITS, BZIP2_CRC_BITS)) {
+        goto error_bad_stream;
+    }
+
+    return count;
+
+error_bad_stream:
+error_realloc:
+error_bad_header:
+    return -1;
+}
+
+/*
+ * Produce a standalone bzip2 stream containing only the block given, so that
+ * it may be decompressed independently of any other block.  As the stream
+ * CRC of a stream with a single block is equal to that of the block itself,
+ * the block CRC is simply repeated after the end-of-stream marker.  The
+ * stream is written to the block's own buffer, which is grown as needed.
+ */
+static void *_block_stream(uint8_t *src, struct bzip2_block *block, size_t *lenp) {
+    uint64_t bits = block->end - block->start,
+             offset = BZIP2_HEADER_SIZE * 8;
+
+    size_t len = BZIP2_HEADER_SIZE
+        + (bits + BZIP2_MAGIC_BITS + BZIP2_CRC_BITS + 7) / 8;
+
+    size_t bytes = bits / 8, i;
+    uint8_t *stream, *from = src + (block->start >> 3);
+    int shift = block->start & 7;
+
+    if (block->insize < len) {
+        free(block->in);
+
+        block->insize = 0;
+
+        if ((block->in = malloc(len)) == NULL) {
+            return NULL;
+        }
+
+        block->insize = len;
+    }
+
+    stream = block->in;
+
+    memset(stream, '\0', len);
+    memcpy(stream, src, BZIP2_HEADER_SIZE);
+
+    if (shift == 0) {
+        memcpy(stream + BZIP2_HEADER_SIZE, from, bytes);
+    } else {
+        for (i=0; i<bytes; i++) {
+            stream[BZIP2_HEADER_SIZE + i] = (from[i] << shift) | (from[i+1] >> (8 - shift));
+        }
+    }
+
+    offset += bytes * 8;
+
+    _write_bits(stream, &offset,
+        _read_bits(src, block->start + bytes * 8, bits % 8), bits % 8);
+
+    _write_bits(stream, &offset, BZIP2_END_MAGIC, BZIP2_MAGIC_BITS);
+
+    _write_bits(stream, &offset,
+        _read_bits(src, block->start + BZIP2_MAGIC_BITS, BZIP2_CRC_BITS), BZIP2_CRC_BITS);
+
+    *lenp = len;
+
+    return stream;
+}
+
+/*
+ * Decompress a single block.  The first block of the stream always begins at
+ * the start of the output, and so is decompressed directly into the
+ * destination; the output offset of every other block depends on the size of
+ * the blocks preceding it, and so these are decompressed into buffers of
+ * their own and copied into place afterwards.
+ */
+static int _block_decompress(struct bzip2_job *job, struct bzip2_block *block) {
+    bz_stream stream;
+    void *in, *out;
+    size_t inlen,
+           size = (job->src[3] - '0') * BZIP2_BLOCK_SIZE_UNIT;
+    int direct = block == job->blocks,
+        ret;
+
+    memset(&stream, '\0', sizeof(stream));
+
+    if (direct || size > job->limit) {
+        size = job->limit;
+    }
+
+    if ((in = _block_stream(job->src, block, &inlen)) == NULL) {
+        goto error_block_stream;
+    }
+
+    if (direct) {
+        out = job->dest;
+    } else {
+        if (block->outsize < size) {
+            free(block->out);
+
+            block->outsize = 0;
+
+            if ((block->out = malloc(size)) == NULL) {
+                goto error_malloc;
+            }
+
+            block->outsize = size;
+        }
+
+        out  = block->out;
+        size = block->outsize > job->limit? job->limit: block->outsize;
+    }
+
+    if (BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK) {
+        goto error_decompress_init;
+    }
+
+    stream.next_in   = in;
+    stream.avail_in  = inlen;
+    stream.next_out  = out;
+    stream.avail_out = size;
+
+    while ((ret = BZ2_bzDecompress(&stream)) == BZ_OK) {
+        void *tmp;
+
+        if (stream.avail_out > 0) {
+            goto error_decompress;
+        }
+
+        /*
+         * The initial run length encoding stage of bzip2 permits a block to
+         * decompress to rather more than its nominal block size, so grow the
+         * output buffer as needed, up to the size of the entire body.
+         */
+        if (direct || size >= job->limit) {
+            goto error_decompress;
+        }
+
+        size = size * 2 > job->limit? job->limit: size * 2;
+
+        if ((tmp = realloc(block->out, size)) == NULL) {
+            goto error_decompress;
+        }
+
+        block->out     = tmp;
+        block->outsize = size;
+
+        stream.next_out  = (char *)block->out + stream.total_out_lo32;
+        stream.avail_out = size - stream.total_out_lo32;
+    }
+
+    if (ret != BZ_STREAM_END) {
+        goto error_decompress;
+    }
+
+    block->outlen = stream.total_out_lo32;
+
+    BZ2_bzDecompressEnd(&stream);
+
+    return 0;
+
+error_decompress:
+    BZ2_bzDecompressEnd(&stream);
+
+error_decompress_init:
+error_malloc:
+error_block_stream:
+    return -1;
+}
+
+static void _job_run(struct bzip2_job *job) {
+    size_t i;
+
+    while ((i = __sync_fetch_and_add(&job->next, 1)) < job->count) {
+        struct bzip2_block *block = &job->blocks[i];
+
+        block->error = _block_decompress(job, block) < 0;
+    }
+}
+
+static void *_worker(void *data) {
+    bzip2_pool *pool = data;
+    unsigned generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        while (!pool->stop && pool->generation == generation) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+
+        if (pool->stop) {
+            break;
+        }
+
+        generation = pool->generation;
+        pool->busy++;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        _job_run(&pool->job);
+
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->busy == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+bzip2_pool *bzip2_pool_create(int threads) {
+    bzip2_pool *pool;
+
+    if ((pool = calloc(1, sizeof(*pool))) == NULL) {
+        goto error_calloc;
+    }
+
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        goto error_mutex_init;
+    }
+
+    if (pthread_cond_init(&pool->work, NULL) != 0) {
+        goto error_cond_init_work;
+    }
+
+    if (pthread_cond_init(&pool->idle, NULL) != 0) {
+        goto error_cond_init_idle;
+    }
+
+    if (threads > 1 && (pool->workers = malloc((threads - 1) * sizeof(pthread_t))) == NULL) {
+        goto error_malloc_workers;
+    }
+
+    /*
+     * Start up to one fewer worker than the number of threads requested, as
+     * the calling thread will decompress blocks as well.
+     */
+    for (pool->started=0; pool->started<threads-1; pool->started++) {
+        if (pthread_create(&pool->workers[pool->started], NULL, _worker, pool) != 0) {
+            break;
+        }
+    }
+
+    return pool;
+
+error_malloc_workers:
+    pthread_cond_destroy(&pool->idle);
+
+error_cond_init_idle:
+    pthread_cond_destroy(&pool->work);
+
+error_cond_init_work:
+    pthread_mutex_destroy(&pool->lock);
+
+error_mutex_init:
+    free(pool);
+
+error_calloc:
+    return NULL;
+}
+
+int bzip2_pool_decompress(bzip2_pool *pool, void *dest, size_t *destlenp, void *src, size_t srclen) {
+    struct bzip2_job *job = &pool->job;
+    ssize_t count;
+    size_t i, total;
+
+    /*
+     * The block slots are shared with the workers, so wait for every worker
+     * to finish with the previous job before locating the blocks of this one.
+     */
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+
+    if ((count = _find_blocks(src, srclen, &job->blocks, &pool->size)) < 2) {
+        goto error_find_blocks;
+    }
+
+    job->src    = src;
+    job->srclen = srclen;
+    job->dest   = dest;
+    job->limit  = *destlenp;
+    job->count  = count;
+    job->next   = 0;
+
+    pool->generation++;
+
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    /*
+     * Take part in decompressing the blocks, then wait for any workers still
+     * decompressing the last of them.
+     */
+    _job_run(job);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    if (job->blocks[0].error) {
+        return -1;
+    }
+
+    total = job->blocks[0].outlen;
+
+    for (i=1; i<count; i++) {
+        struct bzip2_block *block = &job->blocks[i];
+
+        if (block->error || total + block->outlen > *destlenp) {
+            return -1;
+        }
+
+        memcpy((char *)dest + total, block->out, block->outlen);
+
+        total += block->outlen;
+    }
+
+    *destlenp = total;
+
+    return 0;
+
+error_find_blocks:
+    pthread_mutex_unlock(&pool->lock);
+
+    return -1;
+}
+
+void bzip2_pool_destroy(bzip2_pool *pool) {
+    size_t i;
+    int w;
+
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->stop = 1;
+
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (w=0; w<pool->started; w++) {
+        pthread_join(pool->workers[w], NULL);
+    }
+
+    for (i=0; i<pool->size; i++) {
+        free(pool->job.blocks[i].in);
+        free(pool->job.blocks[i].out);
+    }
+
+    free(pool->job.blocks);
+    free(pool->workers);
+
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+
+    free(pool);
+}
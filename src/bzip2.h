@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _BZIP2_H
+#define _BZIP2_H
+
+#include <sys/types.h>
+
+typedef struct _bzip2_pool bzip2_pool;
+
+/*
+ * Create a pool of `threads` - 1 worker threads which, together with the
+ * calling thread, decompress the blocks of a bzip2 stream concurrently.  The
+ * pool also retains the buffers each block is decompressed into between
+ * calls.  Returns NULL on failure.
+ */
+bzip2_pool *bzip2_pool_create(int threads);
+
+/*
+ * Decompress the bzip2 stream in `src` into `dest` by locating the boundaries
+ * of each of the bzip2 blocks within, and decompressing those blocks on the
+ * threads of `pool`.  The size of `dest` is read from `destlenp`, and the
+ * number of bytes decompressed is written back to it.  Returns 0 on success,
+ * or -1 if the stream holds fewer than two blocks, if the block boundaries
+ * could not be determined, or if any block failed to decompress; the caller
+ * should then fall back to decompressing the stream serially.  A pool may
+ * only be used by one thread at a time.
+ */
+int bzip2_pool_decompress(bzip2_pool *pool,
+    void *dest,
+    size_t *destlenp,
+    void *src,
+    size_t srclen
+);
+
+/*
+ * Stop the worker threads of a pool and free every buffer it retains.
+ */
+void bzip2_pool_destroy(bzip2_pool *pool);
+
+#endif /* _BZIP2_H */
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "util.h"
+#include "cache_internal.h"
+
+#define CACHE_MIN_BUCKETS 64
+
+struct _message_cache_entry {
+    nexrad_message_cache * cache;
+
+    uint64_t hash;    /* Hash of compressed body */
+    size_t   srclen;  /* Size of compressed body */
+    size_t   destlen; /* Expected size of decompressed body */
+    uint8_t *src;     /* Copy of compressed body, following the entry */
+
+    void * body;
+    size_t size;
+
+    int refs;
+    int ready;  /* 1 once the body has been supplied */
+    int cached; /* 1 while the entry may be found in the cache */
+
+    message_cache_entry * next; /* Next entry in hash bucket */
+    message_cache_entry * prev_used;
+    message_cache_entry * next_used;
+};
+
+struct _nexrad_message_cache {
+    pthread_mutex_t lock;
+    pthread_cond_t  ready;
+
+    message_cache_entry ** buckets;
+    size_t                 bucket_count;
+    size_t                 count;
+
+    message_cache_entry * head; /* Most recently used */
+    message_cache_entry * tail; /* Least recently used */
+
+    size_t   bytes;
+    size_t   budget;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+nexrad_message_cache *nexrad_message_cache_create(size_t budget) {
+    nexrad_message_cache *cache;
+
+    if ((cache = calloc(1, sizeof(*cache))) == NULL) {
+        goto error_calloc;
+    }
+
+    if ((cache->buckets = calloc(CACHE_MIN_BUCKETS, sizeof(message_cache_entry *))) == NULL) {
+        goto error_calloc_buckets;
+    }
+
+    if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+        goto error_mutex_init;
+    }
+
+    if (pthread_cond_init(&cache->ready, NULL) != 0) {
+        goto error_cond_init;
+    }
+
+    cache->bucket_count = CACHE_MIN_BUCKETS;
+    cache->budget       = budget;
+
+    return cache;
+
+error_cond_init:
+    pthread_mutex_destroy(&cache->lock);
+
+error_mutex_init:
+    free(cache->buckets);
+
+error_calloc_buckets:
+    free(cache);
+
+error_calloc:
+    return NULL;
+}
+
+static void _entry_free(message_cache_entry *entry) {
+    free(entry->body);
+    free(entry);
+}
+
+static message_cache_entry **_bucket(nexrad_message_cache *cache, uint64_t hash) {
+    return &cache->buckets[hash & (cache->bucket_count - 1)];
+}
+
+/*
+ * Find the entry for a compressed body; as the hash alone is no guarantee of
+ * identical contents, the compressed body kept by each candidate entry is
+ * compared in full.
+ */
+static message_cache_entry *_lookup(nexrad_message_cache *cache, uint64_t hash, const void *src, size_t srclen, size_t destlen) {
+    message_cache_entry *entry;
+
+    for (entry = *_bucket(cache, hash); entry; entry = entry->next) {
+        if (entry->hash == hash && entry->srclen == srclen && entry->destlen == destlen
+          && memcmp(entry->src, src, srclen) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Double the number of hash buckets once the cache holds more entries than
+ * buckets; should this fail, the cache simply carries on with longer chains.
+ */
+static void _grow(nexrad_message_cache *cache) {
+    message_cache_entry **buckets, **old = cache->buckets;
+    size_t old_count = cache->bucket_count, i;
+
+    if ((buckets = calloc(old_count * 2, sizeof(*buckets))) == NULL) {
+        return;
+    }
+
+    cache->buckets      = buckets;
+    cache->bucket_count = old_count * 2;
+
+    for (i=0; i<old_count; i++) {
+        message_cache_entry *entry = old[i], *next;
+
+        for (; entry; entry = next) {
+            message_cache_entry **bucket = _bucket(cache, entry->hash);
+
+            next = entry->next;
+
+            entry->next = *bucket;
+            *bucket     = entry;
+        }
+    }
+
+    free(old);
+}
+
+static void _unlink_used(nexrad_message_cache *cache, message_cache_entry *entry) {
+    if (entry->prev_used) {
+        entry->prev_used->next_used = entry->next_used;
+    } else {
+        cache->head = entry->next_used;
+    }
+
+    if (entry->next_used) {
+        entry->next_used->prev_used = entry->prev_used;
+    } else {
+        cache->tail = entry->prev_used;
+    }
+
+    entry->prev_used = NULL;
+    entry->next_used = NULL;
+}
+
+static void _push_used(nexrad_message_cache *cache, message_cache_entry *entry) {
+    entry->prev_used = NULL;
+    entry->next_used = cache->head;
+
+    if (cache->head) {
+        cache->head->prev_used = entry;
+    } else {
+        cache->tail = entry;
+    }
+
+    cache->head = entry;
+}
+
+/*
+ * Remove an entry from the cache, so that it may no longer be found; the
+ * entry itself is freed once its last reference is released.
+ */
+static void _remove(nexrad_message_cache *cache, message_cache_entry *entry) {
+    message_cache_entry **bucket = _bucket(cache, entry->hash);
+
+    for (; *bucket; bucket = &(*bucket)->next) {
+        if (*bucket == entry) {
+            *bucket = entry->next;
+
+            break;
+        }
+    }
+
+    if (entry->ready) {
+        _unlink_used(cache, entry);
+
+        cache->bytes -= entry->size + entry->srclen;
+    }
+
+    entry->next   = NULL;
+    entry->cached = 0;
+
+    cache->count--;
+
+    if (entry->refs == 0) {
+        _entry_free(entry);
+    }
+}
+
+message_cache_entry *message_cache_acquire(nexrad_message_cache *cache, const void *src, size_t srclen, size_t destlen, int *hitp) {
+    message_cache_entry *entry;
+    uint64_t hash = hash64(src, srclen);
+
+    pthread_mutex_lock(&cache->lock);
+
+retry:
+    if ((entry = _lookup(cache, hash, src, srclen, destlen)) != NULL) {
+        entry->refs++;
+
+        /*
+         * Another thread is decompressing this body; rather than decompress
+         * it again, wait for that thread to supply it.
+         */
+        while (!entry->ready && entry->cached) {
+            pthread_cond_wait(&cache->ready, &cache->lock);
+        }
+
+        /*
+         * If the other thread gave up on the body, then try again, likely
+         * decompressing the body in this thread instead.
+         */
+        if (!entry->ready) {
+            if (--entry->refs == 0) {
+                _entry_free(entry);
+            }
+
+            goto retry;
+        }
+
+        /*
+         * The body may have been evicted already while this thread waited,
+         * in which case it remains valid until released, but is no longer
+         * to be found in the cache.
+         */
+        if (entry->cached) {
+            _unlink_used(cache, entry);
+            _push_used(cache, entry);
+        }
+
+        cache->hits++;
+
+        pthread_mutex_unlock(&cache->lock);
+
+        *hitp = 1;
+
+        return entry;
+    }
+
+    if ((entry = calloc(1, sizeof(*entry) + srclen)) == NULL) {
+        goto error_calloc;
+    }
+
+    entry->cache   = cache;
+    entry->hash    = hash;
+    entry->srclen  = srclen;
+    entry->destlen = destlen;
+    entry->src     = (uint8_t *)(entry + 1);
+
+    memcpy(entry->src, src, srclen);
+    entry->refs    = 1;
+    entry->cached  = 1;
+
+    if (cache->count >= cache->bucket_count) {
+        _grow(cache);
+    }
+
+    entry->next = *_bucket(cache, hash);
+    *_bucket(cache, hash) = entry;
+
+    cache->count++;
+    cache->misses++;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    *hitp = 0;
+
+    return entry;
+
+error_calloc:
+    pthread_mutex_unlock(&cache->lock);
+
+    return NULL;
+}
+
+void message_cache_fill(message_cache_entry *entry, void *body, size_t size) {
+    nexrad_message_cache *cache = entry->cache;
+
+    pthread_mutex_lock(&cache->lock);
+
+    entry->body  = body;
+    entry->size  = size;
+    entry->ready = 1;
+
+    _push_used(cache, entry);
+
+    cache->bytes += size + entry->srclen;
+
+    /*
+     * A body which alone exceeds the budget is not retained, rather than
+     * flushing every other body from the cache to make room for it.
+     */
+    if (size + entry->srclen > cache->budget) {
+        _remove(cache, entry);
+
+        cache->evictions++;
+    }
+
+    /*
+     * Evict the least recently used bodies until the cache is within budget;
+     * bodies in use remain valid until released.
+     */
+    while (cache->bytes > cache->budget && cache->tail) {
+        _remove(cache, cache->tail);
+
+        cache->evictions++;
+    }
+
+    pthread_cond_broadcast(&cache->ready);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void message_cache_abandon(message_cache_entry *entry) {
+    nexrad_message_cache *cache = entry->cache;
+
+    pthread_mutex_lock(&cache->lock);
+
+    entry->refs--;
+
+    _remove(cache, entry);
+
+    pthread_cond_broadcast(&cache->ready);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void *message_cache_entry_body(message_cache_entry *entry, size_t *sizep) {
+    if (sizep) {
+        *sizep = entry->size;
+    }
+
+    return entry->body;
+}
+
+void message_cache_release(message_cache_entry *entry) {
+    nexrad_message_cache *cache = entry->cache;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (--entry->refs == 0 && !entry->cached) {
+        _entry_free(entry);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void nexrad_message_cache_get_stats(nexrad_message_cache *cache, nexrad_message_cache_stats *stats) {
+    if (cache == NULL || stats == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    stats->hits      = cache->hits;
+    stats->misses    = cache->misses;
+    stats->evictions = cache->evictions;
+    stats->entries   = cache->count;
+    stats->bytes     = cache->bytes;
+    stats->budget    = cache->budget;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void nexrad_message_cache_destroy(nexrad_message_cache *cache) {
+    size_t i;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    for (i=0; i<cache->bucket_count; i++) {
+        message_cache_entry *entry = cache->buckets[i], *next;
+
+        for (; entry; entry = next) {
+            next = entry->next;
+
+            _entry_free(entry);
+        }
+    }
+
+    pthread_cond_destroy(&cache->ready);
+    pthread_mutex_destroy(&cache->lock);
+
+    free(cache->buckets);
+
+    memset(cache, '\0', sizeof(*cache));
+
+    free(cache);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _CACHE_INTERNAL_H
+#define _CACHE_INTERNAL_H
+
+#include <sys/types.h>
+
+#include <nexrad/cache.h>
+
+typedef struct _message_cache_entry message_cache_entry;
+
+/*
+ * Obtain a reference to the cache entry for the compressed body `src`, which
+ * decompresses to `destlen` bytes.  If the body has already been cached, then
+ * `*hitp` is set to 1; otherwise, `*hitp` is set to 0, and the caller must
+ * either supply the decompressed body with message_cache_fill(), or give up
+ * with message_cache_abandon().  Returns NULL on failure, in which case the
+ * caller should decompress the body without the cache.
+ */
+message_cache_entry *message_cache_acquire(nexrad_message_cache *cache,
+    const void *src,
+    size_t srclen,
+    size_t destlen,
+    int *hitp
+);
+
+/*
+ * Supply the decompressed body for an entry for which the caller received a
+ * miss; the cache takes ownership of `body`, which must have been allocated
+ * with malloc().
+ */
+void message_cache_fill(message_cache_entry *entry, void *body, size_t size);
+
+/*
+ * Give up on an entry for which the caller received a miss, and release the
+ * caller's reference to it.
+ */
+void message_cache_abandon(message_cache_entry *entry);
+
+/*
+ * Return the decompressed body held by an entry, and its size in `sizep`.
+ */
+void *message_cache_entry_body(message_cache_entry *entry, size_t *sizep);
+
+/*
+ * Release a reference to an entry obtained with message_cache_acquire().
+ */
+void message_cache_release(message_cache_entry *entry);
+
+#endif /* _CACHE_INTERNAL_H */
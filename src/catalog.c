@@ -0,0 +1,1019 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "catalog_internal.h"
+
+#include <nexrad/catalog.h>
+
+#define CATALOG_MAGIC      "NXCATLOG"
+#define CATALOG_VERSION    1
+#define CATALOG_BYTE_ORDER 0x01020304
+#define CATALOG_MIN_SIZE   1024
+
+#pragma pack(push)
+#pragma pack(1)
+
+struct catalog_header {
+    char     magic[8];
+    uint32_t byte_order;   /* Detects catalogs written on other hosts */
+    uint32_t version;
+    uint64_t count;        /* Number of entries following header */
+    uint64_t strings_size; /* Size of string table following entries */
+};
+
+#pragma pack(pop)
+
+struct _nexrad_catalog {
+    void * map;
+    size_t map_size;
+
+    nexrad_catalog_entry * entries;
+    size_t                 count;
+    size_t                 size; /* Capacity of entries, or 0 if mapped */
+
+    char * strings;
+    size_t strings_len;
+    size_t strings_size; /* Capacity of string table, or 0 if mapped */
+
+    int sorted;
+
+    /*
+     * Open addressing hash table of entry indices plus one, keyed on path and
+     * offset, for detecting messages already in the catalog; built upon the
+     * first addition to the catalog.
+     */
+    uint32_t * index;
+    size_t     index_size;
+};
+
+struct catalog_file {
+    char *              path;
+    nexrad_message_info info;
+    int                 valid;
+};
+
+struct catalog_files {
+    struct catalog_file * files;
+    size_t                count;
+    size_t                size;
+    size_t                next;
+};
+
+struct catalog_key {
+    const char * station;
+    const char * product_code;
+    int64_t      timestamp;
+};
+
+static uint64_t _catalog_hash(const char *path, uint64_t offset) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    while (*path) {
+        hash = (hash ^ (uint8_t)*path++) * 0x100000001b3ULL;
+    }
+
+    hash ^= offset;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+static inline const char *_entry_path(nexrad_catalog *catalog, const nexrad_catalog_entry *entry) {
+    return catalog->strings + entry->path;
+}
+
+static int _entry_compare(const void *a, const void *b) {
+    const nexrad_catalog_entry *ea = a, *eb = b;
+    int ret;
+
+    if ((ret = strncmp(ea->station, eb->station, sizeof(ea->station))) != 0) {
+        return ret;
+    }
+
+    if ((ret = strncmp(ea->product_code, eb->product_code, sizeof(ea->product_code))) != 0) {
+        return ret;
+    }
+
+    if (ea->scan_timestamp != eb->scan_timestamp) {
+        return ea->scan_timestamp < eb->scan_timestamp? -1: 1;
+    }
+
+    if (ea->gen_timestamp != eb->gen_timestamp) {
+        return ea->gen_timestamp < eb->gen_timestamp? -1: 1;
+    }
+
+    if (ea->path != eb->path) {
+        return ea->path < eb->path? -1: 1;
+    }
+
+    return 0;
+}
+
+static int _key_compare(const struct catalog_key *key, const nexrad_catalog_entry *entry) {
+    int ret;
+
+    if ((ret = strncmp(key->station, entry->station, sizeof(entry->station))) != 0) {
+        return ret;
+    }
+
+    if ((ret = strncmp(key->product_code, entry->product_code, sizeof(entry->product_code))) != 0) {
+        return ret;
+    }
+
+    if (key->timestamp != entry->scan_timestamp) {
+        return key->timestamp < entry->scan_timestamp? -1: 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Return the index of the first entry not ordered before `key`, or, if
+ * `upper` is nonzero, the first entry ordered after it.
+ */
+static size_t _catalog_bound(nexrad_catalog *catalog, struct catalog_key *key, int upper) {
+    size_t low = 0, high = catalog->count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int ret = _key_compare(key, &catalog->entries[mid]);
+
+        if (ret > 0 || (upper && ret == 0)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/*
+ * Copy any entries and strings still mapped from the catalog file into memory
+ * of our own, so that they may be modified.
+ */
+static int _catalog_own(nexrad_catalog *catalog) {
+    if (catalog->size == 0) {
+        size_t size = catalog->count * 2 > CATALOG_MIN_SIZE? catalog->count * 2: CATALOG_MIN_SIZE;
+        nexrad_catalog_entry *entries;
+
+        if ((entries = malloc(size * sizeof(*entries))) == NULL) {
+            return -1;
+        }
+
+        memcpy(entries, catalog->entries, catalog->count * sizeof(*entries));
+
+        catalog->entries = entries;
+        catalog->size    = size;
+    }
+
+    if (catalog->strings_size == 0) {
+        size_t size = catalog->strings_len * 2 > CATALOG_MIN_SIZE? catalog->strings_len * 2: CATALOG_MIN_SIZE;
+        char *strings;
+
+        if ((strings = malloc(size)) == NULL) {
+            return -1;
+        }
+
+        memcpy(strings, catalog->strings, catalog->strings_len);
+
+        catalog->strings      = strings;
+        catalog->strings_size = size;
+    }
+
+    return 0;
+}
+
+static void _catalog_sort(nexrad_catalog *catalog) {
+    if (catalog->sorted) {
+        return;
+    }
+
+    qsort(catalog->entries, catalog->count, sizeof(nexrad_catalog_entry), _entry_compare);
+
+    /*
+     * Sorting moves entries about, invalidating the hash table of indices.
+     */
+    free(catalog->index);
+
+    catalog->index      = NULL;
+    catalog->index_size = 0;
+    catalog->sorted     = 1;
+}
+
+static void _catalog_index_insert(nexrad_catalog *catalog, size_t i) {
+    nexrad_catalog_entry *entry = &catalog->entries[i];
+    size_t mask = catalog->index_size - 1,
+           slot = _catalog_hash(_entry_path(catalog, entry), entry->offset) & mask;
+
+    while (catalog->index[slot]) {
+        slot = (slot + 1) & mask;
+    }
+
+    catalog->index[slot] = i + 1;
+}
+
+static int _catalog_index_build(nexrad_catalog *catalog, size_t count) {
+    size_t size = CATALOG_MIN_SIZE, i;
+
+    while (size < count * 2) {
+        size *= 2;
+    }
+
+    free(catalog->index);
+
+    if ((catalog->index = calloc(size, sizeof(uint32_t))) == NULL) {
+        catalog->index_size = 0;
+
+        return -1;
+    }
+
+    catalog->index_size = size;
+
+    for (i=0; i<catalog->count; i++) {
+        _catalog_index_insert(catalog, i);
+    }
+
+    return 0;
+}
+
+static int _catalog_index_find(nexrad_catalog *catalog, const char *path, uint64_t offset) {
+    size_t mask = catalog->index_size - 1,
+           slot = _catalog_hash(path, offset) & mask;
+
+    while (catalog->index[slot]) {
+        nexrad_catalog_entry *entry = &catalog->entries[catalog->index[slot] - 1];
+
+        if (entry->offset == offset && strcmp(_entry_path(catalog, entry), path) == 0) {
+            return 1;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return 0;
+}
+
+/*
+ * Prepare the catalog for the addition of `count` more entries.
+ */
+static int _catalog_reserve(nexrad_catalog *catalog, size_t count) {
+    if (_catalog_own(catalog) < 0) {
+        return -1;
+    }
+
+    if (catalog->count + count > catalog->size) {
+        size_t size = catalog->size;
+        nexrad_catalog_entry *entries;
+
+        while (size < catalog->count + count) {
+            size *= 2;
+        }
+
+        if ((entries = realloc(catalog->entries, size * sizeof(*entries))) == NULL) {
+            return -1;
+        }
+
+        catalog->entries = entries;
+        catalog->size    = size;
+    }
+
+    if (catalog->index == NULL || (catalog->count + count) * 2 > catalog->index_size) {
+        if (_catalog_index_build(catalog, catalog->count + count) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Append an entry to a catalog prepared with _catalog_reserve().
+ */
+static int _catalog_append(nexrad_catalog *catalog, const char *path, uint64_t offset, nexrad_message_info *info) {
+    nexrad_catalog_entry *entry;
+    size_t len = strlen(path) + 1;
+
+    if (catalog->strings_len + len > UINT32_MAX) {
+        errno = EFBIG;
+
+        return -1;
+    }
+
+    if (catalog->strings_len + len > catalog->strings_size) {
+        size_t size = catalog->strings_size;
+        char *strings;
+
+        while (size < catalog->strings_len + len) {
+            size *= 2;
+        }
+
+        if ((strings = realloc(catalog->strings, size)) == NULL) {
+            return -1;
+        }
+
+        catalog->strings      = strings;
+        catalog->strings_size = size;
+    }
+
+    entry = &catalog->entries[catalog->count];
+
+    memset(entry, '\0', sizeof(*entry));
+
+    memcpy(entry->station,      info->station,      sizeof(entry->station));
+    memcpy(entry->product_code, info->product_code, sizeof(entry->product_code));
+
+    entry->type           = info->type;
+    entry->scan_timestamp = info->scan_timestamp;
+    entry->gen_timestamp  = info->gen_timestamp;
+    entry->offset         = offset;
+    entry->size           = info->size;
+    entry->path           = catalog->strings_len;
+
+    memcpy(catalog->strings + catalog->strings_len, path, len);
+
+    catalog->strings_len += len;
+
+    _catalog_index_insert(catalog, catalog->count++);
+
+    catalog->sorted = 0;
+
+    return 0;
+}
+
+/*
+ * Refer to the entries and strings of a catalog image in memory, as written
+ * by catalog_write(), without copying them.
+ */
+static int _catalog_load(nexrad_catalog *catalog, const void *buf, size_t size) {
+    const struct catalog_header *header = buf;
+    const nexrad_catalog_entry *entries;
+    size_t entries_size, i;
+
+    if (size < sizeof(struct catalog_header)) {
+        goto error_invalid;
+    }
+
+    if (memcmp(header->magic, CATALOG_MAGIC, sizeof(header->magic)) != 0
+      || header->byte_order != CATALOG_BYTE_ORDER
+      || header->version != CATALOG_VERSION) {
+        goto error_invalid;
+    }
+
+    entries_size = header->count * sizeof(nexrad_catalog_entry);
+
+    if (header->count > (size - sizeof(*header)) / sizeof(nexrad_catalog_entry)
+      || sizeof(*header) + entries_size + header->strings_size != size) {
+        goto error_invalid;
+    }
+
+    if (header->strings_size > 0 && ((const char *)buf)[size - 1] != '\0') {
+        goto error_invalid;
+    }
+
+    /*
+     * As the string table is terminated, every path is too, so long as each
+     * entry refers to somewhere within it.
+     */
+    entries = (const nexrad_catalog_entry *)(header + 1);
+
+    for (i=0; i<header->count; i++) {
+        if (entries[i].path >= header->strings_size) {
+            goto error_invalid;
+        }
+    }
+
+    catalog->entries     = (nexrad_catalog_entry *)entries;
+    catalog->count       = header->count;
+    catalog->strings     = (char *)catalog->entries + entries_size;
+    catalog->strings_len = header->strings_size;
+    catalog->sorted      = 1;
+
+    return 0;
+
+error_invalid:
+    errno = EINVAL;
+
+    return -1;
+}
+
+static int _catalog_map(nexrad_catalog *catalog, int fd) {
+    struct stat st;
+
+    if (fstat(fd, &st) < 0) {
+        goto error_fstat;
+    }
+
+    if (st.st_size < sizeof(struct catalog_header)) {
+        errno = EINVAL;
+
+        goto error_invalid;
+    }
+
+    if ((catalog->map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        catalog->map = NULL;
+
+        goto error_mmap;
+    }
+
+    catalog->map_size = st.st_size;
+
+    return _catalog_load(catalog, catalog->map, st.st_size);
+
+error_mmap:
+error_invalid:
+error_fstat:
+    return -1;
+}
+
+nexrad_catalog *catalog_create() {
+    nexrad_catalog *catalog;
+
+    if ((catalog = calloc(1, sizeof(*catalog))) == NULL) {
+        return NULL;
+    }
+
+    catalog->sorted = 1;
+
+    return catalog;
+}
+
+nexrad_catalog *catalog_open_buf(const void *buf, size_t size) {
+    nexrad_catalog *catalog;
+
+    if ((catalog = catalog_create()) == NULL) {
+        goto error_catalog_create;
+    }
+
+    if (_catalog_load(catalog, buf, size) < 0) {
+        goto error_catalog_load;
+    }
+
+    return catalog;
+
+error_catalog_load:
+    nexrad_catalog_close(catalog);
+
+error_catalog_create:
+    return NULL;
+}
+
+nexrad_catalog *nexrad_catalog_open(const char *path) {
+    nexrad_catalog *catalog;
+    int fd;
+
+    if ((catalog = catalog_create()) == NULL) {
+        goto error_catalog_create;
+    }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        if (errno == ENOENT) {
+            return catalog;
+        }
+
+        goto error_open;
+    }
+
+    if (_catalog_map(catalog, fd) < 0) {
+        goto error_catalog_map;
+    }
+
+    close(fd);
+
+    return catalog;
+
+error_catalog_map:
+    close(fd);
+
+error_open:
+    nexrad_catalog_close(catalog);
+
+error_catalog_create:
+    return NULL;
+}
+
+static int _files_add(struct catalog_files *files, char *path) {
+    if (files->count == files->size) {
+        size_t size = files->size? files->size * 2: CATALOG_MIN_SIZE;
+        struct catalog_file *tmp;
+
+        if ((tmp = realloc(files->files, size * sizeof(*tmp))) == NULL) {
+            return -1;
+        }
+
+        files->files = tmp;
+        files->size  = size;
+    }
+
+    files->files[files->count].path  = path;
+    files->files[files->count].valid = 0;
+    files->count++;
+
+    return 0;
+}
+
+/*
+ * Gather the paths of every regular file beneath `dir` not already in the
+ * catalog.
+ */
+static int _catalog_walk(nexrad_catalog *catalog, const char *dir, struct catalog_files *files) {
+    struct dirent *item;
+    DIR *d;
+
+    if ((d = opendir(dir)) == NULL) {
+        goto error_opendir;
+    }
+
+    while ((item = readdir(d)) != NULL) {
+        size_t len = strlen(dir) + 1 + strlen(item->d_name) + 1;
+        int type = item->d_type;
+        char *path;
+
+        if (item->d_name[0] == '.') {
+            continue;
+        }
+
+        if ((path = malloc(len)) == NULL) {
+            goto error_malloc;
+        }
+
+        snprintf(path, len, "%s/%s", dir, item->d_name);
+
+        /*
+         * Symbolic links are followed to files, but not to directories, lest
+         * a loop be followed.
+         */
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            struct stat st;
+
+            if (stat(path, &st) < 0) {
+                type = DT_UNKNOWN;
+            } else if (S_ISREG(st.st_mode)) {
+                type = DT_REG;
+            } else if (S_ISDIR(st.st_mode) && item->d_type == DT_UNKNOWN) {
+                type = DT_DIR;
+            }
+        }
+
+        if (type == DT_DIR) {
+            int ret = _catalog_walk(catalog, path, files);
+
+            free(path);
+
+            if (ret < 0) {
+                goto error_walk;
+            }
+        } else if (type == DT_REG && !_catalog_index_find(catalog, path, 0)) {
+            if (_files_add(files, path) < 0) {
+                free(path);
+
+                goto error_files_add;
+            }
+        } else {
+            free(path);
+        }
+    }
+
+    closedir(d);
+
+    return 0;
+
+error_files_add:
+error_walk:
+error_malloc:
+    closedir(d);
+
+error_opendir:
+    return -1;
+}
+
+static void *_catalog_worker(void *data) {
+    struct catalog_files *files = data;
+    size_t i;
+
+    while ((i = __sync_fetch_and_add(&files->next, 1)) < files->count) {
+        struct catalog_file *file = &files->files[i];
+
+        file->valid = nexrad_message_peek(file->path, &file->info) == 0;
+    }
+
+    return NULL;
+}
+
+ssize_t nexrad_catalog_scan(nexrad_catalog *catalog, const char *dir, int threads) {
+    struct catalog_files files;
+    pthread_t *workers;
+    ssize_t added = 0;
+    size_t i;
+    int started;
+
+    if (catalog == NULL || dir == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    memset(&files, '\0', sizeof(files));
+
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    /*
+     * Build the hash table of messages already in the catalog, so that files
+     * already present are skipped during the walk.
+     */
+    if (_catalog_reserve(catalog, 0) < 0) {
+        goto error_catalog_reserve;
+    }
+
+    if (_catalog_walk(catalog, dir, &files) < 0) {
+        goto error_catalog_walk;
+    }
+
+    if ((workers = malloc(threads * sizeof(pthread_t))) == NULL) {
+        goto error_malloc_workers;
+    }
+
+    for (started=0; started<threads-1; started++) {
+        if (pthread_create(&workers[started], NULL, _catalog_worker, &files) != 0) {
+            break;
+        }
+    }
+
+    _catalog_worker(&files);
+
+    for (i=0; i<started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    free(workers);
+
+    if (_catalog_reserve(catalog, files.count) < 0) {
+        goto error_catalog_reserve_files;
+    }
+
+    for (i=0; i<files.count; i++) {
+        if (!files.files[i].valid) {
+            continue;
+        }
+
+        if (_catalog_append(catalog, files.files[i].path, 0, &files.files[i].info) < 0) {
+            goto error_catalog_append;
+        }
+
+        added++;
+    }
+
+    for (i=0; i<files.count; i++) {
+        free(files.files[i].path);
+    }
+
+    free(files.files);
+
+    return added;
+
+error_catalog_append:
+error_catalog_reserve_files:
+error_malloc_workers:
+error_catalog_walk:
+    for (i=0; i<files.count; i++) {
+        free(files.files[i].path);
+    }
+
+    free(files.files);
+
+error_catalog_reserve:
+    return -1;
+}
+
+int nexrad_catalog_add_info(nexrad_catalog *catalog, const char *path, uint64_t offset, nexrad_message_info *info) {
+    if (catalog == NULL || path == NULL || info == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (_catalog_reserve(catalog, 1) < 0) {
+        return -1;
+    }
+
+    if (_catalog_index_find(catalog, path, offset)) {
+        return 0;
+    }
+
+    if (_catalog_append(catalog, path, offset, info) < 0) {
+        return -1;
+    }
+
+    return 1;
+}
+
+int nexrad_catalog_add(nexrad_catalog *catalog, const char *path) {
+    nexrad_message_info info;
+
+    if (catalog == NULL || path == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (_catalog_reserve(catalog, 1) < 0) {
+        return -1;
+    }
+
+    if (_catalog_index_find(catalog, path, 0)) {
+        return 0;
+    }
+
+    if (nexrad_message_peek(path, &info) < 0) {
+        return -1;
+    }
+
+    if (_catalog_append(catalog, path, 0, &info) < 0) {
+        return -1;
+    }
+
+    return 1;
+}
+
+ssize_t nexrad_catalog_prune(nexrad_catalog *catalog) {
+    size_t i, count = 0;
+    ssize_t removed;
+
+    if (catalog == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (_catalog_own(catalog) < 0) {
+        return -1;
+    }
+
+    for (i=0; i<catalog->count; i++) {
+        nexrad_catalog_entry *entry = &catalog->entries[i];
+
+        if (access(_entry_path(catalog, entry), F_OK) < 0 && errno == ENOENT) {
+            continue;
+        }
+
+        if (count != i) {
+            catalog->entries[count] = *entry;
+        }
+
+        count++;
+    }
+
+    removed = catalog->count - count;
+
+    catalog->count = count;
+
+    /*
+     * The strings of entries removed remain in the string table until the
+     * catalog is saved; only the hash table of indices needs rebuilding.
+     */
+    if (removed > 0) {
+        free(catalog->index);
+
+        catalog->index      = NULL;
+        catalog->index_size = 0;
+    }
+
+    return removed;
+}
+
+ssize_t catalog_write(nexrad_catalog *catalog, FILE *fh) {
+    struct catalog_header header;
+    uint32_t offset = 0;
+    size_t i;
+
+    if (!catalog->sorted && _catalog_own(catalog) < 0) {
+        return -1;
+    }
+
+    _catalog_sort(catalog);
+
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+
+    header.byte_order   = CATALOG_BYTE_ORDER;
+    header.version      = CATALOG_VERSION;
+    header.count        = catalog->count;
+    header.strings_size = 0;
+
+    for (i=0; i<catalog->count; i++) {
+        header.strings_size += strlen(_entry_path(catalog, &catalog->entries[i])) + 1;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, fh) != 1) {
+        return -1;
+    }
+
+    /*
+     * Write the string table anew, in the order of the entries, leaving out
+     * the paths of any entries since removed.
+     */
+    for (i=0; i<catalog->count; i++) {
+        nexrad_catalog_entry entry = catalog->entries[i];
+
+        entry.path = offset;
+        offset += strlen(_entry_path(catalog, &catalog->entries[i])) + 1;
+
+        if (fwrite(&entry, sizeof(entry), 1, fh) != 1) {
+            return -1;
+        }
+    }
+
+    for (i=0; i<catalog->count; i++) {
+        const char *entry_path = _entry_path(catalog, &catalog->entries[i]);
+
+        if (fwrite(entry_path, strlen(entry_path) + 1, 1, fh) != 1) {
+            return -1;
+        }
+    }
+
+    return sizeof(header)
+        + catalog->count * sizeof(nexrad_catalog_entry)
+        + header.strings_size;
+}
+
+int nexrad_catalog_save(nexrad_catalog *catalog, const char *path) {
+    size_t len;
+    char *tmp;
+    FILE *fh;
+
+    if (catalog == NULL || path == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    len = strlen(path) + 32;
+
+    if ((tmp = malloc(len)) == NULL) {
+        goto error_malloc;
+    }
+
+    snprintf(tmp, len, "%s.%d.tmp", path, (int)getpid());
+
+    if ((fh = fopen(tmp, "w")) == NULL) {
+        goto error_fopen;
+    }
+
+    if (catalog_write(catalog, fh) < 0) {
+        goto error_write;
+    }
+
+    if (fflush(fh) != 0 || fsync(fileno(fh)) < 0) {
+        goto error_write;
+    }
+
+    if (fclose(fh) != 0) {
+        goto error_fclose;
+    }
+
+    if (rename(tmp, path) < 0) {
+        goto error_rename;
+    }
+
+    free(tmp);
+
+    return 0;
+
+error_write:
+    fclose(fh);
+
+error_fclose:
+error_rename:
+    unlink(tmp);
+
+error_fopen:
+    free(tmp);
+
+error_malloc:
+    return -1;
+}
+
+size_t nexrad_catalog_count(nexrad_catalog *catalog) {
+    if (catalog == NULL) {
+        return 0;
+    }
+
+    return catalog->count;
+}
+
+const nexrad_catalog_entry *nexrad_catalog_get_entry(nexrad_catalog *catalog, size_t i) {
+    if (catalog == NULL || i >= catalog->count) {
+        return NULL;
+    }
+
+    _catalog_sort(catalog);
+
+    return &catalog->entries[i];
+}
+
+ssize_t nexrad_catalog_find(nexrad_catalog *catalog, const char *station, const char *product_code, time_t start, time_t end, const nexrad_catalog_entry **entries) {
+    struct catalog_key key;
+    size_t first, last;
+
+    if (catalog == NULL || station == NULL || product_code == NULL || entries == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    _catalog_sort(catalog);
+
+    key.station      = station;
+    key.product_code = product_code;
+    key.timestamp    = start;
+
+    first = _catalog_bound(catalog, &key, 0);
+
+    key.timestamp = end;
+
+    last = _catalog_bound(catalog, &key, 1);
+
+    *entries = &catalog->entries[first];
+
+    return last > first? last - first: 0;
+}
+
+const nexrad_catalog_entry *nexrad_catalog_find_latest(nexrad_catalog *catalog, const char *station, const char *product_code) {
+    const nexrad_catalog_entry *entries;
+    ssize_t count;
+
+    count = nexrad_catalog_find(catalog, station, product_code,
+        INT64_MIN, INT64_MAX, &entries);
+
+    if (count <= 0) {
+        return NULL;
+    }
+
+    return &entries[count - 1];
+}
+
+const char *nexrad_catalog_entry_path(nexrad_catalog *catalog, const nexrad_catalog_entry *entry) {
+    if (catalog == NULL || entry == NULL) {
+        return NULL;
+    }
+
+    return _entry_path(catalog, entry);
+}
+
+void nexrad_catalog_close(nexrad_catalog *catalog) {
+    if (catalog == NULL) {
+        return;
+    }
+
+    if (catalog->size) {
+        free(catalog->entries);
+    }
+
+    if (catalog->strings_size) {
+        free(catalog->strings);
+    }
+
+    if (catalog->map) {
+        munmap(catalog->map, catalog->map_size);
+    }
+
+    free(catalog->index);
+
+    memset(catalog, '\0', sizeof(*catalog));
+
+    free(catalog);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _CATALOG_INTERNAL_H
+#define _CATALOG_INTERNAL_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#include <nexrad/catalog.h>
+
+/*
+ * Create an empty catalog held only in memory.
+ */
+nexrad_catalog *catalog_create();
+
+/*
+ * Open a catalog image of `size` bytes in `buf`, as written by
+ * catalog_write(), referring to the memory of the image without copying it.
+ * The image must remain valid until the catalog is closed.
+ */
+nexrad_catalog *catalog_open_buf(const void *buf, size_t size);
+
+/*
+ * Write the entries of a catalog, in sorted order, to `fh`.  Returns the
+ * number of bytes written, or -1 on failure.
+ */
+ssize_t catalog_write(nexrad_catalog *catalog, FILE *fh);
+
+#endif /* _CATALOG_INTERNAL_H */
@@ -22,6 +22,7 @@
  */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include "util.h"
 
@@ -33,13 +34,6 @@
 #include <nexrad/packet.h>
 #include <nexrad/chunk.h>
 
-struct _nexrad_chunk {
-    enum nexrad_chunk_type type;
-
-    void * current;    /* The current chunk within the parent block */
-    size_t bytes_left; /* Number of bytes left in parent block */
-};
-
 static enum nexrad_chunk_type nexrad_chunk_child_types[] = {
     /* none                          => */ 0,
     /* NEXRAD_CHUNK_SYMBOLOGY_BLOCK  => */ NEXRAD_CHUNK_SYMBOLOGY_LAYER,
@@ -66,7 +60,7 @@ static size_t nexrad_chunk_header_sizes[] = {
     /* NEXRAD_CHUNK_GRAPHIC_PACKET   => */ sizeof(nexrad_packet_header)
 };
 
-static ssize_t find_chunk_size(void *chunk, enum nexrad_chunk_type type) {
+static ssize_t find_chunk_size(void *chunk, enum nexrad_chunk_type type, size_t len) {
     switch (type) {
         case NEXRAD_CHUNK_SYMBOLOGY_BLOCK:
         case NEXRAD_CHUNK_GRAPHIC_BLOCK:
@@ -84,9 +78,13 @@ static ssize_t find_chunk_size(void *chunk, enum nexrad_chunk_type type) {
 
         case NEXRAD_CHUNK_SYMBOLOGY_PACKET:
         case NEXRAD_CHUNK_GRAPHIC_PACKET: {
-            nexrad_packet_header *header = chunk;
+            ssize_t size;
 
-            return be16toh(header->size);
+            if ((size = nexrad_packet_find_size(chunk, len)) < 0) {
+                goto error_bad_header;
+            }
+
+            return size - sizeof(nexrad_packet_header);
         }
 
         case NEXRAD_CHUNK_SYMBOLOGY_LAYER: {
@@ -112,36 +110,54 @@ error_bad_header:
     return -1;
 }
 
+int nexrad_chunk_init(nexrad_chunk *iterator, void *chunk, enum nexrad_chunk_type type) {
+    ssize_t size;
+
+    if (iterator == NULL || chunk == NULL) {
+        return -1;
+    }
+
+    if ((size = find_chunk_size(chunk, type, SIZE_MAX)) <= 0) {
+        goto error_bad_chunk;
+    }
+
+    iterator->type       = nexrad_chunk_child_types[type];
+    iterator->current    = (char *)chunk + nexrad_chunk_header_sizes[type];
+    iterator->bytes_left = size;
+
+    return 0;
+
+error_bad_chunk:
+    return -1;
+}
+
 nexrad_chunk *nexrad_chunk_open(void *chunk, enum nexrad_chunk_type type) {
     nexrad_chunk *iterator;
-    size_t size;
 
     if (chunk == NULL) {
         return NULL;
     }
 
-    if ((size = find_chunk_size(chunk, type)) == 0) {
-        goto error_bad_chunk;
-    }
-
     if ((iterator = malloc(sizeof(*iterator))) == NULL) {
         goto error_malloc;
     }
 
-    iterator->type       = nexrad_chunk_child_types[type];
-    iterator->current    = (char *)chunk + nexrad_chunk_header_sizes[type];
-    iterator->bytes_left = size;
+    if (nexrad_chunk_init(iterator, chunk, type) < 0) {
+        goto error_init;
+    }
 
     return iterator;
 
+error_init:
+    free(iterator);
+
 error_malloc:
-error_bad_chunk:
     return NULL;
 }
 
 void *nexrad_chunk_peek(nexrad_chunk *iterator, size_t *size, size_t *payload, void **data) {
-    size_t chunk_size;
-    size_t header_size;
+    ssize_t chunk_size;
+    size_t  header_size;
 
     if (iterator == NULL) {
         return NULL;
@@ -157,7 +173,15 @@ void *nexrad_chunk_peek(nexrad_chunk *iterator, size_t *size, size_t *payload, v
      * Determine the size of the current chunk based on the child type currently
      * being iterated over.
      */
-    chunk_size = find_chunk_size(iterator->current, iterator->type);
+    chunk_size = find_chunk_size(iterator->current, iterator->type, iterator->bytes_left);
+
+    /*
+     * Stop at any chunk which is invalid, or which claims to extend beyond the
+     * end of its parent.
+     */
+    if (chunk_size < 0 || chunk_size + header_size > iterator->bytes_left) {
+        return NULL;
+    }
 
     /*
      * If a pointer was provided to store the resultant total chunk size in,
@@ -248,6 +272,19 @@ error_chunk_read:
     return NULL;
 }
 
+int nexrad_chunk_read_block_layer_init(nexrad_chunk *block, nexrad_chunk *layer, enum nexrad_chunk_type type) {
+    void *data;
+
+    if ((data = nexrad_chunk_read(block, NULL, NULL, NULL)) == NULL) {
+        goto error_chunk_read;
+    }
+
+    return nexrad_chunk_init(layer, data, type);
+
+error_chunk_read:
+    return -1;
+}
+
 void nexrad_chunk_close(nexrad_chunk *iterator) {
     if (iterator == NULL) return;
 
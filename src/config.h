@@ -0,0 +1,5 @@
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include <endian.h>
+#define HAVE_IO_URING 1
+#endif /* _CONFIG_H */
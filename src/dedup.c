@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "util.h"
+#include "message_internal.h"
+
+#include <nexrad/message.h>
+#include <nexrad/dedup.h>
+
+/*
+ * Each slot of the set is a single 64-bit word, holding the upper 40 bits of
+ * the hash of a message as its tag, and the time the message was last seen in
+ * the lower 24 bits, in seconds since the set was created, modulo 2^24; this
+ * allows slots to be claimed and updated with a single compare-and-swap.
+ * A slot holding zero has never been used, and a slot with a tag of zero has
+ * been released, and may be reused.
+ */
+#define DEDUP_TICK_BITS  24
+#define DEDUP_TICK_MASK  ((1ULL << DEDUP_TICK_BITS) - 1)
+#define DEDUP_MAX_WINDOW (DEDUP_TICK_MASK >> 1)
+#define DEDUP_EMPTY      0ULL
+#define DEDUP_RELEASED   1ULL
+#define DEDUP_MAX_PROBES 32
+
+struct _nexrad_dedup {
+    uint64_t * slots;
+    size_t     mask;
+    uint64_t   window;
+    time_t     epoch;
+};
+
+static time_t _monotonic() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec;
+}
+
+nexrad_dedup *nexrad_dedup_create(size_t capacity, time_t window) {
+    nexrad_dedup *dedup;
+    size_t count = DEDUP_MAX_PROBES;
+
+    if (window < 0 || window > DEDUP_MAX_WINDOW) {
+        errno = EINVAL;
+
+        goto error_invalid;
+    }
+
+    while (count < capacity) {
+        count <<= 1;
+    }
+
+    if ((dedup = malloc(sizeof(*dedup))) == NULL) {
+        goto error_malloc;
+    }
+
+    if ((dedup->slots = calloc(count, sizeof(uint64_t))) == NULL) {
+        goto error_calloc_slots;
+    }
+
+    dedup->mask   = count - 1;
+    dedup->window = window;
+    dedup->epoch  = _monotonic();
+
+    return dedup;
+
+error_calloc_slots:
+    free(dedup);
+
+error_malloc:
+error_invalid:
+    return NULL;
+}
+
+static inline uint64_t _slot_tag(uint64_t word) {
+    return word >> DEDUP_TICK_BITS;
+}
+
+/*
+ * Determine the number of seconds since a slot was last stamped, as seen from
+ * `tick`.  Another thread may have stamped the slot just after the clock
+ * ticked over, in which case the slot appears to be from the future; the
+ * difference is therefore taken as a signed 24-bit value, so that such slots
+ * have a negative age rather than one of nearly 2^24 seconds.
+ */
+static inline int64_t _slot_age(uint64_t word, uint64_t tick) {
+    uint64_t diff = (tick - (word & DEDUP_TICK_MASK)) & DEDUP_TICK_MASK;
+
+    return (int64_t)(diff ^ (1ULL << (DEDUP_TICK_BITS - 1))) - (1LL << (DEDUP_TICK_BITS - 1));
+}
+
+static inline int _slot_live(nexrad_dedup *dedup, uint64_t word, uint64_t tick) {
+    return _slot_tag(word) != 0 && _slot_age(word, tick) <= (int64_t)dedup->window;
+}
+
+static int _dedup_insert(nexrad_dedup *dedup, uint64_t hash, uint64_t tick) {
+    uint64_t tag  = hash >> DEDUP_TICK_BITS? hash >> DEDUP_TICK_BITS: 1,
+             word = (tag << DEDUP_TICK_BITS) | tick,
+             claimed;
+
+    size_t home = hash & dedup->mask, i, claim;
+
+retry:
+    claimed = DEDUP_EMPTY;
+    claim   = DEDUP_MAX_PROBES;
+
+    /*
+     * Probe for a live slot holding the same message, noting the first slot
+     * which may be claimed should the message not be found; as slots are never
+     * emptied once used, the probe ends at the first empty slot.
+     */
+    for (i=0; i<DEDUP_MAX_PROBES; i++) {
+        uint64_t *slot = &dedup->slots[(home + i) & dedup->mask],
+                  current = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+        if (current == DEDUP_EMPTY) {
+            if (claim == DEDUP_MAX_PROBES) {
+                claim   = i;
+                claimed = current;
+            }
+
+            break;
+        }
+
+        if (_slot_live(dedup, current, tick)) {
+            if (_slot_tag(current) == tag) {
+                if (_slot_age(current, tick) > 0) {
+                    __sync_bool_compare_and_swap(slot, current, word);
+                }
+
+                return 1;
+            }
+        } else if (claim == DEDUP_MAX_PROBES) {
+            claim   = i;
+            claimed = current;
+        }
+    }
+
+    if (claim == DEDUP_MAX_PROBES) {
+        return 0;
+    }
+
+    if (!__sync_bool_compare_and_swap(&dedup->slots[(home + claim) & dedup->mask], claimed, word)) {
+        goto retry;
+    }
+
+    /*
+     * Another thread may have recorded the same message in a different slot
+     * at the same time; should that be so, the copy nearest the start of the
+     * probe sequence wins, and the other is released and reported as a
+     * duplicate.
+     */
+    for (i=0; i<claim; i++) {
+        uint64_t current = __atomic_load_n(&dedup->slots[(home + i) & dedup->mask], __ATOMIC_ACQUIRE);
+
+        if (_slot_tag(current) == tag && _slot_live(dedup, current, tick)) {
+            __sync_bool_compare_and_swap(&dedup->slots[(home + claim) & dedup->mask], word, DEDUP_RELEASED);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int nexrad_dedup_check_buf(nexrad_dedup *dedup, const void *buf, size_t len) {
+    nexrad_message_info info;
+    size_t offset, size;
+    uint64_t hash;
+
+    struct {
+        char     station[5];
+        char     product_code[4];
+        int16_t  seq;
+        int64_t  scan_timestamp;
+        int64_t  gen_timestamp;
+    } key;
+
+    if (dedup == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (nexrad_message_peek_buf(buf, len, &info) < 0) {
+        return -1;
+    }
+
+    memset(&key, '\0', sizeof(key));
+    memcpy(key.station,      info.station,      sizeof(key.station));
+    memcpy(key.product_code, info.product_code, sizeof(key.product_code));
+
+    key.seq            = info.seq;
+    key.scan_timestamp = info.scan_timestamp;
+    key.gen_timestamp  = info.gen_timestamp;
+
+    offset = message_header_offset(buf, len);
+    size   = info.size < len - offset? info.size: len - offset;
+
+    hash = hash64(&key, sizeof(key))
+         ^ (hash64((const char *)buf + offset, size) * 0x9e3779b97f4a7c15ULL);
+
+    return _dedup_insert(dedup, hash, (_monotonic() - dedup->epoch) & DEDUP_TICK_MASK);
+}
+
+void nexrad_dedup_destroy(nexrad_dedup *dedup) {
+    if (dedup == NULL) {
+        return;
+    }
+
+    free(dedup->slots);
+
+    memset(dedup, '\0', sizeof(*dedup));
+
+    free(dedup);
+}
@@ -0,0 +1,536 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <bzlib.h>
+#include "util.h"
+#include "message_internal.h"
+
+#include <nexrad/feed.h>
+
+#define NEXRAD_MESSAGE_FEED_BUFFER_SIZE 65536
+
+struct _nexrad_message_feed {
+    nexrad_message_ctx *           ctx;
+    enum nexrad_message_feed_state state;
+
+    uint8_t * buf;  /* Data of current message, and any data following */
+    size_t    len;  /* Amount of data in buffer */
+    size_t    size; /* Size of buffer */
+
+    size_t header_offset; /* Offset of message header within buffer */
+    size_t total;         /* Size of current message, once known */
+    size_t skip;          /* Data left to discard from an invalid message */
+
+    bz_stream stream;
+    int       compressed;  /* Current message body is compressed */
+    int       stream_end;  /* End of compressed body reached */
+    size_t    fed;         /* Offset of compressed data not yet decompressed */
+    uint8_t * body;
+    size_t    body_size; /* Size of buffer holding decompressed body */
+    size_t    body_len;  /* Number of bytes decompressed */
+};
+
+/*
+ * Ensure the feed buffer can hold at least `size` bytes, followed by room for
+ * the zeroed slack which is to follow a message once handed over to a message
+ * object.
+ */
+static int _feed_reserve(nexrad_message_feed *feed, size_t size) {
+    uint8_t *buf;
+    size_t newsize = feed->size? feed->size: NEXRAD_MESSAGE_FEED_BUFFER_SIZE;
+
+    size += MESSAGE_READ_SLACK;
+
+    if (size <= feed->size) {
+        return 0;
+    }
+
+    while (newsize < size) {
+        newsize *= 2;
+    }
+
+    if ((buf = realloc(feed->buf, newsize)) == NULL) {
+        return -1;
+    }
+
+    feed->buf  = buf;
+    feed->size = newsize;
+
+    return 0;
+}
+
+static void _feed_discard(nexrad_message_feed *feed, size_t len) {
+    if (len >= feed->len) {
+        feed->len = 0;
+
+        return;
+    }
+
+    memmove(feed->buf, feed->buf + len, feed->len - len);
+
+    feed->len -= len;
+}
+
+static void _feed_stream_end(nexrad_message_feed *feed) {
+    if (feed->compressed && !feed->stream_end) {
+        BZ2_bzDecompressEnd(&feed->stream);
+    }
+
+    if (feed->body) {
+        message_ctx_body_give(feed->ctx, feed->body, feed->body_size);
+    }
+
+    feed->compressed = 0;
+    feed->stream_end = 0;
+    feed->body       = NULL;
+    feed->body_size  = 0;
+    feed->body_len   = 0;
+}
+
+/*
+ * Discard the current message, including any of its data which has yet to
+ * arrive, and resume searching for the next message.
+ */
+static void _feed_error(nexrad_message_feed *feed) {
+    _feed_stream_end(feed);
+
+    if (feed->len >= feed->total) {
+        _feed_discard(feed, feed->total);
+    } else {
+        feed->skip = feed->total - feed->len;
+        feed->len  = 0;
+    }
+
+    feed->total = 0;
+    feed->state = NEXRAD_MESSAGE_FEED_ERROR;
+}
+
+/*
+ * Search for the start of a message, discarding any data preceding it.
+ * Returns 0 once a message header has been found and validated, or -1 if
+ * more data is required.
+ */
+static int _feed_sync(nexrad_message_feed *feed) {
+    size_t siglen = strlen(NEXRAD_HEADER_WMO_SIGNATURE);
+
+    for (;;) {
+        nexrad_wmo_header *wmo_header;
+        nexrad_message_header *message_header;
+        size_t offset = 0, start, size;
+
+        while (offset + siglen <= feed->len
+          && memcmp(feed->buf + offset, NEXRAD_HEADER_WMO_SIGNATURE, siglen) != 0) {
+            offset++;
+        }
+
+        /*
+         * If no signature was found, hold onto just enough data to recognise
+         * an unknown header and signature straddling the next push.
+         */
+        if (offset + siglen > feed->len) {
+            if (feed->len > sizeof(nexrad_unknown_header) + siglen) {
+                _feed_discard(feed, feed->len - sizeof(nexrad_unknown_header) - siglen);
+            }
+
+            return -1;
+        }
+
+        start = offset;
+
+        if (offset >= sizeof(nexrad_unknown_header)
+          && memcmp(feed->buf + offset - sizeof(nexrad_unknown_header),
+                    NEXRAD_HEADER_UNKNOWN_SIGNATURE, 4) == 0) {
+            start -= sizeof(nexrad_unknown_header);
+        }
+
+        _feed_discard(feed, start);
+
+        offset -= start;
+
+        feed->header_offset = offset + sizeof(nexrad_wmo_header);
+
+        if (feed->len < feed->header_offset + sizeof(nexrad_message_header)) {
+            return -1;
+        }
+
+        wmo_header     = (nexrad_wmo_header *)(feed->buf + offset);
+        message_header = (nexrad_message_header *)(feed->buf + feed->header_offset);
+        size           = be32toh(message_header->size);
+
+        if (wmo_header->_whitespace1 != ' '
+          || be16toh(message_header->blocks) > 5
+          || size < sizeof(nexrad_message_header) + sizeof(nexrad_product_description)
+          || size > NEXRAD_MESSAGE_MAX_SIZE) {
+            _feed_discard(feed, offset + 1);
+
+            continue;
+        }
+
+        feed->total = feed->header_offset + size;
+
+        return 0;
+    }
+}
+
+static int _feed_begin_body(nexrad_message_feed *feed) {
+    nexrad_product_description *description = nexrad_message_feed_get_product_description(feed);
+    unsigned int destlen;
+
+    feed->fed = feed->header_offset
+        + sizeof(nexrad_message_header)
+        + sizeof(nexrad_product_description);
+
+    if (!nexrad_product_type_supports_compression(be16toh(description->type))) {
+        return 0;
+    }
+
+    if (be16toh(description->attributes.compression.method) != NEXRAD_PRODUCT_COMPRESSION_BZIP2) {
+        return 0;
+    }
+
+    if ((destlen = be32toh(description->attributes.compression.size)) > NEXRAD_MESSAGE_MAX_BODY_SIZE) {
+        goto error_decompress_size;
+    }
+
+    if ((feed->body = message_ctx_body_take(feed->ctx, destlen, &feed->body_size)) == NULL) {
+        goto error_body_take;
+    }
+
+    memset(&feed->stream, '\0', sizeof(feed->stream));
+
+    if (BZ2_bzDecompressInit(&feed->stream, 0, 0) != BZ_OK) {
+        goto error_decompress_init;
+    }
+
+    feed->stream.next_out  = (char *)feed->body;
+    feed->stream.avail_out = destlen;
+    feed->compressed       = 1;
+    feed->stream_end       = 0;
+
+    return 0;
+
+error_decompress_init:
+    message_ctx_body_give(feed->ctx, feed->body, feed->body_size);
+
+    feed->body      = NULL;
+    feed->body_size = 0;
+
+error_body_take:
+error_decompress_size:
+    return -1;
+}
+
+/*
+ * Decompress whatever compressed body data has arrived since the last call.
+ */
+static int _feed_decompress(nexrad_message_feed *feed) {
+    size_t end = feed->len < feed->total? feed->len: feed->total;
+    int ret;
+
+    if (!feed->compressed || feed->stream_end || end <= feed->fed) {
+        return 0;
+    }
+
+    feed->stream.next_in  = (char *)feed->buf + feed->fed;
+    feed->stream.avail_in = end - feed->fed;
+
+    do {
+        unsigned int avail_out = feed->stream.avail_out;
+
+        ret = BZ2_bzDecompress(&feed->stream);
+
+        if (ret == BZ_OK && feed->stream.avail_in > 0 && feed->stream.avail_out == avail_out) {
+            ret = BZ_OUTBUFF_FULL;
+        }
+    } while (ret == BZ_OK && feed->stream.avail_in > 0);
+
+    feed->fed = end - feed->stream.avail_in;
+
+    if (ret == BZ_STREAM_END) {
+        feed->body_len = feed->stream.total_out_lo32;
+
+        BZ2_bzDecompressEnd(&feed->stream);
+
+        feed->stream_end = 1;
+    } else if (ret != BZ_OK) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void _feed_process(nexrad_message_feed *feed) {
+    for (;;) {
+        switch (feed->state) {
+            case NEXRAD_MESSAGE_FEED_ERROR:
+            case NEXRAD_MESSAGE_FEED_NONE: {
+                if (_feed_sync(feed) < 0) {
+                    return;
+                }
+
+                if (_feed_reserve(feed, feed->total) < 0) {
+                    _feed_error(feed);
+
+                    return;
+                }
+
+                feed->state = NEXRAD_MESSAGE_FEED_HEADER;
+
+                break;
+            }
+
+            case NEXRAD_MESSAGE_FEED_HEADER: {
+                nexrad_product_description *description;
+
+                if (feed->len < feed->header_offset + sizeof(nexrad_message_header) + sizeof(nexrad_product_description)) {
+                    return;
+                }
+
+                description = nexrad_message_feed_get_product_description(feed);
+
+                if ((int16_t)be16toh(description->divider) != -1 || _feed_begin_body(feed) < 0) {
+                    _feed_error(feed);
+
+                    return;
+                }
+
+                feed->state = NEXRAD_MESSAGE_FEED_DESCRIPTION;
+
+                break;
+            }
+
+            case NEXRAD_MESSAGE_FEED_DESCRIPTION: {
+                if (_feed_decompress(feed) < 0) {
+                    _feed_error(feed);
+
+                    return;
+                }
+
+                if (feed->len < feed->total) {
+                    return;
+                }
+
+                if (feed->compressed && !feed->stream_end) {
+                    _feed_error(feed);
+
+                    return;
+                }
+
+                feed->state = NEXRAD_MESSAGE_FEED_COMPLETE;
+
+                break;
+            }
+
+            case NEXRAD_MESSAGE_FEED_COMPLETE: {
+                return;
+            }
+        }
+    }
+}
+
+nexrad_message_feed *nexrad_message_feed_create(nexrad_message_ctx *ctx) {
+    nexrad_message_feed *feed;
+
+    if ((feed = calloc(1, sizeof(*feed))) == NULL) {
+        goto error_calloc;
+    }
+
+    feed->ctx   = ctx;
+    feed->state = NEXRAD_MESSAGE_FEED_NONE;
+
+    if (_feed_reserve(feed, NEXRAD_MESSAGE_FEED_BUFFER_SIZE) < 0) {
+        goto error_feed_reserve;
+    }
+
+    return feed;
+
+error_feed_reserve:
+    free(feed);
+
+error_calloc:
+    return NULL;
+}
+
+enum nexrad_message_feed_state nexrad_message_feed_push(nexrad_message_feed *feed, const void *buf, size_t len) {
+    if (feed == NULL || buf == NULL) {
+        errno = EINVAL;
+
+        return NEXRAD_MESSAGE_FEED_ERROR;
+    }
+
+    /*
+     * Drop any data remaining from a message which was found to be invalid
+     * before it had fully arrived.
+     */
+    if (feed->skip > 0) {
+        size_t skip = feed->skip < len? feed->skip: len;
+
+        buf  = (uint8_t *)buf + skip;
+        len -= skip;
+
+        feed->skip -= skip;
+    }
+
+    if (feed->state == NEXRAD_MESSAGE_FEED_ERROR) {
+        feed->state = NEXRAD_MESSAGE_FEED_NONE;
+    }
+
+    if (_feed_reserve(feed, feed->len + len) < 0) {
+        return NEXRAD_MESSAGE_FEED_ERROR;
+    }
+
+    memcpy(feed->buf + feed->len, buf, len);
+
+    feed->len += len;
+
+    _feed_process(feed);
+
+    return feed->state;
+}
+
+enum nexrad_message_feed_state nexrad_message_feed_get_state(nexrad_message_feed *feed) {
+    if (feed == NULL) {
+        return NEXRAD_MESSAGE_FEED_ERROR;
+    }
+
+    return feed->state;
+}
+
+nexrad_wmo_header *nexrad_message_feed_get_wmo_header(nexrad_message_feed *feed) {
+    if (feed == NULL || feed->state < NEXRAD_MESSAGE_FEED_HEADER) {
+        return NULL;
+    }
+
+    return (nexrad_wmo_header *)(feed->buf + feed->header_offset - sizeof(nexrad_wmo_header));
+}
+
+nexrad_message_header *nexrad_message_feed_get_header(nexrad_message_feed *feed) {
+    if (feed == NULL || feed->state < NEXRAD_MESSAGE_FEED_HEADER) {
+        return NULL;
+    }
+
+    return (nexrad_message_header *)(feed->buf + feed->header_offset);
+}
+
+nexrad_product_description *nexrad_message_feed_get_product_description(nexrad_message_feed *feed) {
+    if (feed == NULL || feed->state < NEXRAD_MESSAGE_FEED_HEADER) {
+        return NULL;
+    }
+
+    if (feed->len < feed->header_offset + sizeof(nexrad_message_header) + sizeof(nexrad_product_description)) {
+        return NULL;
+    }
+
+    return (nexrad_product_description *)(feed->buf
+        + feed->header_offset + sizeof(nexrad_message_header));
+}
+
+nexrad_message *nexrad_message_feed_read_message(nexrad_message_feed *feed) {
+    nexrad_message *message;
+    uint8_t *data;
+    size_t size, leftover, cap;
+
+    if (feed == NULL || feed->state != NEXRAD_MESSAGE_FEED_COMPLETE) {
+        return NULL;
+    }
+
+    data     = feed->buf;
+    size     = feed->total;
+    cap      = feed->size;
+    leftover = feed->len - feed->total;
+
+    /*
+     * Hand the buffer containing the current message over to the message
+     * object, and move any data following it into a new buffer.
+     */
+    feed->buf  = NULL;
+    feed->len  = 0;
+    feed->size = 0;
+
+    if (_feed_reserve(feed, leftover > 0? leftover: NEXRAD_MESSAGE_FEED_BUFFER_SIZE) < 0) {
+        goto error_feed_reserve;
+    }
+
+    memcpy(feed->buf, data + size, leftover);
+
+    feed->len = leftover;
+
+    /*
+     * Follow the message with zeroed slack, as with any other message read
+     * into a buffer, in place of the data following it, now moved; the buffer
+     * always has room for it, as reserved by _feed_reserve().
+     */
+    memset(data + size, '\0', MESSAGE_READ_SLACK);
+
+    if ((message = message_open_decoded(data, size, feed->body, feed->body_size, feed->body_len, feed->ctx)) == NULL) {
+        goto error_message_open_decoded;
+    }
+
+    feed->body       = NULL;
+    feed->body_size  = 0;
+    feed->body_len   = 0;
+    feed->compressed = 0;
+    feed->stream_end = 0;
+    feed->total      = 0;
+    feed->state      = NEXRAD_MESSAGE_FEED_NONE;
+
+    _feed_process(feed);
+
+    return message;
+
+error_message_open_decoded:
+    free(data);
+
+    _feed_stream_end(feed);
+
+    feed->total = 0;
+    feed->state = NEXRAD_MESSAGE_FEED_NONE;
+
+    _feed_process(feed);
+
+    return NULL;
+
+error_feed_reserve:
+    feed->buf  = data;
+    feed->len  = size + leftover;
+    feed->size = cap;
+
+    return NULL;
+}
+
+void nexrad_message_feed_destroy(nexrad_message_feed *feed) {
+    if (feed == NULL) {
+        return;
+    }
+
+    _feed_stream_end(feed);
+
+    free(feed->buf);
+
+    memset(feed, '\0', sizeof(*feed));
+
+    free(feed);
+}
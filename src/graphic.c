@@ -29,10 +29,18 @@ nexrad_chunk *nexrad_graphic_block_open(nexrad_graphic_block *block) {
     return nexrad_chunk_open(block, NEXRAD_CHUNK_GRAPHIC_BLOCK);
 }
 
+int nexrad_graphic_block_init(nexrad_chunk *iterator, nexrad_graphic_block *block) {
+    return nexrad_chunk_init(iterator, block, NEXRAD_CHUNK_GRAPHIC_BLOCK);
+}
+
 nexrad_chunk *nexrad_graphic_block_read_page(nexrad_chunk *block) {
     return nexrad_chunk_read_block_layer(block, NEXRAD_CHUNK_GRAPHIC_PAGE);
 }
 
+int nexrad_graphic_block_read_page_init(nexrad_chunk *block, nexrad_chunk *page) {
+    return nexrad_chunk_read_block_layer_init(block, page, NEXRAD_CHUNK_GRAPHIC_PAGE);
+}
+
 void nexrad_graphic_page_next_packet(nexrad_chunk *page, size_t size) {
     nexrad_chunk_next(page, size);
 }
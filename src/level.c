@@ -0,0 +1,456 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "util.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define LEVEL_HAVE_AVX2
+#endif
+
+#include <nexrad/level.h>
+#include <nexrad/dvl.h>
+#include <nexrad/eet.h>
+
+#define LEVEL_KNOTS_M_S 0.514444f
+
+/*
+ * Bits of the most significant byte of a 16 level data threshold; the least
+ * significant byte holds either a value, or a code when LEVEL_THRESHOLD_CODE
+ * is set.
+ */
+#define LEVEL_THRESHOLD_CODE      0x8000
+#define LEVEL_THRESHOLD_SCALE_20  0x4000
+#define LEVEL_THRESHOLD_SCALE_100 0x2000
+#define LEVEL_THRESHOLD_SCALE_10  0x1000
+#define LEVEL_THRESHOLD_NEGATIVE  0x0100
+
+#define LEVEL_THRESHOLD_CODE_RF 3
+
+enum level_encoding {
+    LEVEL_THRESHOLDS, /* 16 data level thresholds */
+    LEVEL_LINEAR,     /* Minimum value, increment and number of levels */
+    LEVEL_FLOAT,      /* Floating point scale and offset */
+    LEVEL_DVL,        /* Digital vertically integrated liquid */
+    LEVEL_EET         /* Enhanced echo tops */
+};
+
+struct level_product {
+    uint16_t               type;
+    enum level_encoding    encoding;
+    enum nexrad_level_unit unit;
+    float                  factor; /* Converts values given to `unit` */
+    int                    folded; /* Data level 1 denotes range folding */
+};
+
+static const struct level_product level_products[] = {
+    {  16, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  17, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  18, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  19, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  20, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  21, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  22, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  23, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  24, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  25, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  26, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  27, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  28, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  29, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  30, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  32, LEVEL_LINEAR,     NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  35, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  36, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  37, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  38, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  41, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_FT,     1000.0f,         0 },
+    {  56, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_M_S,    LEVEL_KNOTS_M_S, 0 },
+    {  57, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_KG_M2,  1.0f,            0 },
+    {  65, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  66, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  90, LEVEL_THRESHOLDS, NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  94, LEVEL_LINEAR,     NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    {  99, LEVEL_LINEAR,     NEXRAD_LEVEL_UNIT_M_S,    1.0f,            1 },
+    { 134, LEVEL_DVL,        NEXRAD_LEVEL_UNIT_KG_M2,  1.0f,            0 },
+    { 135, LEVEL_EET,        NEXRAD_LEVEL_UNIT_FT,     1.0f,            0 },
+    { 153, LEVEL_LINEAR,     NEXRAD_LEVEL_UNIT_DBZ,    1.0f,            0 },
+    { 154, LEVEL_LINEAR,     NEXRAD_LEVEL_UNIT_M_S,    1.0f,            1 },
+    { 155, LEVEL_LINEAR,     NEXRAD_LEVEL_UNIT_M_S,    1.0f,            1 },
+    { 159, LEVEL_FLOAT,      NEXRAD_LEVEL_UNIT_DB,     1.0f,            1 },
+    { 161, LEVEL_FLOAT,      NEXRAD_LEVEL_UNIT_RATIO,  1.0f,            1 },
+    { 163, LEVEL_FLOAT,      NEXRAD_LEVEL_UNIT_DEG_KM, 1.0f,            1 }
+};
+
+struct _nexrad_level_table {
+    float values[NEXRAD_LEVEL_TABLE_SIZE];
+
+    /*
+     * One more entry than needed, so that the 32-bit gathers performed by
+     * _decode_int16_avx2() never read beyond the end of the table.
+     */
+    int16_t scaled[NEXRAD_LEVEL_TABLE_SIZE + 1];
+    float   scale;
+
+    enum nexrad_level_unit unit;
+};
+
+static const struct level_product *_level_product(uint16_t type) {
+    size_t i;
+
+    for (i=0; i<sizeof(level_products) / sizeof(level_products[0]); i++) {
+        if (level_products[i].type == type) {
+            return &level_products[i];
+        }
+    }
+
+    return NULL;
+}
+
+static float _default_scale(enum nexrad_level_unit unit) {
+    switch (unit) {
+        case NEXRAD_LEVEL_UNIT_DBZ:
+        case NEXRAD_LEVEL_UNIT_M_S:
+        case NEXRAD_LEVEL_UNIT_KG_M2:  return 10.0f;
+        case NEXRAD_LEVEL_UNIT_FT:     return 0.01f;
+        case NEXRAD_LEVEL_UNIT_DB:
+        case NEXRAD_LEVEL_UNIT_DEG_KM: return 100.0f;
+        case NEXRAD_LEVEL_UNIT_RATIO:  return 1000.0f;
+
+        default: {
+            break;
+        }
+    }
+
+    return 1.0f;
+}
+
+static float _threshold_value(uint16_t threshold, float factor) {
+    float value;
+
+    if (threshold & LEVEL_THRESHOLD_CODE) {
+        return (threshold & 0xff) == LEVEL_THRESHOLD_CODE_RF?
+            NEXRAD_LEVEL_RANGE_FOLDED: NEXRAD_LEVEL_NO_DATA;
+    }
+
+    value = threshold & 0xff;
+
+    if (threshold & LEVEL_THRESHOLD_SCALE_20)  value /= 20.0f;
+    if (threshold & LEVEL_THRESHOLD_SCALE_100) value /= 100.0f;
+    if (threshold & LEVEL_THRESHOLD_SCALE_10)  value /= 10.0f;
+    if (threshold & LEVEL_THRESHOLD_NEGATIVE)  value = -value;
+
+    return value * factor;
+}
+
+static float _float_param(uint16_t *halfwords) {
+    uint32_t bits = ((uint32_t)be16toh(halfwords[0]) << 16) | be16toh(halfwords[1]);
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static int _fill_values(nexrad_level_table *table, const struct level_product *product, uint16_t *thresholds) {
+    int i;
+
+    switch (product->encoding) {
+        case LEVEL_THRESHOLDS: {
+            /*
+             * Run length encoded levels 0-15 are expanded to rangebin values
+             * 0-240, in steps of NEXRAD_RADIAL_RLE_FACTOR, by the radial and
+             * raster decoders.
+             */
+            for (i=0; i<NEXRAD_LEVEL_TABLE_SIZE; i++) {
+                table->values[i] = _threshold_value(be16toh(thresholds[i >> 4]), product->factor);
+            }
+
+            break;
+        }
+
+        case LEVEL_LINEAR: {
+            float min       = (int16_t)be16toh(thresholds[0]) / 10.0f,
+                  increment = be16toh(thresholds[1]) / 10.0f;
+            int   levels    = be16toh(thresholds[2]);
+
+            for (i=0; i<NEXRAD_LEVEL_TABLE_SIZE; i++) {
+                if (i >= 2 && i < 2 + levels) {
+                    table->values[i] = (min + (i - 2) * increment) * product->factor;
+                } else {
+                    table->values[i] = NEXRAD_LEVEL_NO_DATA;
+                }
+            }
+
+            break;
+        }
+
+        case LEVEL_FLOAT: {
+            float scale  = _float_param(&thresholds[0]),
+                  offset = _float_param(&thresholds[2]);
+
+            if (scale == 0.0f || isnan(scale) || isnan(offset)) {
+                return -1;
+            }
+
+            for (i=0; i<NEXRAD_LEVEL_TABLE_SIZE; i++) {
+                table->values[i] = i < 2?
+                    NEXRAD_LEVEL_NO_DATA: ((i - offset) / scale) * product->factor;
+            }
+
+            break;
+        }
+
+        case LEVEL_DVL: {
+            for (i=0; i<NEXRAD_LEVEL_TABLE_SIZE; i++) {
+                table->values[i] = nexrad_dvl_valid(i)?
+                    nexrad_dvl_vil(i): NEXRAD_LEVEL_NO_DATA;
+            }
+
+            break;
+        }
+
+        case LEVEL_EET: {
+            for (i=0; i<NEXRAD_LEVEL_TABLE_SIZE; i++) {
+                table->values[i] = nexrad_eet_valid(i)?
+                    nexrad_eet_meters(i) / NEXRAD_PRODUCT_ALT_FACTOR: NEXRAD_LEVEL_NO_DATA;
+            }
+
+            break;
+        }
+    }
+
+    if (product->folded) {
+        table->values[1] = NEXRAD_LEVEL_RANGE_FOLDED;
+    }
+
+    return 0;
+}
+
+static void _fill_scaled(nexrad_level_table *table) {
+    int i;
+
+    for (i=0; i<NEXRAD_LEVEL_TABLE_SIZE; i++) {
+        float value = table->values[i], scaled;
+
+        if (value == NEXRAD_LEVEL_NO_DATA) {
+            table->scaled[i] = NEXRAD_LEVEL_INT16_NO_DATA;
+        } else if (value == NEXRAD_LEVEL_RANGE_FOLDED) {
+            table->scaled[i] = NEXRAD_LEVEL_INT16_RANGE_FOLDED;
+        } else {
+            /*
+             * Saturate short of the sentinels at the bottom of the range.
+             */
+            scaled = roundf(value * table->scale);
+
+            if (scaled > INT16_MAX) {
+                scaled = INT16_MAX;
+            } else if (scaled < NEXRAD_LEVEL_INT16_RANGE_FOLDED + 1) {
+                scaled = NEXRAD_LEVEL_INT16_RANGE_FOLDED + 1;
+            }
+
+            table->scaled[i] = (int16_t)scaled;
+        }
+    }
+
+    table->scaled[NEXRAD_LEVEL_TABLE_SIZE] = 0;
+}
+
+nexrad_level_table *nexrad_level_table_create(nexrad_product_description *description) {
+    const struct level_product *product;
+    nexrad_level_table *table;
+    uint16_t thresholds[16];
+
+    if (description == NULL) {
+        goto error_invalid;
+    }
+
+    if ((product = _level_product(be16toh(description->type))) == NULL) {
+        goto error_invalid;
+    }
+
+    if ((table = malloc(sizeof(*table))) == NULL) {
+        goto error_malloc;
+    }
+
+    /*
+     * The product description may lie at any alignment within the message.
+     */
+    memcpy(thresholds, description->attributes.generic.thresholds, sizeof(thresholds));
+
+    if (_fill_values(table, product, thresholds) < 0) {
+        goto error_fill_values;
+    }
+
+    table->unit  = product->unit;
+    table->scale = _default_scale(product->unit);
+
+    _fill_scaled(table);
+
+    return table;
+
+error_fill_values:
+    free(table);
+
+error_invalid:
+    errno = EINVAL;
+
+error_malloc:
+    return NULL;
+}
+
+enum nexrad_level_unit nexrad_level_table_get_unit(nexrad_level_table *table) {
+    if (table == NULL) {
+        return NEXRAD_LEVEL_UNIT_NONE;
+    }
+
+    return table->unit;
+}
+
+float nexrad_level_table_get_value(nexrad_level_table *table, uint8_t v) {
+    if (table == NULL) {
+        return NEXRAD_LEVEL_NO_DATA;
+    }
+
+    return table->values[v];
+}
+
+int nexrad_level_table_set_int16_scale(nexrad_level_table *table, float scale) {
+    if (table == NULL || !(scale > 0.0f) || isinf(scale)) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    table->scale = scale;
+
+    _fill_scaled(table);
+
+    return 0;
+}
+
+float nexrad_level_table_get_int16_scale(nexrad_level_table *table) {
+    if (table == NULL) {
+        return 0.0f;
+    }
+
+    return table->scale;
+}
+
+#ifdef LEVEL_HAVE_AVX2
+static int _have_avx2() {
+    static int have = -1;
+    int ret;
+
+    if ((ret = __atomic_load_n(&have, __ATOMIC_RELAXED)) < 0) {
+        __builtin_cpu_init();
+
+        ret = __builtin_cpu_supports("avx2")? 1: 0;
+
+        __atomic_store_n(&have, ret, __ATOMIC_RELAXED);
+    }
+
+    return ret;
+}
+
+__attribute__((target("avx2")))
+static size_t _decode_float_avx2(const float *lut, float *dest, const uint8_t *values, size_t count) {
+    size_t i;
+
+    for (i=0; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(values + i)));
+
+        _mm256_storeu_ps(dest + i, _mm256_i32gather_ps(lut, index, 4));
+    }
+
+    return i;
+}
+
+/*
+ * Gather 32 bits at each 16-bit table entry, keeping the lower half of each,
+ * which on this little endian architecture holds the entry wanted.
+ */
+__attribute__((target("avx2")))
+static size_t _decode_int16_avx2(const int16_t *lut, int16_t *dest, const uint8_t *values, size_t count) {
+    size_t i;
+
+    for (i=0; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(values + i));
+
+        __m256i lo = _mm256_i32gather_epi32((const int *)lut, _mm256_cvtepu8_epi32(bytes), 2),
+                hi = _mm256_i32gather_epi32((const int *)lut, _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)), 2);
+
+        lo = _mm256_srai_epi32(_mm256_slli_epi32(lo, 16), 16);
+        hi = _mm256_srai_epi32(_mm256_slli_epi32(hi, 16), 16);
+
+        _mm256_storeu_si256((__m256i *)(dest + i),
+            _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+    }
+
+    return i;
+}
+#endif
+
+void nexrad_level_decode_float(nexrad_level_table *table, float *dest, const uint8_t *values, size_t count) {
+    size_t i = 0;
+
+    if (table == NULL || dest == NULL || values == NULL) {
+        return;
+    }
+
+#ifdef LEVEL_HAVE_AVX2
+    if (_have_avx2()) {
+        i = _decode_float_avx2(table->values, dest, values, count);
+    }
+#endif
+
+    for (; i<count; i++) {
+        dest[i] = table->values[values[i]];
+    }
+}
+
+void nexrad_level_decode_int16(nexrad_level_table *table, int16_t *dest, const uint8_t *values, size_t count) {
+    size_t i = 0;
+
+    if (table == NULL || dest == NULL || values == NULL) {
+        return;
+    }
+
+#ifdef LEVEL_HAVE_AVX2
+    if (_have_avx2()) {
+        i = _decode_int16_avx2(table->scaled, dest, values, count);
+    }
+#endif
+
+    for (; i<count; i++) {
+        dest[i] = table->scaled[values[i]];
+    }
+}
+
+void nexrad_level_table_destroy(nexrad_level_table *table) {
+    free(table);
+}
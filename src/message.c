@@ -29,20 +29,89 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
 #include <bzlib.h>
 #include "util.h"
+#include "bzip2.h"
+#include "message_internal.h"
+#include "cache_internal.h"
+#include "radial_internal.h"
 
 #include <nexrad/message.h>
+#include <nexrad/radial.h>
 
-#define NEXRAD_MESSAGE_UNKNOWN_FOOTER "\x0d\x0d\x0a\x03"
+#define NEXRAD_MESSAGE_CTX_ALLOCS 4
+
+/*
+ * The number of slots in the table by which packet table of contents entries
+ * are found by type; there are far fewer packet types than this in practice.
+ */
+#define MESSAGE_PACKET_TYPE_SLOTS 32
+
+/*
+ * The amount of output produced by each step of the decompressor when
+ * streaming rays, after which the rays decompressed thus far are released to
+ * the consumer.
+ */
+#define MESSAGE_STREAM_STEP 16384
+
+struct _nexrad_message_ctx_alloc {
+    void * ptr;
+    size_t size;
+    int    used;
+};
+
+struct _nexrad_message_ctx_buf {
+    void * ptr;  /* Spare buffer, if not lent out */
+    size_t size; /* Size of spare buffer */
+};
+
+struct _nexrad_message_ctx {
+    bz_stream stream;
+    int       flags;
+    int       threads;
+
+    bzip2_pool * pool; /* Created upon first parallel decompression */
+
+    enum nexrad_message_io io;
+    size_t                 io_threshold;
+
+    nexrad_message_cache * cache;
+
+    struct _nexrad_message_ctx_buf data; /* Buffer for message files read */
+    struct _nexrad_message_ctx_buf body; /* Buffer for decompressed bodies */
+
+    /*
+     * libbzip2 allocates its decompressor state anew upon every call to
+     * BZ2_bzDecompressInit(), and frees it again in BZ2_bzDecompressEnd().
+     * These slots retain those allocations so that they may be handed back
+     * to the decompressor for the next message.
+     */
+    struct _nexrad_message_ctx_alloc allocs[NEXRAD_MESSAGE_CTX_ALLOCS];
+};
+
+struct _message_packet_type {
+    uint16_t type;
+    uint32_t count;
+    uint32_t first;
+};
 
 struct _nexrad_message {
     size_t size;
     size_t page_size;
     size_t mapped_size;
-    int    fd;
     void * data;
+    size_t data_size;
+    int    data_owned;
     void * body;
+    size_t body_size; /* Size of buffer holding decompressed body */
+    size_t body_len;  /* Number of bytes actually decompressed */
+    int    flags;
+    int    indexed; /* 1 if body indexed, -1 if indexing failed */
+    int    refs;    /* Number of references held to message */
+
+    nexrad_message_ctx *  ctx;
+    message_cache_entry * cache_entry; /* Cached body, if any */
 
     nexrad_unknown_header *      unknown_header;
     nexrad_wmo_header *          wmo_header;
@@ -53,6 +122,12 @@ struct _nexrad_message {
     nexrad_tabular_block *       tabular;
 
     enum nexrad_product_compression_type compression;
+
+    nexrad_packet_entry * packets;
+    size_t                packet_count;
+    int                   packets_indexed; /* 1 if indexed, -1 if failed */
+
+    struct _message_packet_type * packet_types; /* Allocated with packets */
 };
 
 static inline int _header_size() {
@@ -67,15 +142,28 @@ static inline off_t _halfword_body_offset(uint32_t value) {
     return (be32toh(value) * 2) - _header_size();
 }
 
+/*
+ * Determine the number of bytes of message body which may be safely read;
+ * a decompressed body is bounded by the amount of data actually decompressed,
+ * rather than by the size of the buffer holding it.
+ */
+static size_t _message_body_len(nexrad_message *message) {
+    if (message->compression != NEXRAD_PRODUCT_COMPRESSION_NONE) {
+        return message->body_len;
+    }
+
+    return (char *)message->data + message->size - (char *)message->body;
+}
+
 static void *_block_pointer(nexrad_message *message, uint32_t raw_offset, enum nexrad_block_id type) {
     uint32_t offset = _halfword_body_offset(raw_offset);
     nexrad_block_header *header;
 
     /*
-     * Prevent an opportunity for segmentation fault by limiting the message
-     * offset to exist within the physical size of the message.
+     * Prevent an opportunity for segmentation fault by limiting the block
+     * offset to exist within the body of the message.
      */
-    if (offset + _header_size() > message->size) {
+    if ((size_t)offset + sizeof(nexrad_block_header) > _message_body_len(message)) {
         return NULL;
     }
 
@@ -85,6 +173,10 @@ static void *_block_pointer(nexrad_message *message, uint32_t raw_offset, enum n
      */
     header = (nexrad_block_header *)((char *)message->body + offset);
 
+    if (message->flags & NEXRAD_MESSAGE_TRUSTED) {
+        return (void *)header;
+    }
+
     if ((int16_t)be16toh(header->divider) != -1 || be16toh(header->id) != type) {
         return NULL;
     }
@@ -104,6 +196,248 @@ static inline nexrad_tabular_block *_tabular_block(nexrad_message *message, nexr
     return (nexrad_tabular_block *)_block_pointer(message, description->tabular_offset, NEXRAD_BLOCK_TABULAR);
 }
 
+static void *_ctx_bzalloc(void *opaque, int items, int size) {
+    nexrad_message_ctx *ctx = opaque;
+    size_t len = (size_t)items * size;
+    int i;
+
+    for (i=0; i<NEXRAD_MESSAGE_CTX_ALLOCS; i++) {
+        struct _nexrad_message_ctx_alloc *alloc = &ctx->allocs[i];
+
+        if (alloc->ptr && !alloc->used && alloc->size == len) {
+            alloc->used = 1;
+
+            return alloc->ptr;
+        }
+    }
+
+    for (i=0; i<NEXRAD_MESSAGE_CTX_ALLOCS; i++) {
+        struct _nexrad_message_ctx_alloc *alloc = &ctx->allocs[i];
+
+        if (alloc->used) {
+            continue;
+        }
+
+        if (alloc->ptr) {
+            free(alloc->ptr);
+        }
+
+        if ((alloc->ptr = malloc(len)) == NULL) {
+            alloc->size = 0;
+
+            return NULL;
+        }
+
+        alloc->size = len;
+        alloc->used = 1;
+
+        return alloc->ptr;
+    }
+
+    return malloc(len);
+}
+
+static void _ctx_bzfree(void *opaque, void *ptr) {
+    nexrad_message_ctx *ctx = opaque;
+    int i;
+
+    for (i=0; i<NEXRAD_MESSAGE_CTX_ALLOCS; i++) {
+        if (ctx->allocs[i].ptr == ptr) {
+            ctx->allocs[i].used = 0;
+
+            return;
+        }
+    }
+
+    free(ptr);
+}
+
+/*
+ * Lend a spare buffer kept by a context, growing it beforehand if it is not
+ * large enough to hold `size` bytes.  The actual size of the buffer lent is
+ * written to `sizep`.
+ */
+static void *_ctx_buf_take(struct _nexrad_message_ctx_buf *buf, size_t size, size_t *sizep) {
+    void *ptr;
+
+    if (buf->ptr == NULL || buf->size < size) {
+        free(buf->ptr);
+
+        buf->ptr  = NULL;
+        buf->size = 0;
+
+        if ((ptr = malloc(size)) == NULL) {
+            return NULL;
+        }
+
+        *sizep = size;
+
+        return ptr;
+    }
+
+    ptr    = buf->ptr;
+    *sizep = buf->size;
+
+    buf->ptr  = NULL;
+    buf->size = 0;
+
+    return ptr;
+}
+
+/*
+ * Return a buffer to a context, keeping only the largest buffer seen for
+ * reuse.
+ */
+static void _ctx_buf_give(struct _nexrad_message_ctx_buf *buf, void *ptr, size_t size) {
+    if (buf->ptr && buf->size >= size) {
+        free(ptr);
+
+        return;
+    }
+
+    free(buf->ptr);
+
+    buf->ptr  = ptr;
+    buf->size = size;
+}
+
+/*
+ * Lend the context's spare decompression buffer to a message.  Without a
+ * context, a new buffer is simply allocated.
+ */
+void *message_ctx_body_take(nexrad_message_ctx *ctx, size_t size, size_t *sizep) {
+    void *body;
+
+    if (ctx == NULL) {
+        if ((body = malloc(size)) != NULL) {
+            *sizep = size;
+        }
+
+        return body;
+    }
+
+    return _ctx_buf_take(&ctx->body, size, sizep);
+}
+
+/*
+ * Return a decompression buffer to the context it was lent from.
+ */
+void message_ctx_body_give(nexrad_message_ctx *ctx, void *body, size_t size) {
+    if (ctx == NULL) {
+        free(body);
+
+        return;
+    }
+
+    _ctx_buf_give(&ctx->body, body, size);
+}
+
+/*
+ * Lend the context's spare file buffer to a message.  Without a context, a new
+ * buffer is simply allocated.
+ */
+void *message_ctx_data_take(nexrad_message_ctx *ctx, size_t size, size_t *sizep) {
+    void *data;
+
+    if (ctx == NULL) {
+        if ((data = malloc(size)) != NULL) {
+            *sizep = size;
+        }
+
+        return data;
+    }
+
+    return _ctx_buf_take(&ctx->data, size, sizep);
+}
+
+/*
+ * Return a file buffer to the context it was lent from.
+ */
+void message_ctx_data_give(nexrad_message_ctx *ctx, void *data, size_t size) {
+    if (ctx == NULL) {
+        free(data);
+
+        return;
+    }
+
+    _ctx_buf_give(&ctx->data, data, size);
+}
+
+/*
+ * Decompress `src` into `dest`, a buffer of `*destlenp` bytes, writing the
+ * number of bytes actually decompressed to `destlenp` upon success.
+ */
+static int _ctx_decompress(nexrad_message_ctx *ctx, void *dest, size_t *destlenp, void *src, size_t srclen) {
+    bz_stream *stream = &ctx->stream;
+    int ret;
+
+    /*
+     * Products compressed as multiple bzip2 blocks may be decompressed one
+     * block per thread, falling back to serial decompression if the block
+     * boundaries cannot be found.
+     */
+    if (ctx->threads > 1) {
+        if (ctx->pool == NULL) {
+            ctx->pool = bzip2_pool_create(ctx->threads);
+        }
+
+        if (ctx->pool && bzip2_pool_decompress(ctx->pool, dest, destlenp, src, srclen) == 0) {
+            return 0;
+        }
+    }
+
+    stream->bzalloc = _ctx_bzalloc;
+    stream->bzfree  = _ctx_bzfree;
+    stream->opaque  = ctx;
+
+    if (BZ2_bzDecompressInit(stream, 0, 0) != BZ_OK) {
+        goto error_decompress_init;
+    }
+
+    stream->next_in   = src;
+    stream->avail_in  = srclen;
+    stream->next_out  = dest;
+    stream->avail_out = *destlenp;
+
+    /*
+     * Keep decompressing until the end of the bzip2 stream is reached, or
+     * until the decompressor stops making progress, indicating either a
+     * truncated stream or an undersized destination buffer.
+     */
+    for (;;) {
+        unsigned int avail_in  = stream->avail_in,
+                     avail_out = stream->avail_out;
+
+        if ((ret = BZ2_bzDecompress(stream)) != BZ_OK) {
+            break;
+        }
+
+        if (stream->avail_in == avail_in && stream->avail_out == avail_out) {
+            goto error_decompress;
+        }
+    }
+
+    if (ret != BZ_STREAM_END) {
+        goto error_decompress;
+    }
+
+    *destlenp = stream->total_out_lo32;
+
+    BZ2_bzDecompressEnd(stream);
+
+    return 0;
+
+error_decompress:
+    BZ2_bzDecompressEnd(stream);
+
+error_decompress_init:
+    return -1;
+}
+
+static void _message_body_release(nexrad_message *message, void *body) {
+    message_ctx_body_give(message->ctx, body, message->body_size);
+}
+
 static size_t _message_get_body_size(nexrad_message *message) {
     size_t ret = message->size;
 
@@ -119,6 +453,45 @@ static size_t _message_get_body_size(nexrad_message *message) {
     return ret;
 }
 
+/*
+ * Obtain a decompressed body from the cache attached to the message's decoding
+ * context, decompressing it and adding it to the cache upon a miss.
+ */
+static void *_message_get_body_cached(nexrad_message *message, void *src, size_t srclen, size_t destlen) {
+    message_cache_entry *entry;
+    void *body;
+    int hit;
+
+    if ((entry = message_cache_acquire(message->ctx->cache, src, srclen, destlen, &hit)) == NULL) {
+        goto error_cache_acquire;
+    }
+
+    if (!hit) {
+        if ((body = malloc(destlen)) == NULL) {
+            goto error_malloc;
+        }
+
+        if (_ctx_decompress(message->ctx, body, &destlen, src, srclen) < 0) {
+            goto error_decompress;
+        }
+
+        message_cache_fill(entry, body, destlen);
+    }
+
+    message->cache_entry = entry;
+
+    return message_cache_entry_body(entry, &message->body_len);
+
+error_decompress:
+    free(body);
+
+error_malloc:
+    message_cache_abandon(entry);
+
+error_cache_acquire:
+    return NULL;
+}
+
 static void *_message_get_body(nexrad_message *message, nexrad_product_description *description, enum nexrad_product_compression_type *compp) {
     enum nexrad_product_compression_type compression;
     void *dest;
@@ -148,18 +521,39 @@ static void *_message_get_body(nexrad_message *message, nexrad_product_descripti
 
         case NEXRAD_PRODUCT_COMPRESSION_BZIP2: {
             unsigned int destlen = be32toh(description->attributes.compression.size);
-            size_t bodylen = _message_get_body_size(message);
+            size_t bodylen = _message_get_body_size(message),
+                   outlen  = destlen;
 
             if (destlen > NEXRAD_MESSAGE_MAX_BODY_SIZE) {
                 goto error_decompress_size;
             }
 
-            if ((dest = malloc(destlen)) == NULL) {
-                goto error_decompress_malloc;
-            }
+            if (message->ctx && message->ctx->cache) {
+                if ((dest = _message_get_body_cached(message, body, bodylen, destlen)) == NULL) {
+                    goto error_decompress_cached;
+                }
+            } else if (message->ctx) {
+                if ((dest = message_ctx_body_take(message->ctx, destlen, &message->body_size)) == NULL) {
+                    goto error_decompress_malloc;
+                }
 
-            if (BZ2_bzBuffToBuffDecompress(dest, &destlen, body, bodylen, 0, 0) < 0) {
-                goto error_decompress;
+                if (_ctx_decompress(message->ctx, dest, &outlen, body, bodylen) < 0) {
+                    goto error_decompress;
+                }
+
+                message->body_len = outlen;
+            } else {
+                if ((dest = malloc(destlen)) == NULL) {
+                    goto error_decompress_malloc;
+                }
+
+                message->body_size = destlen;
+
+                if (BZ2_bzBuffToBuffDecompress(dest, &destlen, body, bodylen, 0, 0) < 0) {
+                    goto error_decompress;
+                }
+
+                message->body_len = destlen;
             }
 
             body = dest;
@@ -181,21 +575,20 @@ static void *_message_get_body(nexrad_message *message, nexrad_product_descripti
     return body;
 
 error_decompress:
-    free(dest);
+    _message_body_release(message, dest);
 
 error_decompress_malloc:
+error_decompress_cached:
 error_decompress_size:
     return NULL;
 }
 
 /*
- * Perform an initial parse of the NEXRAD Radar Product Generator Message and
- * produce a high-level table-of-contents indicating the locations of the five
- * blocks within the message.
+ * Decompress the body of the NEXRAD Radar Product Generator Message, if need
+ * be, and locate the product symbology, graphic and tabular blocks therein.
  */
-static int _message_index(nexrad_message *message) {
-    nexrad_message_header *      message_header;
-    nexrad_product_description * description;
+static int _message_index_body(nexrad_message *message) {
+    nexrad_product_description *description = message->description;
 
     enum nexrad_product_compression_type compression = NEXRAD_PRODUCT_COMPRESSION_NONE;
 
@@ -203,13 +596,75 @@ static int _message_index(nexrad_message *message) {
     nexrad_graphic_block *   graphic   = NULL;
     nexrad_tabular_block *   tabular   = NULL;
 
+    if (message->indexed) {
+        return message->indexed < 0? -1: 0;
+    }
+
+    /*
+     * The body may have been decompressed already by the caller which opened
+     * the message, as is the case with nexrad_message_feed.
+     */
+    if (message->body == NULL) {
+        if ((message->body = _message_get_body(message, description, &compression)) == NULL) {
+            goto error_message_get_body;
+        }
+
+        message->compression = compression;
+    }
+
+    if (description->symbology_offset != 0 && (symbology = _symbology_block(message, description)) == NULL) {
+        goto error_invalid_symbology_block_offset;
+    }
+
+    if (description->graphic_offset != 0 && (graphic = _graphic_block(message, description)) == NULL) {
+        goto error_invalid_graphic_block_offset;
+    }
+
+    if (description->tabular_offset != 0 && (tabular = _tabular_block(message, description)) == NULL) {
+        goto error_invalid_tabular_block_offset;
+    }
+
+    message->symbology = symbology;
+    message->graphic   = graphic;
+    message->tabular   = tabular;
+    message->indexed   = 1;
+
+    return 0;
+
+error_invalid_tabular_block_offset:
+error_invalid_graphic_block_offset:
+error_invalid_symbology_block_offset:
+error_message_get_body:
+    message->indexed = -1;
+
+    errno = EINVAL;
+
+    return -1;
+}
+
+/*
+ * Perform an initial parse of the NEXRAD Radar Product Generator Message and
+ * produce a high-level table-of-contents indicating the locations of the five
+ * blocks within the message.  When the message is opened with the flag
+ * NEXRAD_MESSAGE_LAZY, only the headers and product description are
+ * validated, and the remainder of this work is deferred until any of the
+ * symbology, graphic or tabular blocks are first requested.
+ */
+static int _message_index_headers(nexrad_message *message) {
+    nexrad_message_header *      message_header;
+    nexrad_product_description * description;
+
     size_t message_offset        = 0;
     size_t message_size_expected = message->size;
 
     message->unknown_header = NULL;
     message->wmo_header     = NULL;
-    message->body           = NULL;
-    message->compression    = NEXRAD_PRODUCT_COMPRESSION_NONE;
+    message->message_header = NULL;
+    message->description    = NULL;
+    message->symbology      = NULL;
+    message->graphic        = NULL;
+    message->tabular        = NULL;
+    message->indexed        = 0;
 
     if (memcmp((char *)message->data + message_offset, NEXRAD_HEADER_UNKNOWN_SIGNATURE, 4) == 0) {
         message->unknown_header = (nexrad_unknown_header *)((char *)message->data + message_offset);
@@ -255,35 +710,11 @@ static int _message_index(nexrad_message *message) {
         goto error_invalid_product_description;
     }
 
-    if ((message->body = _message_get_body(message, description, &compression)) == NULL) {
-        goto error_message_get_body;
-    }
-
-    if (description->symbology_offset != 0 && (symbology = _symbology_block(message, description)) == NULL) {
-        goto error_invalid_symbology_block_offset;
-    }
-
-    if (description->graphic_offset != 0 && (graphic = _graphic_block(message, description)) == NULL) {
-        goto error_invalid_graphic_block_offset;
-    }
-
-    if (description->tabular_offset != 0 && (tabular = _tabular_block(message, description)) == NULL) {
-        goto error_invalid_tabular_block_offset;
-    }
-
     message->message_header = message_header;
     message->description    = description;
-    message->compression    = compression;
-    message->symbology      = symbology;
-    message->graphic        = graphic;
-    message->tabular        = tabular;
 
     return 0;
 
-error_invalid_tabular_block_offset:
-error_invalid_graphic_block_offset:
-error_invalid_symbology_block_offset:
-error_message_get_body:
 error_invalid_product_description:
 error_invalid_message_header:
     errno = EINVAL;
@@ -291,338 +722,1729 @@ error_invalid_message_header:
     return -1;
 }
 
-nexrad_message *nexrad_message_open_buf(void *buf, size_t len) {
-    nexrad_message *message;
+/*
+ * Locate the headers and product description of a message opened with
+ * NEXRAD_MESSAGE_TRUSTED, checking only for the presence of the optional
+ * unknown header, and the bare minimum of size needed to hold the rest.
+ */
+static int _message_index_headers_trusted(nexrad_message *message) {
+    size_t offset = 0;
 
-    if ((message = malloc(sizeof(nexrad_message))) == NULL) {
-        goto error_malloc;
-    }
+    message->unknown_header = NULL;
+    message->symbology      = NULL;
+    message->graphic        = NULL;
+    message->tabular        = NULL;
+    message->indexed        = 0;
+
+    if (memcmp(message->data, NEXRAD_HEADER_UNKNOWN_SIGNATURE, 4) == 0) {
+        message->unknown_header = (nexrad_unknown_header *)message->data;
+
+        offset += sizeof(nexrad_unknown_header);
+    }
+
+    if (offset + MESSAGE_MIN_SIZE > message->size) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    message->wmo_header     = (nexrad_wmo_header *)((char *)message->data + offset);
+    message->message_header = (nexrad_message_header *)(message->wmo_header + 1);
+    message->description    = (nexrad_product_description *)(message->message_header + 1);
+
+    return 0;
+}
+
+static int _message_index_packets(nexrad_message *message);
+
+static int _message_index(nexrad_message *message) {
+    if (message->flags & NEXRAD_MESSAGE_TRUSTED) {
+        if (_message_index_headers_trusted(message) < 0) {
+            return -1;
+        }
+    } else if (_message_index_headers(message) < 0) {
+        return -1;
+    }
+
+    if (message->flags & NEXRAD_MESSAGE_LAZY) {
+        return 0;
+    }
+
+    return _message_index_body(message);
+}
+
+nexrad_message_ctx *nexrad_message_ctx_create() {
+    nexrad_message_ctx *ctx;
+
+    if ((ctx = calloc(1, sizeof(*ctx))) == NULL) {
+        goto error_calloc;
+    }
+
+    ctx->io           = NEXRAD_MESSAGE_IO_AUTO;
+    ctx->io_threshold = NEXRAD_MESSAGE_IO_THRESHOLD;
+
+    return ctx;
+
+error_calloc:
+    return NULL;
+}
+
+void nexrad_message_ctx_destroy(nexrad_message_ctx *ctx) {
+    int i;
+
+    if (ctx == NULL) {
+        return;
+    }
+
+    for (i=0; i<NEXRAD_MESSAGE_CTX_ALLOCS; i++) {
+        free(ctx->allocs[i].ptr);
+    }
+
+    free(ctx->data.ptr);
+    free(ctx->body.ptr);
+
+    bzip2_pool_destroy(ctx->pool);
+
+    memset(ctx, '\0', sizeof(*ctx));
+
+    free(ctx);
+}
+
+void nexrad_message_ctx_set_flags(nexrad_message_ctx *ctx, int flags) {
+    if (ctx == NULL) {
+        return;
+    }
+
+    ctx->flags = flags;
+}
+
+int nexrad_message_ctx_get_flags(nexrad_message_ctx *ctx) {
+    if (ctx == NULL) {
+        return -1;
+    }
+
+    return ctx->flags;
+}
+
+int nexrad_message_ctx_set_threads(nexrad_message_ctx *ctx, int threads) {
+    if (ctx == NULL || threads < 1) {
+        return -1;
+    }
+
+    if (ctx->threads != threads) {
+        bzip2_pool_destroy(ctx->pool);
+
+        ctx->pool = NULL;
+    }
+
+    ctx->threads = threads;
+
+    return 0;
+}
+
+int nexrad_message_ctx_set_cache(nexrad_message_ctx *ctx, nexrad_message_cache *cache) {
+    if (ctx == NULL) {
+        return -1;
+    }
+
+    ctx->cache = cache;
+
+    return 0;
+}
+
+int nexrad_message_ctx_set_io(nexrad_message_ctx *ctx, enum nexrad_message_io io, size_t threshold) {
+    if (ctx == NULL) {
+        return -1;
+    }
+
+    switch (io) {
+        case NEXRAD_MESSAGE_IO_AUTO:
+        case NEXRAD_MESSAGE_IO_READ:
+        case NEXRAD_MESSAGE_IO_MMAP: {
+            break;
+        }
+
+        default: {
+            errno = EINVAL;
+
+            return -1;
+        }
+    }
+
+    ctx->io           = io;
+    ctx->io_threshold = threshold;
+
+    return 0;
+}
+
+static nexrad_message *_message_create(void *data, size_t size, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+
+    if ((message = malloc(sizeof(nexrad_message))) == NULL) {
+        goto error_malloc;
+    }
+
+    message->size        = size;
+    message->page_size   = 0;
+    message->mapped_size = 0;
+    message->data        = data;
+    message->data_size   = size;
+    message->data_owned  = 0;
+    message->body        = NULL;
+    message->body_size   = 0;
+    message->body_len    = 0;
+    message->cache_entry = NULL;
+    message->flags       = ctx? ctx->flags: 0;
+    message->indexed     = 0;
+    message->refs        = 1;
+    message->ctx         = ctx;
+    message->compression = NEXRAD_PRODUCT_COMPRESSION_NONE;
+
+    message->packets         = NULL;
+    message->packet_count    = 0;
+    message->packets_indexed = 0;
+    message->packet_types    = NULL;
+
+    return message;
+
+error_malloc:
+    return NULL;
+}
+
+nexrad_message *nexrad_message_open_buf_ctx(void *buf, size_t len, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+
+    if ((message = _message_create(buf, len, ctx)) == NULL) {
+        goto error_message_create;
+    }
+
+    if (_message_index(message) < 0) {
+        goto error_message_index;
+    }
+
+    return message;
+
+error_message_index:
+    nexrad_message_destroy(message);
+
+error_message_create:
+    return NULL;
+}
+
+nexrad_message *message_open_decoded(void *data, size_t size, void *body, size_t body_size, size_t body_len, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+
+    if ((message = _message_create(data, size, ctx)) == NULL) {
+        goto error_message_create;
+    }
+
+    if (_message_index_headers(message) < 0) {
+        goto error_message_index;
+    }
+
+    /*
+     * Only take ownership of the message data and body once the message is
+     * known to be valid, so that the caller may dispose of them otherwise.
+     */
+    message->data_owned = 1;
+
+    if (body) {
+        message->body        = body;
+        message->body_size   = body_size;
+        message->body_len    = body_len;
+        message->compression = NEXRAD_PRODUCT_COMPRESSION_BZIP2;
+    }
+
+    if (!(message->flags & NEXRAD_MESSAGE_LAZY)) {
+        if (_message_index_body(message) < 0) {
+            goto error_message_index_body;
+        }
+    }
+
+    return message;
+
+error_message_index_body:
+    message->data_owned  = 0;
+    message->body        = NULL;
+    message->compression = NEXRAD_PRODUCT_COMPRESSION_NONE;
+
+    nexrad_message_destroy(message);
+
+    return NULL;
+
+error_message_index:
+    nexrad_message_destroy(message);
+
+error_message_create:
+    return NULL;
+}
+
+nexrad_message *nexrad_message_open_buf(void *buf, size_t len) {
+    return nexrad_message_open_buf_ctx(buf, len, NULL);
+}
+
+nexrad_message *nexrad_message_adopt_buf_ctx(void *buf, size_t len, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+
+    if ((message = nexrad_message_open_buf_ctx(buf, len, ctx)) == NULL) {
+        return NULL;
+    }
+
+    message->data_owned = 1;
+
+    return message;
+}
+
+nexrad_message *nexrad_message_adopt_buf(void *buf, size_t len) {
+    return nexrad_message_adopt_buf_ctx(buf, len, NULL);
+}
+
+static int _message_read(nexrad_message *message, int fd) {
+    size_t offset = 0;
+
+    /*
+     * Mapped files are followed by zeroes up to the end of the final page;
+     * provide some zeroed slack after the data read likewise, as parsers of
+     * text in the tabular block are known to read slightly beyond its end.
+     */
+    if ((message->data = message_ctx_data_take(message->ctx, message->size + MESSAGE_READ_SLACK, &message->data_size)) == NULL) {
+        goto error_data_take;
+    }
+
+    message->data_owned = 1;
+
+    memset((char *)message->data + message->size, '\0', MESSAGE_READ_SLACK);
+
+    while (offset < message->size) {
+        ssize_t len;
+
+        if ((len = pread(fd, (char *)message->data + offset, message->size - offset, offset)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            goto error_pread;
+        } else if (len == 0) {
+            errno = EINVAL;
+
+            goto error_pread;
+        }
+
+        offset += len;
+    }
+
+    return 0;
+
+error_pread:
+error_data_take:
+    return -1;
+}
+
+static int _message_map(nexrad_message *message, int fd) {
+    int flags = MAP_PRIVATE;
+
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+
+    message->page_size   = (size_t)sysconf(_SC_PAGESIZE);
+    message->mapped_size = _mapped_size(message->size, message->page_size);
+
+    if ((message->data = mmap(NULL, message->mapped_size, PROT_READ, flags, fd, 0)) == MAP_FAILED) {
+        message->data        = NULL;
+        message->mapped_size = 0;
+
+        return -1;
+    }
+
+    madvise(message->data, message->mapped_size, MADV_SEQUENTIAL);
+
+    return 0;
+}
+
+nexrad_message *nexrad_message_open_fd_ctx(int fd, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+    enum nexrad_message_io io = ctx? ctx->io: NEXRAD_MESSAGE_IO_AUTO;
+    size_t threshold = ctx? ctx->io_threshold: NEXRAD_MESSAGE_IO_THRESHOLD;
+    struct stat st;
+
+    if ((message = _message_create(NULL, 0, ctx)) == NULL) {
+        goto error_message_create;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        goto error_stat;
+    }
+
+    if (st.st_size > NEXRAD_MESSAGE_MAX_SIZE) {
+        errno = EFBIG;
+
+        goto error_efbig;
+    }
+
+    if (st.st_size < MESSAGE_MIN_SIZE) {
+        errno = EINVAL;
+
+        goto error_einval;
+    }
+
+    message->size = st.st_size;
+
+    /*
+     * Small files are cheaper to read into a buffer, which a context can
+     * retain for subsequent messages, than to map; setting up and tearing
+     * down a mapping, and faulting in its pages, costs more than copying a
+     * few dozen kilobytes.
+     */
+    if (io == NEXRAD_MESSAGE_IO_AUTO) {
+        io = message->size <= threshold? NEXRAD_MESSAGE_IO_READ: NEXRAD_MESSAGE_IO_MMAP;
+    }
+
+    if (io == NEXRAD_MESSAGE_IO_READ) {
+        if (_message_read(message, fd) < 0) {
+            goto error_load;
+        }
+    } else {
+        if (_message_map(message, fd) < 0) {
+            goto error_load;
+        }
+    }
+
+    if (_message_index(message) < 0) {
+        goto error_message_index;
+    }
+
+    return message;
+
+error_message_index:
+error_load:
+    nexrad_message_destroy(message);
+
+    return NULL;
+
+error_einval:
+error_efbig:
+error_stat:
+    free(message);
+
+error_message_create:
+    return NULL;
+}
+
+nexrad_message *nexrad_message_open_fd(int fd) {
+    return nexrad_message_open_fd_ctx(fd, NULL);
+}
+
+nexrad_message *nexrad_message_openat_ctx(int dirfd, const char *path, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+    int fd, err;
+
+    if ((fd = openat(dirfd, path, O_RDONLY)) < 0) {
+        return NULL;
+    }
+
+    message = nexrad_message_open_fd_ctx(fd, ctx);
+    err     = errno;
+
+    close(fd);
+
+    errno = err;
+
+    return message;
+}
+
+nexrad_message *nexrad_message_open_ctx(const char *path, nexrad_message_ctx *ctx) {
+    return nexrad_message_openat_ctx(AT_FDCWD, path, ctx);
+}
+
+nexrad_message *nexrad_message_open(const char *path) {
+    return nexrad_message_open_ctx(path, NULL);
+}
+
+size_t message_header_offset(const void *buf, size_t len) {
+    size_t offset = sizeof(nexrad_wmo_header);
+
+    if (len >= sizeof(nexrad_unknown_header)
+      && memcmp(buf, NEXRAD_HEADER_UNKNOWN_SIGNATURE, 4) == 0) {
+        offset += sizeof(nexrad_unknown_header);
+    }
+
+    return offset;
+}
+
+int nexrad_message_peek_buf(const void *buf, size_t len, nexrad_message_info *info) {
+    const char *data = buf;
+    nexrad_wmo_header *wmo_header;
+    nexrad_message_header *message_header;
+    nexrad_product_description *description;
+    size_t offset = 0;
+
+    if (buf == NULL || info == NULL) {
+        goto error_invalid;
+    }
+
+    if (len >= sizeof(nexrad_unknown_header)
+      && memcmp(data, NEXRAD_HEADER_UNKNOWN_SIGNATURE, 4) == 0) {
+        offset += sizeof(nexrad_unknown_header);
+    }
+
+    if (len < offset + sizeof(nexrad_wmo_header) + _header_size()) {
+        goto error_invalid;
+    }
+
+    if (memcmp(data + offset, NEXRAD_HEADER_WMO_SIGNATURE, 4) != 0) {
+        goto error_invalid;
+    }
+
+    wmo_header     = (nexrad_wmo_header *)(data + offset);
+    message_header = (nexrad_message_header *)(data + offset + sizeof(nexrad_wmo_header));
+    description    = (nexrad_product_description *)nexrad_block_after(message_header, nexrad_message_header);
+
+    if (wmo_header->_whitespace1 != ' ' || be16toh(message_header->blocks) > 5) {
+        goto error_invalid;
+    }
+
+    if ((int16_t)be16toh(description->divider) != -1) {
+        goto error_invalid;
+    }
+
+    info->station[0] = wmo_header->office[0];
+    memcpy(info->station + 1, wmo_header->station, 3);
+    info->station[4] = '\0';
+
+    memcpy(info->product_code, wmo_header->product_code, 3);
+    info->product_code[3] = '\0';
+
+    info->type           = be16toh(message_header->product_type);
+    info->mode           = be16toh(description->mode);
+    info->vcp            = be16toh(description->vcp);
+    info->seq            = be16toh(description->seq);
+    info->scan           = be16toh(description->scan);
+    info->scan_timestamp = nexrad_date_timestamp(&description->scan_date);
+    info->gen_timestamp  = nexrad_date_timestamp(&description->gen_date);
+    info->size           = be32toh(message_header->size);
+
+    return 0;
+
+error_invalid:
+    errno = EINVAL;
+
+    return -1;
+}
+
+int nexrad_message_peek_fd(int fd, nexrad_message_info *info) {
+    char buf[NEXRAD_MESSAGE_PEEK_SIZE];
+    ssize_t len;
+
+    while ((len = pread(fd, buf, sizeof(buf), 0)) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+
+    return nexrad_message_peek_buf(buf, len, info);
+}
+
+int nexrad_message_peekat(int dirfd, const char *path, nexrad_message_info *info) {
+    int fd, ret, err;
+
+    if ((fd = openat(dirfd, path, O_RDONLY)) < 0) {
+        return -1;
+    }
+
+    ret = nexrad_message_peek_fd(fd, info);
+    err = errno;
+
+    close(fd);
+
+    errno = err;
+
+    return ret;
+}
+
+int nexrad_message_peek(const char *path, nexrad_message_info *info) {
+    return nexrad_message_peekat(AT_FDCWD, path, info);
+}
+
+static int _write_full(int fd, const void *buf, size_t len) {
+    while (len > 0) {
+        ssize_t written;
+
+        if ((written = write(fd, buf, len)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -1;
+        }
+
+        buf  = (const char *)buf + written;
+        len -= written;
+    }
+
+    return 0;
+}
+
+ssize_t message_write_decoded(nexrad_message *message, int fd) {
+    nexrad_message_header header;
+    nexrad_product_description description;
+    size_t body_size, total = 0;
+    int footer;
+
+    if (_message_index_body(message) < 0) {
+        return -1;
+    }
+
+    if (message->compression == NEXRAD_PRODUCT_COMPRESSION_NONE) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    body_size = message->body_len;
+    footer    = memcmp((char *)message->data + message->size - 4, NEXRAD_MESSAGE_UNKNOWN_FOOTER, 4) == 0;
+
+    memcpy(&header,      message->message_header, sizeof(header));
+    memcpy(&description, message->description,    sizeof(description));
+
+    header.size = htobe32(sizeof(header) + sizeof(description) + body_size);
+
+    description.attributes.compression.method = htobe16(NEXRAD_PRODUCT_COMPRESSION_NONE);
+
+    if (message->unknown_header) {
+        if (_write_full(fd, message->unknown_header, sizeof(nexrad_unknown_header)) < 0) {
+            return -1;
+        }
+
+        total += sizeof(nexrad_unknown_header);
+    }
+
+    if (_write_full(fd, message->wmo_header, sizeof(nexrad_wmo_header)) < 0
+      || _write_full(fd, &header, sizeof(header)) < 0
+      || _write_full(fd, &description, sizeof(description)) < 0
+      || _write_full(fd, message->body, body_size) < 0) {
+        return -1;
+    }
+
+    total += sizeof(nexrad_wmo_header) + sizeof(header) + sizeof(description) + body_size;
+
+    if (footer) {
+        if (_write_full(fd, NEXRAD_MESSAGE_UNKNOWN_FOOTER, 4) < 0) {
+            return -1;
+        }
+
+        total += 4;
+    }
+
+    return total;
+}
+
+static void _message_free(nexrad_message *message) {
+    if (message->data && message->mapped_size > 0) {
+        munmap(message->data, message->mapped_size);
+
+        message->data        = NULL;
+        message->mapped_size = 0;
+    }
+
+    if (message->data && message->data_owned) {
+        message_ctx_data_give(message->ctx, message->data, message->data_size);
+
+        message->data       = NULL;
+        message->data_size  = 0;
+        message->data_owned = 0;
+    }
+
+    if (message->cache_entry) {
+        message_cache_release(message->cache_entry);
+
+        message->cache_entry = NULL;
+        message->compression = NEXRAD_PRODUCT_COMPRESSION_NONE;
+    } else if (message->body && message->compression != NEXRAD_PRODUCT_COMPRESSION_NONE) {
+        message->compression = NEXRAD_PRODUCT_COMPRESSION_NONE;
+        _message_body_release(message, message->body);
+    }
+
+    free(message->packets);
+    free(message->packet_types);
+
+    message->packets        = NULL;
+    message->packet_types   = NULL;
+    message->packet_count   = 0;
+    message->size           = 0;
+    message->page_size      = 0;
+    message->body           = NULL;
+    message->body_size      = 0;
+    message->body_len       = 0;
+    message->ctx            = NULL;
+    message->unknown_header = NULL;
+    message->wmo_header     = NULL;
+    message->message_header = NULL;
+    message->description    = NULL;
+    message->symbology      = NULL;
+    message->graphic        = NULL;
+    message->tabular        = NULL;
+
+    free(message);
+}
+
+nexrad_message *nexrad_message_ref(nexrad_message *message) {
+    if (message == NULL) {
+        return NULL;
+    }
+
+    /*
+     * While the caller holds the sole reference, no other thread can be using
+     * the message, so finish any indexing deferred until first use, including
+     * that deferred by NEXRAD_MESSAGE_LAZY, and detach the message from its
+     * decoding context, which is not safe to use from other threads.  Once
+     * shared, the message is never modified until it is freed, and buffers
+     * lent by the context are freed rather than returned to it.  A message
+     * which cannot be indexed in full is not shared at all.
+     */
+    if (__atomic_load_n(&message->refs, __ATOMIC_ACQUIRE) == 1) {
+        if (_message_index_packets(message) < 0) {
+            return NULL;
+        }
+
+        message->ctx = NULL;
+    }
+
+    __sync_fetch_and_add(&message->refs, 1);
+
+    return message;
+}
+
+void nexrad_message_unref(nexrad_message *message) {
+    if (message == NULL) {
+        return;
+    }
+
+    if (__sync_sub_and_fetch(&message->refs, 1) == 0) {
+        _message_free(message);
+    }
+}
+
+void nexrad_message_destroy(nexrad_message *message) {
+    nexrad_message_unref(message);
+}
+
+void nexrad_message_close(nexrad_message *message) {
+    nexrad_message_destroy(message);
+}
+
+nexrad_chunk *nexrad_message_open_symbology_block(nexrad_message *message) {
+    return nexrad_symbology_block_open(nexrad_message_get_symbology_block(message));
+}
+
+nexrad_chunk *nexrad_message_open_graphic_block(nexrad_message *message) {
+    return nexrad_graphic_block_open(nexrad_message_get_graphic_block(message));
+}
+
+nexrad_tabular_text *nexrad_message_open_tabular_block(nexrad_message *message) {
+    return nexrad_tabular_block_open(nexrad_message_get_tabular_block(message));
+}
+
+nexrad_message_header *nexrad_message_get_header(nexrad_message *message) {
+    if (message == NULL) {
+        return NULL;
+    }
+
+    return message->message_header;
+}
+
+nexrad_product_description *nexrad_message_get_product_description(nexrad_message *message) {
+    if (message == NULL) {
+        return NULL;
+    }
+
+    return message->description;
+}
+
+nexrad_symbology_block *nexrad_message_get_symbology_block(nexrad_message *message) {
+    if (message == NULL) {
+        return NULL;
+    }
+
+    if (_message_index_body(message) < 0) {
+        return NULL;
+    }
+
+    return message->symbology;
+}
+
+nexrad_graphic_block *nexrad_message_get_graphic_block(nexrad_message *message) {
+    if (message == NULL) {
+        return NULL;
+    }
+
+    if (_message_index_body(message) < 0) {
+        return NULL;
+    }
+
+    return message->graphic;
+}
+
+nexrad_tabular_block *nexrad_message_get_tabular_block(nexrad_message *message) {
+    if (message == NULL) {
+        return NULL;
+    }
+
+    if (_message_index_body(message) < 0) {
+        return NULL;
+    }
+
+    return message->tabular;
+}
+
+time_t nexrad_message_get_scan_timestamp(nexrad_message *message) {
+    if (message == NULL) {
+        return -1;
+    }
+
+    return nexrad_date_timestamp(&message->description->scan_date);
+}
+
+time_t nexrad_message_get_gen_timestamp(nexrad_message *message) {
+    if (message == NULL) {
+        return -1;
+    }
+
+    return nexrad_date_timestamp(&message->description->gen_date);
+}
+
+int nexrad_message_get_product_type(nexrad_message *message) {
+    if (message == NULL) {
+        return -1;
+    }
+
+    return be16toh(message->message_header->product_type);
+}
+
+int nexrad_message_find_product_code(nexrad_message *message, char **code, size_t *len) {
+    if (message == NULL) return -1;
+
+    if (code && len) {
+        *code = message->wmo_header->product_code;
+        *len  = sizeof(message->wmo_header->product_code);
+    }
+
+    return 0;
+}
+
+int nexrad_message_find_region(nexrad_message *message, char **region, size_t *len) {
+    if (message == NULL) return -1;
+
+    if (region && len) {
+        *region = message->wmo_header->region;
+        *len    = sizeof(message->wmo_header->region);
+    }
+
+    return 0;
+}
+
+int nexrad_message_find_office(nexrad_message *message, char **office, size_t *len) {
+    if (message == NULL) return -1;
+
+    if (office && len) {
+        *office = message->wmo_header->office;
+        *len    = sizeof(message->wmo_header->office);
+    }
+
+    return 0;
+}
+
+char nexrad_message_get_station_prefix(nexrad_message *message) {
+    if (message == NULL) {
+        return '\0';
+    }
+
+    return message->wmo_header->office[0];
+}
+
+int nexrad_message_find_station_suffix(nexrad_message *message, char **suffix, size_t *len) {
+    if (message == NULL) {
+        return -1;
+    }
+
+    if (suffix && len) {
+        *suffix = message->wmo_header->station;
+        *len    = sizeof(message->wmo_header->station);
+    }
+
+    return 0;
+}
+
+int nexrad_message_read_station(nexrad_message *message, char *dest, size_t destlen) {
+    char station[5];
+
+    if (message == NULL) {
+        return -1;
+    }
+
+    station[0] = message->wmo_header->office[0];
+    memcpy(station + 1, message->wmo_header->station, 3);
+    station[4] = '\0';
+
+    return safecpy(
+        dest,    station,
+        destlen, sizeof(station) - 1
+    );
+}
+
+int nexrad_message_read_station_location(nexrad_message *message, double *lat, double *lon, double *alt) {
+    if (message == NULL || lat == NULL || lon == NULL) {
+        return -1;
+    }
+
+    *lat = NEXRAD_PRODUCT_COORD_MAGNITUDE * (int32_t)be32toh(message->description->station_lat);
+    *lon = NEXRAD_PRODUCT_COORD_MAGNITUDE * (int32_t)be32toh(message->description->station_lon);
+
+    if (alt)
+        *alt = NEXRAD_PRODUCT_ALT_FACTOR * (int16_t)be16toh(message->description->station_altitude);
+
+    return 0;
+}
+
+static inline size_t _packet_type_slot(uint16_t type) {
+    return ((uint32_t)type * 2654435761U) >> 27;
+}
+
+static int _packets_add(nexrad_message *message, size_t *sizep, uint8_t block, uint16_t layer, nexrad_packet *packet, size_t size) {
+    nexrad_packet_entry *entry;
+
+    if (message->packet_count == *sizep) {
+        nexrad_packet_entry *tmp;
+        size_t count = *sizep? *sizep * 2: 16;
+
+        if ((tmp = realloc(message->packets, count * sizeof(*tmp))) == NULL) {
+            return -1;
+        }
+
+        message->packets = tmp;
+        *sizep           = count;
+    }
+
+    entry = &message->packets[message->packet_count++];
+
+    entry->offset = (char *)packet - (char *)message->body;
+    entry->size   = size;
+    entry->next   = NEXRAD_PACKET_ENTRY_NONE;
+    entry->type   = nexrad_packet_get_type(packet);
+    entry->layer  = layer;
+    entry->block  = block;
+
+    return 0;
+}
+
+/*
+ * Add every packet within a symbology layer or graphic page to the table of
+ * contents, stopping at the first packet which does not fit.
+ */
+static int _packets_index_layer(nexrad_message *message, size_t *sizep, uint8_t block, uint16_t layer, char *data, size_t len) {
+    size_t offset = 0;
+
+    while (offset < len) {
+        nexrad_packet *packet = (nexrad_packet *)(data + offset);
+        ssize_t size;
+
+        if ((size = nexrad_packet_find_size(packet, len - offset)) < 0) {
+            break;
+        }
+
+        if (_packets_add(message, sizep, block, layer, packet, size) < 0) {
+            return -1;
+        }
+
+        offset += size;
+    }
+
+    return 0;
+}
+
+static size_t _block_len(nexrad_message *message, nexrad_block_header *header) {
+    size_t len    = be32toh(header->size),
+           offset = (char *)header - (char *)message->body,
+           max    = _message_body_len(message);
+
+    if (offset >= max) {
+        return 0;
+    }
+
+    return len > max - offset? max - offset: len;
+}
+
+static int _packets_index_symbology(nexrad_message *message, size_t *sizep) {
+    nexrad_symbology_block *symbology = message->symbology;
+    size_t offset = sizeof(nexrad_symbology_block), len;
+    uint16_t layer;
+
+    if (symbology == NULL) {
+        return 0;
+    }
+
+    len = _block_len(message, &symbology->header);
+
+    for (layer=0; offset + sizeof(nexrad_symbology_layer) <= len; layer++) {
+        nexrad_symbology_layer *header = (nexrad_symbology_layer *)((char *)symbology + offset);
+        size_t size = be32toh(header->size);
+
+        if (size > len - offset - sizeof(*header)) {
+            break;
+        }
+
+        if (!(message->flags & NEXRAD_MESSAGE_TRUSTED) && (int16_t)be16toh(header->divider) != -1) {
+            break;
+        }
+
+        if (_packets_index_layer(message, sizep, NEXRAD_BLOCK_SYMBOLOGY, layer, (char *)(header + 1), size) < 0) {
+            return -1;
+        }
+
+        offset += sizeof(*header) + size;
+    }
+
+    return 0;
+}
+
+static int _packets_index_graphic(nexrad_message *message, size_t *sizep) {
+    nexrad_graphic_block *graphic = message->graphic;
+    size_t offset = sizeof(nexrad_graphic_block), len;
+    uint16_t page;
+
+    if (graphic == NULL) {
+        return 0;
+    }
+
+    len = _block_len(message, &graphic->header);
+
+    for (page=0; offset + sizeof(nexrad_graphic_page) <= len; page++) {
+        nexrad_graphic_page *header = (nexrad_graphic_page *)((char *)graphic + offset);
+        size_t size = be16toh(header->size);
+
+        if (size > len - offset - sizeof(*header)) {
+            break;
+        }
+
+        if (_packets_index_layer(message, sizep, NEXRAD_BLOCK_GRAPHIC, page, (char *)(header + 1), size) < 0) {
+            return -1;
+        }
+
+        offset += sizeof(*header) + size;
+    }
+
+    return 0;
+}
+
+/*
+ * Build the table of contents of packets within a message, and link together
+ * the entries of each packet type, such that the first of any type may be
+ * found by way of a small hash table.
+ */
+static int _message_index_packets(nexrad_message *message) {
+    uint32_t last[MESSAGE_PACKET_TYPE_SLOTS];
+    size_t size = 0, i;
+
+    if (message->packets_indexed) {
+        return message->packets_indexed < 0? -1: 0;
+    }
+
+    if (_message_index_body(message) < 0) {
+        goto error_message_index_body;
+    }
+
+    if (_packets_index_symbology(message, &size) < 0) {
+        goto error_packets_index;
+    }
+
+    if (_packets_index_graphic(message, &size) < 0) {
+        goto error_packets_index;
+    }
+
+    /*
+     * The table of packet types is only allocated once packets are first
+     * asked for, rather than with every message.
+     */
+    if (message->packet_count > 0) {
+        if ((message->packet_types = calloc(MESSAGE_PACKET_TYPE_SLOTS, sizeof(*message->packet_types))) == NULL) {
+            goto error_packets_index;
+        }
+    }
+
+    for (i=0; i<message->packet_count; i++) {
+        nexrad_packet_entry *entry = &message->packets[i];
+        size_t slot = _packet_type_slot(entry->type), probe;
+
+        for (probe=0; probe<MESSAGE_PACKET_TYPE_SLOTS; probe++) {
+            struct _message_packet_type *type = &message->packet_types[slot];
+
+            if (type->count == 0) {
+                type->type  = entry->type;
+                type->count = 1;
+                type->first = i;
+                last[slot]  = i;
+
+                break;
+            }
+
+            if (type->type == entry->type) {
+                message->packets[last[slot]].next = i;
+
+                type->count++;
+                last[slot] = i;
+
+                break;
+            }
+
+            slot = (slot + 1) % MESSAGE_PACKET_TYPE_SLOTS;
+        }
+
+        /*
+         * Should there somehow be more packet types than slots, then those
+         * remaining are simply left out of the table, and found by scanning.
+         */
+    }
+
+    message->packets_indexed = 1;
+
+    return 0;
+
+error_packets_index:
+    free(message->packets);
+
+    message->packets      = NULL;
+    message->packet_count = 0;
+
+error_message_index_body:
+    message->packets_indexed = -1;
+
+    return -1;
+}
+
+static struct _message_packet_type *_message_packet_type(nexrad_message *message, uint16_t type) {
+    size_t slot = _packet_type_slot(type), probe;
+
+    if (message->packet_types == NULL) {
+        return NULL;
+    }
+
+    for (probe=0; probe<MESSAGE_PACKET_TYPE_SLOTS; probe++) {
+        struct _message_packet_type *entry = &message->packet_types[slot];
+
+        if (entry->count == 0) {
+            return NULL;
+        }
+
+        if (entry->type == type) {
+            return entry;
+        }
+
+        slot = (slot + 1) % MESSAGE_PACKET_TYPE_SLOTS;
+    }
+
+    return NULL;
+}
+
+ssize_t nexrad_message_get_packet_entries(nexrad_message *message, const nexrad_packet_entry **entries) {
+    if (message == NULL || entries == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (_message_index_packets(message) < 0) {
+        return -1;
+    }
+
+    *entries = message->packets;
+
+    return message->packet_count;
+}
+
+const nexrad_packet_entry *nexrad_message_find_packet_entry(nexrad_message *message, enum nexrad_packet_type type) {
+    struct _message_packet_type *entry;
+    size_t i;
+
+    if (message == NULL || _message_index_packets(message) < 0) {
+        return NULL;
+    }
+
+    if ((entry = _message_packet_type(message, type)) != NULL) {
+        return &message->packets[entry->first];
+    }
+
+    /*
+     * Fall back to scanning the table, in the unlikely event that the type was
+     * left out of the hash table.
+     */
+    for (i=0; i<message->packet_count; i++) {
+        if (message->packets[i].type == type) {
+            return &message->packets[i];
+        }
+    }
+
+    return NULL;
+}
+
+const nexrad_packet_entry *nexrad_message_next_packet_entry(nexrad_message *message, const nexrad_packet_entry *entry) {
+    size_t i;
+
+    if (message == NULL || entry == NULL) {
+        return NULL;
+    }
+
+    if (entry->next != NEXRAD_PACKET_ENTRY_NONE) {
+        return &message->packets[entry->next];
+    }
+
+    if (_message_packet_type(message, entry->type) != NULL) {
+        return NULL;
+    }
+
+    for (i = entry - message->packets + 1; i<message->packet_count; i++) {
+        if (message->packets[i].type == entry->type) {
+            return &message->packets[i];
+        }
+    }
+
+    return NULL;
+}
+
+ssize_t nexrad_message_count_packets(nexrad_message *message, enum nexrad_packet_type type) {
+    struct _message_packet_type *entry;
+    ssize_t count = 0;
+    size_t i;
+
+    if (message == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if (_message_index_packets(message) < 0) {
+        return -1;
+    }
+
+    if ((entry = _message_packet_type(message, type)) != NULL) {
+        return entry->count;
+    }
+
+    for (i=0; i<message->packet_count; i++) {
+        if (message->packets[i].type == type) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+nexrad_packet *nexrad_message_get_packet(nexrad_message *message, const nexrad_packet_entry *entry) {
+    if (message == NULL || entry == NULL || message->body == NULL) {
+        return NULL;
+    }
+
+    return (nexrad_packet *)((char *)message->body + entry->offset);
+}
+
+nexrad_packet *nexrad_message_find_symbology_packet_by_type(nexrad_message *message, enum nexrad_packet_type type) {
+    const nexrad_packet_entry *entry;
+
+    for (entry = nexrad_message_find_packet_entry(message, type);
+         entry != NULL;
+         entry = nexrad_message_next_packet_entry(message, entry)) {
+        if (entry->block == NEXRAD_BLOCK_SYMBOLOGY) {
+            return nexrad_message_get_packet(message, entry);
+        }
+    }
+
+    return NULL;
+}
+
+static nexrad_packet_visitor _visitor_callback(const nexrad_message_visitor *visitor, uint16_t type) {
+    switch (type) {
+        case NEXRAD_PACKET_RADIAL:
+        case NEXRAD_PACKET_RADIAL_AF1F: return visitor->radial;
+
+        case NEXRAD_PACKET_RASTER_BA0F:
+        case NEXRAD_PACKET_RASTER_BA07: return visitor->raster;
+
+        case NEXRAD_PACKET_TEXT:   return visitor->text;
+        case NEXRAD_PACKET_VECTOR: return visitor->vector;
+        case NEXRAD_PACKET_CELL:   return visitor->cell;
+        case NEXRAD_PACKET_HAIL:   return visitor->hail;
+
+        default: {
+            break;
+        }
+    }
+
+    return visitor->other;
+}
+
+int nexrad_message_visit(nexrad_message *message, const nexrad_message_visitor *visitor, void *data) {
+    const nexrad_packet_entry *entries;
+    nexrad_tabular_block *tabular;
+    nexrad_tabular_text text;
+    ssize_t count, i, len;
+    char *line;
+    int page, number, ret;
+
+    if (message == NULL || visitor == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if ((count = nexrad_message_get_packet_entries(message, &entries)) < 0) {
+        goto error_get_packet_entries;
+    }
+
+    for (i=0; i<count; i++) {
+        nexrad_packet_visitor callback;
+
+        if ((callback = _visitor_callback(visitor, entries[i].type)) == NULL) {
+            continue;
+        }
+
+        if ((ret = callback((nexrad_packet *)((char *)message->body + entries[i].offset), &entries[i], data)) != 0) {
+            return ret;
+        }
+    }
 
-    message->size        = len;
-    message->page_size   = 0;
-    message->mapped_size = 0;
-    message->fd          = 0;
-    message->data        = buf;
+    if (visitor->tabular == NULL) {
+        return 0;
+    }
 
-    if (_message_index(message) < 0) {
-        goto error_message_index;
+    if ((tabular = nexrad_message_get_tabular_block(message)) == NULL) {
+        return 0;
     }
 
-    return message;
+    if (nexrad_tabular_block_init(&text, tabular) < 0) {
+        goto error_tabular_block_init;
+    }
 
-error_message_index:
-    nexrad_message_destroy(message);
+    while ((len = nexrad_tabular_block_read_line(&text, &line, &page, &number)) > 0) {
+        if ((ret = visitor->tabular(line, len, page, number, data)) != 0) {
+            return ret;
+        }
+    }
 
-error_malloc:
-    return NULL;
+    return 0;
+
+error_tabular_block_init:
+error_get_packet_entries:
+    return -1;
 }
 
-nexrad_message *nexrad_message_open(const char *path) {
-    nexrad_message *message;
-    struct stat st;
+/*
+ * State shared between the thread decompressing a message body, and the
+ * thread consuming rays from the body as they become available.
+ */
+struct _message_stream {
+    pthread_mutex_t lock;
+    pthread_cond_t  progress;
 
-    if ((message = malloc(sizeof(nexrad_message))) == NULL) {
-        goto error_malloc;
-    }
+    nexrad_message_ctx * ctx;
+    bz_stream            stream;
 
-    if (stat(path, &st) < 0) {
-        goto error_stat;
-    }
+    void * src;
+    size_t srclen;
+    void * dest;
+    size_t destlen;
 
-    if (st.st_size > NEXRAD_MESSAGE_MAX_SIZE) {
-        errno = EFBIG;
+    size_t avail; /* Number of bytes decompressed so far */
+    int    done;  /* 1 once decompressed, -1 upon failure */
+    int    stop;  /* Set by the consumer to abandon decompression */
 
-        goto error_efbig;
-    }
+    int trusted; /* Message was opened with NEXRAD_MESSAGE_TRUSTED */
+};
 
-    if (st.st_size < sizeof(nexrad_message)) {
-        errno = EINVAL;
+static int _stream_publish(struct _message_stream *stream, size_t avail, int done) {
+    int stop;
 
-        goto error_einval;
-    }
+    pthread_mutex_lock(&stream->lock);
 
-    message->size        = st.st_size;
-    message->page_size   = (size_t)sysconf(_SC_PAGESIZE);
-    message->mapped_size = _mapped_size(st.st_size, message->page_size);
+    stream->avail = avail;
+    stream->done  = done;
+    stop          = stream->stop;
 
-    if ((message->fd = open(path, O_RDONLY)) < 0) {
-        goto error_open;
-    }
+    pthread_cond_broadcast(&stream->progress);
+    pthread_mutex_unlock(&stream->lock);
 
-    if ((message->data = mmap(NULL, message->mapped_size, PROT_READ, MAP_PRIVATE, message->fd, 0)) == NULL) {
-        goto error_mmap;
+    return stop;
+}
+
+static void *_stream_decompress(void *data) {
+    struct _message_stream *stream = data;
+    bz_stream *bz = &stream->stream;
+    int ret;
+
+    if (stream->ctx) {
+        bz->bzalloc = _ctx_bzalloc;
+        bz->bzfree  = _ctx_bzfree;
+        bz->opaque  = stream->ctx;
     }
 
-    if (_message_index(message) < 0) {
-        goto error_message_index;
+    if (BZ2_bzDecompressInit(bz, 0, 0) != BZ_OK) {
+        goto error_decompress_init;
     }
 
-    return message;
+    bz->next_in  = stream->src;
+    bz->avail_in = stream->srclen;
+    bz->next_out = stream->dest;
 
-error_message_index:
-error_mmap:
-error_open:
-    nexrad_message_destroy(message);
+    /*
+     * Decompress the body a step at a time, releasing the output of each step
+     * to the consumer, until the end of the stream is reached, the consumer
+     * loses interest, or the decompressor stops making progress.
+     */
+    for (;;) {
+        size_t total = bz->total_out_lo32,
+               left  = stream->destlen - total;
 
-    return NULL;
+        unsigned int avail_in = bz->avail_in;
 
-error_einval:
-error_efbig:
-error_stat:
-    free(message);
+        bz->avail_out = left < MESSAGE_STREAM_STEP? left: MESSAGE_STREAM_STEP;
 
-error_malloc:
-    return NULL;
-}
+        ret = BZ2_bzDecompress(bz);
 
-void nexrad_message_destroy(nexrad_message *message) {
-    if (message == NULL) {
-        return;
-    }
+        if (ret == BZ_STREAM_END) {
+            break;
+        }
 
-    if (message->data && message->mapped_size > 0) {
-        munmap(message->data, message->mapped_size);
+        if (ret != BZ_OK || (bz->avail_in == avail_in && bz->total_out_lo32 == total)) {
+            goto error_decompress;
+        }
 
-        message->data        = NULL;
-        message->mapped_size = 0;
+        if (_stream_publish(stream, bz->total_out_lo32, 0)) {
+            goto error_decompress;
+        }
     }
 
-    if (message->fd) {
-        close(message->fd);
+    BZ2_bzDecompressEnd(bz);
 
-        message->fd = 0;
-    }
+    _stream_publish(stream, bz->total_out_lo32, 1);
 
-    if (message->body && message->compression != NEXRAD_PRODUCT_COMPRESSION_NONE) {
-        message->compression = NEXRAD_PRODUCT_COMPRESSION_NONE;
-        free(message->body);
-    }
+    return NULL;
 
-    message->size           = 0;
-    message->page_size      = 0;
-    message->body           = NULL;
-    message->unknown_header = NULL;
-    message->wmo_header     = NULL;
-    message->message_header = NULL;
-    message->description    = NULL;
-    message->symbology      = NULL;
-    message->graphic        = NULL;
-    message->tabular        = NULL;
+error_decompress:
+    BZ2_bzDecompressEnd(bz);
 
-    free(message);
+error_decompress_init:
+    _stream_publish(stream, stream->avail, -1);
 
-    return;
+    return NULL;
 }
 
-void nexrad_message_close(nexrad_message *message) {
-    nexrad_message_destroy(message);
-}
+/*
+ * Wait until at least `needed` bytes of the body have been decompressed.
+ */
+static int _stream_wait(struct _message_stream *stream, size_t needed) {
+    int ret = 0;
 
-nexrad_chunk *nexrad_message_open_symbology_block(nexrad_message *message) {
-    return nexrad_symbology_block_open(message->symbology);
-}
+    if (needed > stream->destlen) {
+        return -1;
+    }
 
-nexrad_chunk *nexrad_message_open_graphic_block(nexrad_message *message) {
-    return nexrad_graphic_block_open(message->graphic);
-}
+    pthread_mutex_lock(&stream->lock);
 
-nexrad_tabular_text *nexrad_message_open_tabular_block(nexrad_message *message) {
-    return nexrad_tabular_block_open(message->tabular);
-}
+    while (stream->avail < needed && stream->done == 0) {
+        pthread_cond_wait(&stream->progress, &stream->lock);
+    }
 
-nexrad_message_header *nexrad_message_get_header(nexrad_message *message) {
-    if (message == NULL) {
-        return NULL;
+    if (stream->avail < needed) {
+        ret = -1;
     }
 
-    return message->message_header;
+    pthread_mutex_unlock(&stream->lock);
+
+    return ret;
 }
 
-nexrad_product_description *nexrad_message_get_product_description(nexrad_message *message) {
-    if (message == NULL) {
-        return NULL;
+static int _stream_finish(struct _message_stream *stream) {
+    int done;
+
+    pthread_mutex_lock(&stream->lock);
+
+    while (stream->done == 0) {
+        pthread_cond_wait(&stream->progress, &stream->lock);
     }
 
-    return message->description;
+    done = stream->done;
+
+    pthread_mutex_unlock(&stream->lock);
+
+    return done;
 }
 
-nexrad_symbology_block *nexrad_message_get_symbology_block(nexrad_message *message) {
-    if (message == NULL) {
+/*
+ * Locate the first packet of the first layer of the product symbology block,
+ * at `offset` within the body, waiting for the headers involved to be
+ * decompressed.
+ */
+static nexrad_radial_packet *_stream_radial_packet(struct _message_stream *stream, size_t offset) {
+    nexrad_symbology_block *block;
+    nexrad_radial_packet *packet;
+    size_t layer = offset + sizeof(nexrad_symbology_block);
+
+    if (_stream_wait(stream, layer + sizeof(nexrad_symbology_layer) + sizeof(nexrad_radial_packet)) < 0) {
         return NULL;
     }
 
-    return message->symbology;
-}
+    block = (nexrad_symbology_block *)((char *)stream->dest + offset);
 
-nexrad_graphic_block *nexrad_message_get_graphic_block(nexrad_message *message) {
-    if (message == NULL) {
+    if (!stream->trusted && ((int16_t)be16toh(block->header.divider) != -1
+      || be16toh(block->header.id) != NEXRAD_BLOCK_SYMBOLOGY
+      || (int16_t)be16toh(((nexrad_symbology_layer *)((char *)stream->dest + layer))->divider) != -1)) {
         return NULL;
     }
 
-    return message->graphic;
-}
+    packet = (nexrad_radial_packet *)((char *)stream->dest + layer + sizeof(nexrad_symbology_layer));
 
-nexrad_tabular_block *nexrad_message_get_tabular_block(nexrad_message *message) {
-    if (message == NULL) {
-        return NULL;
+    switch (be16toh(packet->type)) {
+        case NEXRAD_PACKET_RADIAL:
+        case NEXRAD_PACKET_RADIAL_AF1F: {
+            return packet;
+        }
+
+        default: {
+            break;
+        }
     }
 
-    return message->tabular;
+    return NULL;
 }
 
-time_t nexrad_message_get_scan_timestamp(nexrad_message *message) {
-    if (message == NULL) {
-        return -1;
+static size_t _ray_size(nexrad_radial *radial, nexrad_radial_ray *ray) {
+    size_t size = be16toh(ray->size);
+
+    if (radial->type == NEXRAD_RADIAL_RLE) {
+        return sizeof(nexrad_radial_ray) + size * 2;
     }
 
-    return nexrad_date_timestamp(&message->description->scan_date);
+    return sizeof(nexrad_radial_ray) + size + (size % 2);
 }
 
-time_t nexrad_message_get_gen_timestamp(nexrad_message *message) {
-    if (message == NULL) {
-        return -1;
+static int _radial_init(int trusted, nexrad_radial *radial, nexrad_radial_packet *packet, uint8_t *values) {
+    if (trusted) {
+        return radial_init_trusted(radial, packet, values);
     }
 
-    return nexrad_date_timestamp(&message->description->gen_date);
+    return nexrad_radial_init(radial, packet, values);
 }
 
-int nexrad_message_get_product_type(nexrad_message *message) {
-    if (message == NULL) {
+static int _stream_rays(struct _message_stream *stream, nexrad_radial_packet *packet, nexrad_ray_callback callback, void *data) {
+    nexrad_radial radial;
+    uint8_t values[NEXRAD_RADIAL_MAX_BINS];
+    int ret = 0;
+
+    if (_radial_init(stream->trusted, &radial, packet, values) < 0) {
         return -1;
     }
 
-    return be16toh(message->message_header->product_type);
-}
+    /*
+     * Rays past the current one may not have been decompressed yet, so keep
+     * the callback from reading ahead of the stream.
+     */
+    radial.partial = 1;
 
-int nexrad_message_find_product_code(nexrad_message *message, char **code, size_t *len) {
-    if (message == NULL) return -1;
+    while (radial.rays_left > 0) {
+        size_t offset = (char *)radial.current - (char *)stream->dest;
+        nexrad_radial_ray *ray;
+        uint8_t *ray_values;
 
-    if (code && len) {
-        *code = message->wmo_header->product_code;
-        *len  = sizeof(message->wmo_header->product_code);
-    }
+        if (_stream_wait(stream, offset + sizeof(nexrad_radial_ray)) < 0) {
+            ret = -1;
+            break;
+        }
 
-    return 0;
-}
+        if (_stream_wait(stream, offset + _ray_size(&radial, radial.current)) < 0) {
+            ret = -1;
+            break;
+        }
 
-int nexrad_message_find_region(nexrad_message *message, char **region, size_t *len) {
-    if (message == NULL) return -1;
+        if ((ray = radial_read_ray(&radial, &ray_values)) == NULL) {
+            ret = -1;
+            break;
+        }
 
-    if (region && len) {
-        *region = message->wmo_header->region;
-        *len    = sizeof(message->wmo_header->region);
+        if ((ret = callback(&radial, ray, ray_values, data)) != 0) {
+            break;
+        }
     }
 
-    return 0;
+    nexrad_radial_release(&radial);
+
+    return ret;
 }
 
-int nexrad_message_find_office(nexrad_message *message, char **office, size_t *len) {
-    if (message == NULL) return -1;
+/*
+ * Deliver the rays of the first radial packet in a message whose body has
+ * already been decompressed, or needs no decompression.
+ */
+static int _message_read_rays(nexrad_message *message, nexrad_ray_callback callback, void *data) {
+    nexrad_radial radial;
+    nexrad_radial_ray *ray;
+    nexrad_packet *packet;
+    uint8_t values[NEXRAD_RADIAL_MAX_BINS], *ray_values;
+    int ret;
+
+    if ((packet = nexrad_message_find_symbology_packet_by_type(message, NEXRAD_PACKET_RADIAL)) == NULL
+      && (packet = nexrad_message_find_symbology_packet_by_type(message, NEXRAD_PACKET_RADIAL_AF1F)) == NULL) {
+        goto error_find_packet;
+    }
 
-    if (office && len) {
-        *office = message->wmo_header->office;
-        *len    = sizeof(message->wmo_header->office);
+    if (_radial_init(message->flags & NEXRAD_MESSAGE_TRUSTED, &radial, (nexrad_radial_packet *)packet, values) < 0) {
+        goto error_radial_init;
     }
 
-    return 0;
-}
+    ret = 0;
 
-char nexrad_message_get_station_prefix(nexrad_message *message) {
-    if (message == NULL) {
-        return '\0';
+    while ((ray = nexrad_radial_read_ray(&radial, &ray_values)) != NULL) {
+        if ((ret = callback(&radial, ray, ray_values, data)) != 0) {
+            break;
+        }
     }
 
-    return message->wmo_header->office[0];
-}
+    nexrad_radial_release(&radial);
 
-int nexrad_message_find_station_suffix(nexrad_message *message, char **suffix, size_t *len) {
-    if (message == NULL) {
-        return -1;
-    }
+    return ret;
 
-    if (suffix && len) {
-        *suffix = message->wmo_header->station;
-        *len    = sizeof(message->wmo_header->station);
-    }
+error_radial_init:
+error_find_packet:
+    errno = EINVAL;
 
-    return 0;
+    return -1;
 }
 
-int nexrad_message_read_station(nexrad_message *message, char *dest, size_t destlen) {
-    char station[5];
+int nexrad_message_stream_rays(nexrad_message *message, nexrad_ray_callback callback, void *data) {
+    nexrad_product_description *description;
+    struct _message_stream stream;
+    nexrad_radial_packet *packet;
+    pthread_t producer;
+    uint32_t offset;
+    int ret, threaded;
+
+    if (message == NULL || callback == NULL) {
+        errno = EINVAL;
 
-    if (message == NULL) {
         return -1;
     }
 
-    station[0] = message->wmo_header->office[0];
-    memcpy(station + 1, message->wmo_header->station, 3);
-    station[4] = '\0';
+    description = message->description;
 
-    return safecpy(
-        dest,    station,
-        destlen, sizeof(station) - 1
-    );
-}
+    /*
+     * Streaming is only of any use for compressed bodies yet to be
+     * decompressed; otherwise, simply read the rays from the body.  Bodies
+     * held in a shared cache are likewise left to the usual path, so that
+     * they may be shared with other consumers.
+     */
+    if (message->indexed
+      || !nexrad_product_type_supports_compression(be16toh(description->type))
+      || be16toh(description->attributes.compression.method) != NEXRAD_PRODUCT_COMPRESSION_BZIP2
+      || (message->ctx && message->ctx->cache)) {
+        return _message_read_rays(message, callback, data);
+    }
 
-int nexrad_message_read_station_location(nexrad_message *message, double *lat, double *lon, double *alt) {
-    if (message == NULL || lat == NULL || lon == NULL) {
-        return -1;
+    if (description->symbology_offset == 0) {
+        goto error_no_symbology;
     }
 
-    *lat = NEXRAD_PRODUCT_COORD_MAGNITUDE * (int32_t)be32toh(message->description->station_lat);
-    *lon = NEXRAD_PRODUCT_COORD_MAGNITUDE * (int32_t)be32toh(message->description->station_lon);
+    memset(&stream, '\0', sizeof(stream));
 
-    if (alt)
-        *alt = NEXRAD_PRODUCT_ALT_FACTOR * (int16_t)be16toh(message->description->station_altitude);
+    stream.ctx     = message->ctx;
+    stream.trusted = message->flags & NEXRAD_MESSAGE_TRUSTED;
+    stream.src     = nexrad_block_after(description, nexrad_product_description);
+    stream.srclen  = _message_get_body_size(message);
+    stream.destlen = be32toh(description->attributes.compression.size);
+    offset         = _halfword_body_offset(description->symbology_offset);
 
-    return 0;
-}
+    if (stream.destlen > NEXRAD_MESSAGE_MAX_BODY_SIZE || offset >= stream.destlen) {
+        goto error_invalid_body;
+    }
 
-nexrad_packet *nexrad_message_find_symbology_packet_by_type(nexrad_message *message, enum nexrad_packet_type type) {
-    nexrad_symbology_block *symbology;
-    nexrad_chunk *block, *layer;
-    nexrad_packet *ret = NULL;
+    if ((stream.dest = message_ctx_body_take(message->ctx, stream.destlen, &message->body_size)) == NULL) {
+        goto error_body_take;
+    }
 
-    if (message == NULL) {
-        return NULL;
+    if (pthread_mutex_init(&stream.lock, NULL) != 0) {
+        goto error_mutex_init;
     }
 
-    if ((symbology = nexrad_message_get_symbology_block(message)) == NULL) {
-        goto error_get_symbology_block;
+    if (pthread_cond_init(&stream.progress, NULL) != 0) {
+        goto error_cond_init;
     }
 
-    if ((block = nexrad_symbology_block_open(symbology)) == NULL) {
-        goto error_symbology_block_open;
+    /*
+     * Should a thread not be available to decompress the body, then
+     * decompress it in full before delivering any rays.
+     */
+    if (!(threaded = pthread_create(&producer, NULL, _stream_decompress, &stream) == 0)) {
+        _stream_decompress(&stream);
     }
 
-    while ((layer = nexrad_symbology_block_read_layer(block)) != NULL) {
-        nexrad_packet *packet;
-        size_t size;
+    if ((packet = _stream_radial_packet(&stream, offset)) == NULL) {
+        ret = -1;
+    } else {
+        ret = _stream_rays(&stream, packet, callback, data);
+    }
 
-        while ((packet = nexrad_symbology_layer_peek_packet(layer, &size)) != NULL) {
-            if (nexrad_packet_get_type(packet) != type) {
-                nexrad_symbology_layer_next_packet(layer, size);
+    /*
+     * Upon failure or an early stop, abandon decompression; otherwise, wait
+     * for the remainder of the body, which is then retained by the message
+     * as though it were decompressed upon opening.
+     */
+    if (ret != 0) {
+        pthread_mutex_lock(&stream.lock);
+        stream.stop = 1;
+        pthread_mutex_unlock(&stream.lock);
+    }
 
-                continue;
-            }
+    if (threaded) {
+        pthread_join(producer, NULL);
+    }
+
+    if (ret == 0 && _stream_finish(&stream) < 0) {
+        ret = -1;
+    }
+
+    pthread_cond_destroy(&stream.progress);
+    pthread_mutex_destroy(&stream.lock);
 
-            ret = packet;
+    if (ret != 0) {
+        message_ctx_body_give(message->ctx, stream.dest, message->body_size);
 
-            nexrad_symbology_layer_close(layer);
+        message->body_size = 0;
 
-            goto done;
+        if (ret < 0) {
+            errno = EINVAL;
         }
 
-        nexrad_symbology_layer_close(layer);
+        return ret;
     }
 
-done:
-    nexrad_symbology_block_close(block);
+    message->body        = stream.dest;
+    message->body_len    = stream.avail;
+    message->compression = NEXRAD_PRODUCT_COMPRESSION_BZIP2;
 
-    return ret;
+    if (_message_index_body(message) < 0) {
+        return -1;
+    }
 
-error_symbology_block_open:
-error_get_symbology_block:
-    return NULL;
+    return 0;
+
+error_cond_init:
+    pthread_mutex_destroy(&stream.lock);
+
+error_mutex_init:
+    message_ctx_body_give(message->ctx, stream.dest, message->body_size);
+
+    message->body_size = 0;
+
+error_body_take:
+error_invalid_body:
+error_no_symbology:
+    errno = EINVAL;
+
+    return -1;
 }
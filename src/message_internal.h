@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _MESSAGE_INTERNAL_H
+#define _MESSAGE_INTERNAL_H
+
+#include <sys/types.h>
+
+#include <nexrad/message.h>
+
+/*
+ * The number of zeroed bytes to follow message data read into a buffer, in
+ * lieu of the zero-filled tail of the final page of a mapped message file.
+ */
+#define MESSAGE_READ_SLACK 16
+
+/*
+ * The smallest file which could possibly hold a valid message.
+ */
+#define MESSAGE_MIN_SIZE \
+    (sizeof(nexrad_wmo_header) + sizeof(nexrad_message_header) + sizeof(nexrad_product_description))
+
+/*
+ * Borrow a buffer of at least `size` bytes from a decoding context, which may
+ * be NULL, for use as a decompressed message body; the actual size of the
+ * buffer is written to `sizep`.
+ */
+void *message_ctx_body_take(nexrad_message_ctx *ctx, size_t size, size_t *sizep);
+
+/*
+ * Return a buffer obtained with message_ctx_body_take() to its context.
+ */
+void message_ctx_body_give(nexrad_message_ctx *ctx, void *body, size_t size);
+
+/*
+ * Borrow a buffer of at least `size` bytes from a decoding context, which may
+ * be NULL, for use as raw message data; the actual size of the buffer is
+ * written to `sizep`.
+ */
+void *message_ctx_data_take(nexrad_message_ctx *ctx, size_t size, size_t *sizep);
+
+/*
+ * Return a buffer obtained with message_ctx_data_take() to its context.
+ */
+void message_ctx_data_give(nexrad_message_ctx *ctx, void *data, size_t size);
+
+/*
+ * Open a message from raw message data in `data` whose body has already been
+ * decompressed into `body`, a buffer of `body_size` bytes obtained with
+ * message_ctx_body_take() holding `body_len` bytes of decompressed data, or
+ * NULL if the message is not compressed.  Upon
+ * success, the message takes ownership of both `data`, which must have been
+ * allocated with malloc(), and `body`.  Upon failure, ownership of both
+ * remains with the caller.
+ */
+nexrad_message *message_open_decoded(void *data,
+    size_t size,
+    void *body,
+    size_t body_size,
+    size_t body_len,
+    nexrad_message_ctx *ctx
+);
+
+/*
+ * Return the offset of the message header within the raw message data in
+ * `buf`, following the WMO header, and the unknown header if present.
+ */
+size_t message_header_offset(const void *buf, size_t len);
+
+/*
+ * Write the message to `fd` with its body decompressed, and its headers and
+ * product description amended to describe an uncompressed product, such
+ * that the result may itself be opened as a message without decompression.
+ * Returns the number of bytes written, or -1 on failure, including when the
+ * message is not compressed.
+ */
+ssize_t message_write_decoded(nexrad_message *message, int fd);
+
+#endif /* _MESSAGE_INTERNAL_H */
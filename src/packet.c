@@ -25,6 +25,8 @@
 #include "util.h"
 
 #include <nexrad/packet.h>
+#include <nexrad/radial.h>
+#include <nexrad/raster.h>
 
 enum nexrad_packet_type nexrad_packet_get_type(nexrad_packet *packet) {
     if (packet == NULL) return 0;
@@ -32,6 +34,103 @@ enum nexrad_packet_type nexrad_packet_get_type(nexrad_packet *packet) {
     return be16toh(packet->type);
 }
 
+static ssize_t _radial_packet_size(nexrad_radial_packet *packet, size_t len) {
+    size_t size = sizeof(nexrad_radial_packet);
+    uint16_t rays, i;
+    int rle;
+
+    if (len < size) {
+        return -1;
+    }
+
+    rays = be16toh(packet->rays);
+    rle  = be16toh(packet->type) == NEXRAD_PACKET_RADIAL_AF1F;
+
+    for (i=0; i<rays; i++) {
+        nexrad_radial_ray *ray = (nexrad_radial_ray *)((char *)packet + size);
+        size_t data;
+
+        if (size + sizeof(nexrad_radial_ray) > len) {
+            return -1;
+        }
+
+        /*
+         * Run length encoded rays give their size in halfwords, whereas
+         * digital rays give their size in bytes, padded to a halfword.
+         */
+        if (rle) {
+            data = be16toh(ray->size) * 2;
+        } else {
+            data = be16toh(ray->size);
+
+            if ((sizeof(nexrad_radial_ray) + data) % 2) data++;
+        }
+
+        size += sizeof(nexrad_radial_ray) + data;
+    }
+
+    return size;
+}
+
+static ssize_t _raster_packet_size(nexrad_raster_packet *packet, size_t len) {
+    size_t size = sizeof(nexrad_raster_packet);
+    uint16_t lines, i;
+
+    if (len < size) {
+        return -1;
+    }
+
+    lines = be16toh(packet->lines);
+
+    for (i=0; i<lines; i++) {
+        nexrad_raster_line *line = (nexrad_raster_line *)((char *)packet + size);
+
+        if (size + sizeof(nexrad_raster_line) > len) {
+            return -1;
+        }
+
+        size += sizeof(nexrad_raster_line) + be16toh(line->runs);
+    }
+
+    return size;
+}
+
+ssize_t nexrad_packet_find_size(nexrad_packet *packet, size_t len) {
+    ssize_t size;
+
+    if (packet == NULL || len < sizeof(nexrad_packet_header)) {
+        return -1;
+    }
+
+    switch (be16toh(packet->type)) {
+        case NEXRAD_PACKET_RADIAL:
+        case NEXRAD_PACKET_RADIAL_AF1F: {
+            size = _radial_packet_size((nexrad_radial_packet *)packet, len);
+
+            break;
+        }
+
+        case NEXRAD_PACKET_RASTER_BA0F:
+        case NEXRAD_PACKET_RASTER_BA07: {
+            size = _raster_packet_size((nexrad_raster_packet *)packet, len);
+
+            break;
+        }
+
+        default: {
+            size = sizeof(nexrad_packet_header) + be16toh(packet->size);
+
+            break;
+        }
+    }
+
+    if (size < 0 || size > len) {
+        return -1;
+    }
+
+    return size;
+}
+
 int nexrad_packet_find_text_data(nexrad_packet *packet, int *i, int *j, int *color, char **data, size_t *textlen) {
     nexrad_text_packet *text;
 
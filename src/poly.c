@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
 
 #include <nexrad/poly.h>
 #include <nexrad/geo.h>
@@ -134,6 +135,15 @@ int nexrad_poly_multi_size_for_radial(nexrad_radial *radial, int min, int max, s
         return -1;
     }
 
+    /*
+     * Readers of packets still being decompressed cannot be rewound.
+     */
+    if (radial->partial) {
+        errno = EBUSY;
+
+        return -1;
+    }
+
     if (nexrad_radial_get_info(radial, NULL, &bins, NULL, NULL, NULL, NULL) < 0) {
         goto error_radial_get_info;
     }
@@ -191,6 +201,15 @@ int nexrad_poly_multi_write_from_radial(nexrad_radial *radial, int min, int max,
         return -1;
     }
 
+    /*
+     * Readers of packets still being decompressed cannot be rewound.
+     */
+    if (radial->partial) {
+        errno = EBUSY;
+
+        return -1;
+    }
+
     if (nexrad_radial_get_info(radial, NULL, &bins, NULL, NULL, NULL, NULL) < 0) {
         goto error_radial_get_info;
     }
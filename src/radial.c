@@ -26,23 +26,13 @@
 #include <math.h>
 #include <errno.h>
 #include "util.h"
+#include "radial_internal.h"
+#include "rle.h"
 
 #include <nexrad/radial.h>
 
 #define NEXRAD_RADIAL_BUFFER_RAY_WIDTH 10
 
-struct _nexrad_radial {
-    nexrad_radial_packet *  packet;
-    enum nexrad_radial_type type;
-    nexrad_radial_ray *     current;
-
-    size_t bytes_read;
-    size_t rays_left;
-
-    uint16_t  bins;
-    uint8_t * values;
-};
-
 static int _valid_rle_packet(nexrad_radial_packet *packet) {
     if (
       be16toh(packet->rangebin_first) >   460 ||
@@ -84,6 +74,21 @@ static int _valid_packet(nexrad_radial_packet *packet, enum nexrad_radial_type t
     return 0;
 }
 
+/*
+ * Operations which read rays other than the current one are refused while
+ * the rest of the packet may not yet be readable, as is the case for readers
+ * passed to the callback of nexrad_message_stream_rays().
+ */
+static inline int _radial_partial(nexrad_radial *radial) {
+    if (radial->partial) {
+        errno = EBUSY;
+
+        return 1;
+    }
+
+    return 0;
+}
+
 nexrad_radial_buffer *nexrad_radial_unpack(nexrad_radial *radial) {
     nexrad_radial_buffer *buffer;
     nexrad_radial_ray *ray;
@@ -96,7 +101,7 @@ nexrad_radial_buffer *nexrad_radial_unpack(nexrad_radial *radial) {
 
     uint8_t *values;
 
-    if (radial == NULL) {
+    if (radial == NULL || _radial_partial(radial)) {
         return NULL;
     }
 
@@ -118,8 +123,18 @@ nexrad_radial_buffer *nexrad_radial_unpack(nexrad_radial *radial) {
         int j, b;
 
         for (j=start; j<start+delta; j++) {
+            /*
+             * Wrap rays which cross north back to the start of the buffer,
+             * and drop any tenth of a degree beyond those it has room for.
+             */
+            int row = j % NEXRAD_RADIAL_AZIMUTH_SLOTS;
+
+            if (row >= NEXRAD_RADIAL_BUFFER_RAY_WIDTH * rays) {
+                continue;
+            }
+
             for (b=first; b<bins; b++) {
-                ((uint8_t *)(buffer + 1))[bins*j+b] = values[b];
+                ((uint8_t *)(buffer + 1))[bins*row+b] = values[b];
             }
         }
     }
@@ -137,69 +152,89 @@ error_malloc:
 }
 
 nexrad_radial_buffer *nexrad_radial_packet_unpack(nexrad_radial_packet *packet) {
-    nexrad_radial_buffer *buffer;
-    nexrad_radial *radial;
+    nexrad_radial radial;
+    uint8_t values[NEXRAD_RADIAL_MAX_BINS];
 
     if (packet == NULL) {
         return NULL;
     }
 
-    if ((radial = nexrad_radial_packet_open(packet)) == NULL) {
-        goto error_radial_packet_open;
+    if (nexrad_radial_init(&radial, packet, values) < 0) {
+        return NULL;
+    }
+
+    return nexrad_radial_unpack(&radial);
+}
+
+static void _radial_init(nexrad_radial *radial, nexrad_radial_packet *packet, enum nexrad_radial_type type, uint8_t *values) {
+    radial->packet     = packet;
+    radial->type       = type;
+    radial->bytes_read = sizeof(nexrad_radial_packet);
+    radial->rays_left  = be16toh(packet->rays);
+    radial->current    = (nexrad_radial_ray *)((char *)packet + sizeof(nexrad_radial_packet));
+    radial->bins       = be16toh(packet->rangebin_count);
+    radial->values     = values;
+    radial->index      = NULL;
+    radial->partial    = 0;
+}
+
+
+int nexrad_radial_init(nexrad_radial *radial, nexrad_radial_packet *packet, uint8_t *values) {
+    enum nexrad_radial_type type;
+
+    if (radial == NULL || packet == NULL || values == NULL) {
+        return -1;
     }
 
-    if ((buffer = nexrad_radial_unpack(radial)) == NULL) {
-        goto error_radial_unpack;
+    type = be16toh(packet->type);
+
+    if (!_valid_packet(packet, type)) {
+        return -1;
     }
 
-    nexrad_radial_close(radial);
+    _radial_init(radial, packet, type, values);
 
-    return buffer;
+    return 0;
+}
 
-error_radial_unpack:
-    nexrad_radial_close(radial);
+int radial_init_trusted(nexrad_radial *radial, nexrad_radial_packet *packet, uint8_t *values) {
+    enum nexrad_radial_type type = be16toh(packet->type);
 
-error_radial_packet_open:
-    return NULL;
+    if (type != NEXRAD_RADIAL_RLE && type != NEXRAD_RADIAL_DIGITAL) {
+        return -1;
+    }
+
+    if (be16toh(packet->rangebin_count) > NEXRAD_RADIAL_MAX_BINS) {
+        return -1;
+    }
+
+    _radial_init(radial, packet, type, values);
+
+    return 0;
 }
 
 nexrad_radial *nexrad_radial_packet_open(nexrad_radial_packet *packet) {
     nexrad_radial *radial;
-    enum nexrad_radial_type type;
-    uint16_t bins;
-    uint8_t *values;
 
     if (packet == NULL) {
         return NULL;
     }
 
-    type = be16toh(packet->type);
-
-    if (!_valid_packet(packet, type)) {
-        return NULL;
-    }
-
-    if ((radial = malloc(sizeof(*radial))) == NULL) {
+    /*
+     * Allocate the scratch space for rangebin values along with the reader
+     * itself, so that both may be released with a single free().
+     */
+    if ((radial = malloc(sizeof(*radial) + be16toh(packet->rangebin_count))) == NULL) {
         goto error_malloc_radial;
     }
 
-    bins = be16toh(packet->rangebin_count);
-
-    if ((values = malloc(bins)) == NULL) {
-        goto error_malloc_values;
+    if (nexrad_radial_init(radial, packet, (uint8_t *)(radial + 1)) < 0) {
+        goto error_init;
     }
 
-    radial->packet     = packet;
-    radial->type       = type;
-    radial->bytes_read = sizeof(nexrad_radial_packet);
-    radial->rays_left  = be16toh(packet->rays);
-    radial->current    = (nexrad_radial_ray *)((char *)packet + sizeof(nexrad_radial_packet));
-    radial->bins       = bins;
-    radial->values     = values;
-
     return radial;
 
-error_malloc_values:
+error_init:
     free(radial);
 
 error_malloc_radial:
@@ -214,7 +249,7 @@ size_t nexrad_radial_bytes_read(nexrad_radial *radial) {
 }
 
 void nexrad_radial_reset(nexrad_radial *radial) {
-    if (radial == NULL)
+    if (radial == NULL || _radial_partial(radial))
         return;
 
     radial->bytes_read = 0;
@@ -222,12 +257,20 @@ void nexrad_radial_reset(nexrad_radial *radial) {
     radial->current    = (nexrad_radial_ray *)((char *)radial->packet + sizeof(nexrad_radial_packet));
 }
 
+void nexrad_radial_release(nexrad_radial *radial) {
+    if (radial == NULL)
+        return;
+
+    free(radial->index);
+
+    radial->index = NULL;
+}
+
 void nexrad_radial_close(nexrad_radial *radial) {
     if (radial == NULL)
         return;
 
-    if (radial->values)
-        free(radial->values);
+    free(radial->index);
 
     memset(radial, '\0', sizeof(*radial));
 
@@ -238,29 +281,109 @@ void nexrad_radial_destroy(nexrad_radial *radial) {
     if (radial == NULL)
         return;
 
-    if (radial->values)
-        free(radial->values);
-
     if (radial->packet)
         free(radial->packet);
 
+    free(radial->index);
+
     memset(radial, '\0', sizeof(*radial));
 
     free(radial);
 }
 
-static inline nexrad_radial_ray *_radial_ray_by_index(nexrad_radial *radial, uint16_t azimuth) {
-    uint16_t bins = be16toh(radial->packet->rangebin_count);
+static size_t _ray_size(enum nexrad_radial_type type, nexrad_radial_ray *ray) {
+    size_t size = be16toh(ray->size);
 
-    return (nexrad_radial_ray *)((char *)radial->packet
-        + sizeof(nexrad_radial_packet)
-        + azimuth * (sizeof(nexrad_radial_ray) + bins));
+    if (type == NEXRAD_RADIAL_RLE) {
+        return sizeof(nexrad_radial_ray) + size * 2;
+    }
+
+    return sizeof(nexrad_radial_ray) + size + (size % 2);
 }
 
-nexrad_radial_ray *nexrad_radial_get_ray(nexrad_radial *radial, int azimuth, uint8_t **values) {
+/*
+ * Build a table of the byte offset of the ray covering each tenth of a degree
+ * of azimuth, in a single pass over every ray in the packet.  Rays of either
+ * encoding vary in length, so the offset of each ray can only be known by
+ * way of those preceding it.  Tenths not covered by any ray are left zero,
+ * which is never the offset of a ray.
+ */
+static int _radial_build_index(nexrad_radial *radial) {
+    uint16_t rays = be16toh(radial->packet->rays), r;
+    size_t offset = sizeof(nexrad_radial_packet);
+
+    if ((radial->index = calloc(NEXRAD_RADIAL_AZIMUTH_SLOTS, sizeof(uint32_t))) == NULL) {
+        return -1;
+    }
+
+    for (r=0; r<rays; r++) {
+        nexrad_radial_ray *ray = (nexrad_radial_ray *)((char *)radial->packet + offset);
+        uint16_t start = be16toh(ray->angle_start) % NEXRAD_RADIAL_AZIMUTH_SLOTS,
+                 delta = be16toh(ray->angle_delta), i;
+
+        if (delta == 0) {
+            delta = 1;
+        } else if (delta > NEXRAD_RADIAL_AZIMUTH_SLOTS) {
+            delta = NEXRAD_RADIAL_AZIMUTH_SLOTS;
+        }
+
+        for (i=0; i<delta; i++) {
+            radial->index[(start + i) % NEXRAD_RADIAL_AZIMUTH_SLOTS] = offset;
+        }
+
+        offset += _ray_size(radial->type, ray);
+    }
+
+    return 0;
+}
+
+static nexrad_radial_ray *_radial_ray_by_tenths(nexrad_radial *radial, int tenths, uint8_t **values) {
     nexrad_radial_ray *ray;
-    uint16_t rays, a;
 
+    if (radial->type != NEXRAD_RADIAL_RLE && radial->type != NEXRAD_RADIAL_DIGITAL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (_radial_partial(radial)) {
+        return NULL;
+    }
+
+    if (radial->index == NULL && _radial_build_index(radial) < 0) {
+        return NULL;
+    }
+
+    tenths %= NEXRAD_RADIAL_AZIMUTH_SLOTS;
+
+    if (tenths < 0) tenths += NEXRAD_RADIAL_AZIMUTH_SLOTS;
+
+    if (radial->index[tenths] == 0) {
+        return NULL;
+    }
+
+    ray = (nexrad_radial_ray *)((char *)radial->packet + radial->index[tenths]);
+
+    /*
+     * Digital rangebin values may be referenced in place, whereas run length
+     * encoded rays are expanded into the scratch space of the reader.
+     */
+    if (radial->type == NEXRAD_RADIAL_RLE) {
+        size_t written = rle_expand(radial->values, radial->bins,
+            (uint8_t *)(ray + 1), be16toh(ray->size) * 2);
+
+        memset(radial->values + written, '\0', radial->bins - written);
+
+        if (values)
+            *values = radial->values;
+    } else {
+        if (values)
+            *values = (uint8_t *)ray + sizeof(nexrad_radial_ray);
+    }
+
+    return ray;
+}
+
+nexrad_radial_ray *nexrad_radial_get_ray(nexrad_radial *radial, int azimuth, uint8_t **values) {
     if (radial == NULL) {
         return NULL;
     }
@@ -268,42 +391,325 @@ nexrad_radial_ray *nexrad_radial_get_ray(nexrad_radial *radial, int azimuth, uin
     while (azimuth >= 360) azimuth -= 360;
     while (azimuth <    0) azimuth += 360;
 
-    rays = be16toh(radial->packet->rays);
+    return _radial_ray_by_tenths(radial, azimuth * 10, values);
+}
+
+static int _azimuth_tenths(double azimuth) {
+    azimuth = fmod(azimuth, 360.0);
+
+    if (azimuth < 0) azimuth += 360.0;
 
     /*
-     * Do not allow this operation on RLE-encoded radials.
+     * Allow for azimuths such as 271.3 not being exactly representable, lest
+     * they land in the tenth of a degree prior.
      */
-    if (nexrad_radial_get_type(radial) != NEXRAD_RADIAL_DIGITAL || azimuth >= rays) {
+    return (int)floor(azimuth * 10.0 + 1e-6) % NEXRAD_RADIAL_AZIMUTH_SLOTS;
+}
+
+nexrad_radial_ray *nexrad_radial_find_ray(nexrad_radial *radial, double azimuth, uint8_t **values) {
+    if (radial == NULL || isnan(azimuth) || isinf(azimuth)) {
+        return NULL;
+    }
+
+    return _radial_ray_by_tenths(radial, _azimuth_tenths(azimuth), values);
+}
+
+/*
+ * Visit the offset of each distinct ray covering the `tenths` tenths of a
+ * degree from `start`, in order, stopping short of visiting any ray twice
+ * when the sector spans the full circle.  Returns the number of rays found;
+ * when `offsets` is not NULL, their offsets are written there.
+ */
+static size_t _sector_rays(nexrad_radial *radial, int start, int tenths, uint32_t *offsets) {
+    uint32_t last = 0, head = 0;
+    size_t rows = 0;
+    int t;
+
+    for (t=0; t<tenths; t++) {
+        uint32_t offset = radial->index[(start + t) % NEXRAD_RADIAL_AZIMUTH_SLOTS];
+
+        if (offset == 0 || offset == last) {
+            continue;
+        }
+
+        if (offset == head) {
+            break;
+        }
+
+        if (rows == 0) {
+            head = offset;
+        }
+
+        if (offsets) {
+            offsets[rows] = offset;
+        }
+
+        last = offset;
+        rows++;
+    }
+
+    return rows;
+}
+
+static void _sector_fill_row(nexrad_radial_sector *sector, enum nexrad_radial_type type, nexrad_radial_ray *ray, uint8_t *row) {
+    size_t written = 0;
+
+    if (type == NEXRAD_RADIAL_RLE) {
+        written = rle_expand_range(row, sector->first, sector->gates,
+            (uint8_t *)(ray + 1), be16toh(ray->size) * 2);
+    } else {
+        size_t size = be16toh(ray->size);
+
+        if (size > sector->first) {
+            written = size - sector->first;
+
+            if (written > sector->gates) {
+                written = sector->gates;
+            }
+
+            memcpy(row, (uint8_t *)(ray + 1) + sector->first, written);
+        }
+    }
+
+    memset(row + written, '\0', sector->gates - written);
+}
+
+nexrad_radial_sector *nexrad_radial_read_sector(nexrad_radial *radial, double azimuth, double width, int first, int gates) {
+    nexrad_radial_sector *sector;
+    uint32_t offsets[NEXRAD_RADIAL_AZIMUTH_SLOTS];
+    size_t rows, r;
+    int start, tenths;
+
+    if (radial == NULL || isnan(azimuth) || isinf(azimuth)
+      || !(width > 0.0 && width <= 360.0) || first < 0 || gates < 1) {
+        goto error_invalid;
+    }
+
+    if (radial->type != NEXRAD_RADIAL_RLE && radial->type != NEXRAD_RADIAL_DIGITAL) {
+        goto error_invalid;
+    }
+
+    if (_radial_partial(radial)) {
+        goto error_partial;
+    }
+
+    if (first >= radial->bins) {
+        goto error_invalid;
+    }
+
+    if (gates > radial->bins - first) {
+        gates = radial->bins - first;
+    }
+
+    if (radial->index == NULL && _radial_build_index(radial) < 0) {
+        goto error_build_index;
+    }
+
+    start  = _azimuth_tenths(azimuth);
+    tenths = (int)ceil(width * 10.0 - 1e-6);
+
+    if (tenths > NEXRAD_RADIAL_AZIMUTH_SLOTS) {
+        tenths = NEXRAD_RADIAL_AZIMUTH_SLOTS;
+    }
+
+    rows = _sector_rays(radial, start, tenths, offsets);
+
+    /*
+     * Allocate the sector along with the azimuth of each row and the
+     * rangebin values, so that all may be released with a single free().
+     */
+    if ((sector = malloc(sizeof(*sector) + rows * (sizeof(uint16_t) + gates))) == NULL) {
+        goto error_malloc;
+    }
+
+    sector->rows     = rows;
+    sector->gates    = gates;
+    sector->first    = first;
+    sector->azimuths = (uint16_t *)(sector + 1);
+    sector->values   = (uint8_t *)(sector->azimuths + rows);
+
+    for (r=0; r<rows; r++) {
+        nexrad_radial_ray *ray = (nexrad_radial_ray *)((char *)radial->packet + offsets[r]);
+
+        sector->azimuths[r] = be16toh(ray->angle_start);
+
+        _sector_fill_row(sector, radial->type, ray, sector->values + r * gates);
+    }
+
+    return sector;
+
+error_malloc:
+error_build_index:
+error_partial:
+    return NULL;
+
+error_invalid:
+    errno = EINVAL;
+
+    return NULL;
+}
+
+void nexrad_radial_sector_destroy(nexrad_radial_sector *sector) {
+    free(sector);
+}
+
+static inline size_t _grid_header_size() {
+    return (sizeof(nexrad_radial_grid) + NEXRAD_RADIAL_GRID_ALIGN - 1)
+        & ~(size_t)(NEXRAD_RADIAL_GRID_ALIGN - 1);
+}
+
+/*
+ * Decode a ray into a row of a polar grid, and zero the remainder of the row
+ * through to the start of the next.
+ */
+static void _grid_fill_row(nexrad_radial_grid *grid, enum nexrad_radial_type type, nexrad_radial_ray *ray, uint8_t *row) {
+    size_t written;
+
+    if (type == NEXRAD_RADIAL_RLE) {
+        written = rle_expand(row, grid->bins, (uint8_t *)(ray + 1), be16toh(ray->size) * 2);
+    } else {
+        written = be16toh(ray->size);
+
+        if (written > grid->bins) {
+            written = grid->bins;
+        }
+
+        memcpy(row, ray + 1, written);
+    }
+
+    memset(row + written, '\0', grid->stride - written);
+}
+
+nexrad_radial_grid *nexrad_radial_resample(nexrad_radial *radial, int resolution) {
+    nexrad_radial_grid *grid;
+    uint16_t cover[NEXRAD_RADIAL_AZIMUTH_SLOTS];
+    uint16_t rays, bins, r;
+    size_t offset = sizeof(nexrad_radial_packet),
+           stride, slots, size, i;
+
+    if (radial == NULL || resolution < 1 || resolution > NEXRAD_RADIAL_AZIMUTH_SLOTS
+      || NEXRAD_RADIAL_AZIMUTH_SLOTS % resolution != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (radial->type != NEXRAD_RADIAL_RLE && radial->type != NEXRAD_RADIAL_DIGITAL) {
         errno = EINVAL;
         return NULL;
     }
 
+    if (_radial_partial(radial)) {
+        return NULL;
+    }
+
+    rays   = be16toh(radial->packet->rays);
+    bins   = be16toh(radial->packet->rangebin_count);
+    stride = (bins + NEXRAD_RADIAL_GRID_ALIGN - 1) & ~(size_t)(NEXRAD_RADIAL_GRID_ALIGN - 1);
+    slots  = NEXRAD_RADIAL_AZIMUTH_SLOTS / resolution;
+
     /*
-     * If the ray in the position in memory directly correlating to the current
-     * azimuth is of a different angle than the azimuth, then brute forcedly
-     * locate the correct ray.
+     * Allocate the grid, its rows and its azimuth table all at once, with the
+     * rows following the grid itself at the next 64 byte boundary.
      */
-    ray = _radial_ray_by_index(radial, azimuth);
+    size = _grid_header_size() + rays * stride + slots * sizeof(uint16_t);
+
+    if (posix_memalign((void **)&grid, NEXRAD_RADIAL_GRID_ALIGN, size) != 0) {
+        goto error_memalign;
+    }
+
+    grid->rows       = rays;
+    grid->bins       = bins;
+    grid->first      = be16toh(radial->packet->rangebin_first);
+    grid->resolution = resolution;
+    grid->slots      = slots;
+    grid->stride     = stride;
+    grid->values     = (uint8_t *)grid + _grid_header_size();
+    grid->remap      = (uint16_t *)(grid->values + rays * stride);
 
-    if (azimuth == (int)round(NEXRAD_RADIAL_AZIMUTH_FACTOR * be16toh(ray->angle_start))) {
-        goto found;
+    for (i=0; i<NEXRAD_RADIAL_AZIMUTH_SLOTS; i++) {
+        cover[i] = NEXRAD_RADIAL_GRID_NONE;
     }
 
-    for (a=0; a<rays; a++) {
-        ray = _radial_ray_by_index(radial, a);
+    for (r=0; r<rays; r++) {
+        nexrad_radial_ray *ray = (nexrad_radial_ray *)((char *)radial->packet + offset);
+        uint16_t start = be16toh(ray->angle_start) % NEXRAD_RADIAL_AZIMUTH_SLOTS,
+                 delta = be16toh(ray->angle_delta), j;
 
-        if (azimuth == (int)round(NEXRAD_RADIAL_AZIMUTH_FACTOR * be16toh(ray->angle_start))) {
-            goto found;
+        if (delta == 0) {
+            delta = 1;
+        } else if (delta > NEXRAD_RADIAL_AZIMUTH_SLOTS) {
+            delta = NEXRAD_RADIAL_AZIMUTH_SLOTS;
         }
+
+        _grid_fill_row(grid, radial->type, ray, grid->values + r * stride);
+
+        for (j=0; j<delta; j++) {
+            cover[(start + j) % NEXRAD_RADIAL_AZIMUTH_SLOTS] = r;
+        }
+
+        offset += _ray_size(radial->type, ray);
     }
 
+    /*
+     * Each slot takes the row of the ray covering its middle.
+     */
+    for (i=0; i<slots; i++) {
+        grid->remap[i] = cover[i * resolution + resolution / 2];
+    }
+
+    return grid;
+
+error_memalign:
     return NULL;
+}
 
-found:
-    if (values)
-        *values = (uint8_t *)ray + sizeof(nexrad_radial_ray);
-        
-    return ray;
+nexrad_radial_grid *nexrad_radial_packet_resample(nexrad_radial_packet *packet, int resolution) {
+    nexrad_radial radial;
+    uint8_t values[NEXRAD_RADIAL_MAX_BINS];
+
+    if (packet == NULL) {
+        return NULL;
+    }
+
+    if (nexrad_radial_init(&radial, packet, values) < 0) {
+        return NULL;
+    }
+
+    return nexrad_radial_resample(&radial, resolution);
+}
+
+uint8_t *nexrad_radial_grid_get_row(nexrad_radial_grid *grid, double azimuth) {
+    uint16_t row;
+
+    if (grid == NULL || isnan(azimuth) || isinf(azimuth)) {
+        return NULL;
+    }
+
+    row = grid->remap[_azimuth_tenths(azimuth) / grid->resolution];
+
+    if (row == NEXRAD_RADIAL_GRID_NONE) {
+        return NULL;
+    }
+
+    return grid->values + row * grid->stride;
+}
+
+int nexrad_radial_grid_get_rangebin(nexrad_radial_grid *grid, double azimuth, int range) {
+    uint8_t *row;
+
+    if (grid == NULL || range < 0 || range >= grid->bins) {
+        return -1;
+    }
+
+    if ((row = nexrad_radial_grid_get_row(grid, azimuth)) == NULL) {
+        return -1;
+    }
+
+    return row[range];
+}
+
+void nexrad_radial_grid_destroy(nexrad_radial_grid *grid) {
+    free(grid);
 }
 
 int nexrad_radial_ray_get_azimuth(nexrad_radial_ray *ray) {
@@ -322,7 +728,7 @@ int nexrad_radial_get_rangebin(nexrad_radial *radial, int azimuth, int range) {
         return -1;
     }
 
-    if (range > be16toh(radial->packet->rangebin_count)) {
+    if (range < 0 || range >= be16toh(radial->packet->rangebin_count)) {
         return 0;
     }
 
@@ -340,6 +746,14 @@ error_radial_get_ray:
 }
 
 nexrad_radial_ray *nexrad_radial_read_ray(nexrad_radial *radial, uint8_t **values) {
+    if (radial == NULL || _radial_partial(radial)) {
+        return NULL;
+    }
+
+    return radial_read_ray(radial, values);
+}
+
+nexrad_radial_ray *radial_read_ray(nexrad_radial *radial, uint8_t **values) {
     nexrad_radial_ray *ray;
     size_t size;
 
@@ -351,19 +765,9 @@ nexrad_radial_ray *nexrad_radial_read_ray(nexrad_radial *radial, uint8_t **value
 
     if (radial->type == NEXRAD_RADIAL_RLE) {
         uint16_t count = be16toh(ray->size) * 2;
-        uint16_t bins  = be16toh(radial->packet->rangebin_count);
-
-        nexrad_radial_run *runs = (nexrad_radial_run *)(ray + 1);
 
-        uint16_t r, b;
-
-        for (r=0, b=0; r<count; r++) {
-            uint16_t i;
-
-            for (i=0; i<runs[r].length && b<bins; i++, b++) {
-                radial->values[b] = NEXRAD_RADIAL_RLE_FACTOR * runs[r].level;
-            }
-        }
+        rle_expand(radial->values, be16toh(radial->packet->rangebin_count),
+            (uint8_t *)(ray + 1), count);
 
         size = sizeof(nexrad_radial_ray) + count;
     } else if (radial->type == NEXRAD_RADIAL_DIGITAL) {
@@ -457,7 +861,7 @@ nexrad_image *nexrad_radial_create_image(nexrad_radial *radial, nexrad_color_tab
     size_t width, height, radius;
     uint8_t *data;
 
-    if (radial == NULL || table == NULL) {
+    if (radial == NULL || table == NULL || _radial_partial(radial)) {
         return NULL;
     }
 
@@ -512,7 +916,7 @@ nexrad_image *nexrad_radial_create_projected_image(nexrad_radial *radial, nexrad
     nexrad_geo_projection_point *points;
     uint16_t x, y, width, height, bins;
 
-    if (radial == NULL || table == NULL || proj == NULL) {
+    if (radial == NULL || table == NULL || proj == NULL || _radial_partial(radial)) {
         return NULL;
     }
     
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _RADIAL_INTERNAL_H
+#define _RADIAL_INTERNAL_H
+
+#include <stdint.h>
+
+#include <nexrad/radial.h>
+
+/*
+ * Initialize a caller-owned radial packet reader as nexrad_radial_init()
+ * would, but without validating the packet header, for packets within
+ * messages opened with NEXRAD_MESSAGE_TRUSTED.  Only the radial type, and
+ * the number of rangebins which bounds writes to `values`, are checked.
+ */
+int radial_init_trusted(nexrad_radial *radial,
+    nexrad_radial_packet *packet,
+    uint8_t *values
+);
+
+/*
+ * Read the next ray of a radial packet as nexrad_radial_read_ray() would,
+ * including from readers marked partial, whose caller is responsible for
+ * ensuring the ray has been decompressed in full beforehand.
+ */
+nexrad_radial_ray *radial_read_ray(nexrad_radial *radial, uint8_t **values);
+
+#endif /* _RADIAL_INTERNAL_H */
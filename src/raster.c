@@ -28,13 +28,6 @@
 
 #include <nexrad/raster.h>
 
-struct _nexrad_raster {
-    nexrad_raster_packet * packet;
-    size_t                 bytes_read;
-    uint16_t               lines_left;
-    nexrad_raster_line *   current;
-};
-
 static int _valid_packet(nexrad_raster_packet *packet) {
     if (packet == NULL) {
         return 0;
@@ -71,6 +64,19 @@ static int _valid_packet(nexrad_raster_packet *packet) {
     return 1;
 }
 
+int nexrad_raster_init(nexrad_raster *raster, nexrad_raster_packet *packet) {
+    if (raster == NULL || !_valid_packet(packet)) {
+        return -1;
+    }
+
+    raster->packet     = packet;
+    raster->bytes_read = sizeof(nexrad_raster_packet);
+    raster->lines_left = be16toh(packet->lines);
+    raster->current    = (nexrad_raster_line *)((char *)packet + sizeof(nexrad_raster_packet));
+
+    return 0;
+}
+
 nexrad_raster *nexrad_raster_packet_open(nexrad_raster_packet *packet) {
     nexrad_raster *raster;
 
@@ -82,10 +88,7 @@ nexrad_raster *nexrad_raster_packet_open(nexrad_raster_packet *packet) {
         goto error_malloc;
     }
 
-    raster->packet     = packet;
-    raster->bytes_read = sizeof(nexrad_raster_packet);
-    raster->lines_left = be16toh(packet->lines);
-    raster->current    = (nexrad_raster_line *)((char *)packet + sizeof(nexrad_raster_packet));
+    nexrad_raster_init(raster, packet);
 
     return raster;
 
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <nexrad/radial.h>
+
+#include "rle.h"
+
+/*
+ * Runs are at most 15 bytes long, so a single 16 byte store of the level of
+ * a run covers the run in full.  Any excess is overwritten by the runs which
+ * follow, so such stores are only made while the whole 16 bytes lie within
+ * the decoded length of the ray; the final runs are written exactly.
+ */
+#define RLE_VECTOR_SIZE 16
+
+static inline uint8_t _run_value(uint8_t run) {
+    return NEXRAD_RADIAL_RLE_FACTOR * (run & 0x0f);
+}
+
+static inline size_t _run_length(uint8_t run) {
+    return run >> 4;
+}
+
+#if defined(__SSE2__)
+
+static size_t _decoded_length(const uint8_t *runs, size_t count) {
+    __m128i mask  = _mm_set1_epi8(0x0f),
+            zero  = _mm_setzero_si128(),
+            total = _mm_setzero_si128();
+
+    size_t i = 0, ret;
+
+    for (; i + RLE_VECTOR_SIZE <= count; i += RLE_VECTOR_SIZE) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(runs + i));
+
+        v     = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        total = _mm_add_epi64(total, _mm_sad_epu8(v, zero));
+    }
+
+    ret = _mm_cvtsi128_si32(total) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(total, total));
+
+    for (; i<count; i++) {
+        ret += _run_length(runs[i]);
+    }
+
+    return ret;
+}
+
+static inline void _splat(uint8_t *dest, uint8_t value) {
+    _mm_storeu_si128((__m128i *)dest, _mm_set1_epi8((char)value));
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+static size_t _decoded_length(const uint8_t *runs, size_t count) {
+    size_t i = 0, ret = 0;
+
+    for (; i + RLE_VECTOR_SIZE <= count; i += RLE_VECTOR_SIZE) {
+        ret += vaddlvq_u8(vshrq_n_u8(vld1q_u8(runs + i), 4));
+    }
+
+    for (; i<count; i++) {
+        ret += _run_length(runs[i]);
+    }
+
+    return ret;
+}
+
+static inline void _splat(uint8_t *dest, uint8_t value) {
+    vst1q_u8(dest, vdupq_n_u8(value));
+}
+
+#else
+
+static size_t _decoded_length(const uint8_t *runs, size_t count) {
+    size_t i, ret = 0;
+
+    for (i=0; i<count; i++) {
+        ret += _run_length(runs[i]);
+    }
+
+    return ret;
+}
+
+static inline void _splat(uint8_t *dest, uint8_t value) {
+    memset(dest, value, RLE_VECTOR_SIZE);
+}
+
+#endif
+
+size_t rle_expand(uint8_t *dest, size_t bins, const uint8_t *runs, size_t count) {
+    size_t total = _decoded_length(runs, count),
+           b = 0, r;
+
+    if (total > bins) {
+        total = bins;
+    }
+
+    for (r=0; r<count && b + RLE_VECTOR_SIZE <= total; r++) {
+        _splat(dest + b, _run_value(runs[r]));
+
+        b += _run_length(runs[r]);
+    }
+
+    for (; r<count && b < total; r++) {
+        size_t length = _run_length(runs[r]);
+
+        if (length > total - b) {
+            length = total - b;
+        }
+
+        memset(dest + b, _run_value(runs[r]), length);
+
+        b += length;
+    }
+
+    return total;
+}
+
+size_t rle_expand_range(uint8_t *dest, size_t first, size_t gates, const uint8_t *runs, size_t count) {
+    size_t end = first + gates,
+           b = 0, written = 0, r;
+
+    for (r=0; r<count && b < end; r++) {
+        size_t length = _run_length(runs[r]), from, to;
+
+        if (b + length <= first) {
+            b += length;
+
+            continue;
+        }
+
+        from = b < first? first: b;
+        to   = b + length > end? end: b + length;
+
+        memset(dest + from - first, _run_value(runs[r]), to - from);
+
+        written = to - first;
+        b      += length;
+    }
+
+    return written;
+}
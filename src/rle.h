@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _RLE_H
+#define _RLE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Expand the `count` run length encoded bytes in `runs`, each holding a run
+ * length in its upper nibble and a level in its lower nibble, into `dest`,
+ * scaling each level by NEXRAD_RADIAL_RLE_FACTOR.  No more than `bins` bytes
+ * are written, and nothing is written beyond the end of the final run.
+ * Returns the number of bytes written.
+ */
+size_t rle_expand(uint8_t *dest,
+    size_t bins,
+    const uint8_t *runs,
+    size_t count
+);
+
+/*
+ * Expand only rangebins `first` through `first + gates - 1` of the run length
+ * encoded bytes in `runs` into `dest`, skipping over the runs preceding the
+ * first rangebin, and stopping at the run holding the last.  Returns the
+ * number of bytes written, which is less than `gates` should the runs end
+ * early.
+ */
+size_t rle_expand_range(uint8_t *dest,
+    size_t first,
+    size_t gates,
+    const uint8_t *runs,
+    size_t count
+);
+
+#endif /* _RLE_H */
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include "util.h"
+
+#include <nexrad/header.h>
+#include <nexrad/spool.h>
+
+struct _nexrad_spool {
+    uint8_t * data;
+    size_t    size;
+    size_t    mapped_size;
+    size_t    offset;
+};
+
+static inline int _valid_message_header(nexrad_message_header *header) {
+    size_t size = be32toh(header->size);
+
+    return be16toh(header->blocks) <= 5
+        && size >= sizeof(nexrad_message_header) + sizeof(nexrad_product_description)
+        && size <= NEXRAD_MESSAGE_MAX_SIZE;
+}
+
+/*
+ * Search for the next WMO header signature in the spool at or after the
+ * offset given, and before the limit given, returning its offset, or the limit
+ * if none is found.
+ */
+static size_t _spool_find_signature(nexrad_spool *spool, size_t offset, size_t limit) {
+    size_t len = strlen(NEXRAD_HEADER_WMO_SIGNATURE);
+
+    if (limit > spool->size) {
+        limit = spool->size;
+    }
+
+    while (offset + len <= limit) {
+        uint8_t *found = memchr(spool->data + offset,
+            NEXRAD_HEADER_WMO_SIGNATURE[0], limit - offset - len + 1);
+
+        if (found == NULL) {
+            break;
+        }
+
+        offset = found - spool->data;
+
+        if (memcmp(found, NEXRAD_HEADER_WMO_SIGNATURE, len) == 0) {
+            return offset;
+        }
+
+        offset++;
+    }
+
+    return limit;
+}
+
+/*
+ * Determine whether the WMO header signature at the offset given begins a
+ * valid product message, returning 1 if so, 0 if not, or -1 if the spool ends
+ * before the message header and product description can be examined.
+ */
+static int _spool_valid_at(nexrad_spool *spool, size_t offset) {
+    nexrad_wmo_header *wmo_header = (nexrad_wmo_header *)(spool->data + offset);
+    nexrad_message_header *message_header;
+    nexrad_product_description *description;
+
+    size_t header_offset = offset + sizeof(nexrad_wmo_header);
+
+    if (header_offset + sizeof(nexrad_message_header)
+      + sizeof(nexrad_product_description) > spool->size) {
+        return -1;
+    }
+
+    message_header = (nexrad_message_header *)(spool->data + header_offset);
+    description    = (nexrad_product_description *)nexrad_block_after(message_header, nexrad_message_header);
+
+    return wmo_header->_whitespace1 == ' '
+        && _valid_message_header(message_header)
+        && (int16_t)be16toh(description->divider) == -1;
+}
+
+/*
+ * Determine whether the data at the offset given could follow the end of a
+ * product message: the unknown footer, the unknown header or WMO header of
+ * another message, or the end of the spool.
+ */
+static int _spool_boundary_at(nexrad_spool *spool, size_t offset) {
+    size_t left = spool->size - offset;
+
+    return left == 0
+        || (left >= 4 && memcmp(spool->data + offset, NEXRAD_MESSAGE_UNKNOWN_FOOTER, 4) == 0)
+        || (left >= 4 && memcmp(spool->data + offset, NEXRAD_HEADER_UNKNOWN_SIGNATURE, 4) == 0)
+        || (left >= 4 && memcmp(spool->data + offset, NEXRAD_HEADER_WMO_SIGNATURE, 4) == 0);
+}
+
+/*
+ * Search for a signature beginning a valid product message, or one which may
+ * yet prove to be valid, after the offset given and before the limit given,
+ * returning its offset, or the size of the spool if none is found.
+ */
+static size_t _spool_find_resync(nexrad_spool *spool, size_t offset, size_t limit) {
+    while ((offset = _spool_find_signature(spool, offset + 1, limit)) < limit) {
+        if (_spool_valid_at(spool, offset) != 0) {
+            return offset;
+        }
+    }
+
+    return spool->size;
+}
+
+static nexrad_spool *_spool_create(void *buf, size_t len) {
+    nexrad_spool *spool;
+
+    if ((spool = malloc(sizeof(*spool))) == NULL) {
+        goto error_malloc;
+    }
+
+    spool->data        = buf;
+    spool->size        = len;
+    spool->mapped_size = 0;
+    spool->offset      = 0;
+
+    return spool;
+
+error_malloc:
+    return NULL;
+}
+
+nexrad_spool *nexrad_spool_open_buf(void *buf, size_t len) {
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    return _spool_create(buf, len);
+}
+
+nexrad_spool *nexrad_spool_open(const char *path) {
+    nexrad_spool *spool;
+    struct stat st;
+    void *data;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        goto error_fstat;
+    }
+
+    if (st.st_size == 0) {
+        errno = EINVAL;
+
+        goto error_empty;
+    }
+
+    if ((data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        goto error_mmap;
+    }
+
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    if ((spool = _spool_create(data, st.st_size)) == NULL) {
+        goto error_spool_create;
+    }
+
+    spool->mapped_size = st.st_size;
+
+    close(fd);
+
+    return spool;
+
+error_spool_create:
+    munmap(data, st.st_size);
+
+error_mmap:
+error_empty:
+error_fstat:
+    close(fd);
+
+error_open:
+    return NULL;
+}
+
+void *nexrad_spool_find_message(nexrad_spool *spool, size_t *len) {
+    size_t offset, start;
+
+    if (spool == NULL) {
+        return NULL;
+    }
+
+    offset = spool->offset;
+
+    while ((offset = _spool_find_signature(spool, offset, spool->size)) < spool->size) {
+        nexrad_message_header *message_header;
+
+        size_t header_offset = offset + sizeof(nexrad_wmo_header),
+               end,
+               next;
+
+        int valid;
+
+        start = offset;
+
+        /*
+         * Include the unknown header prepended by LDM and NOAAPort feeds,
+         * when it immediately precedes the WMO header.
+         */
+        if (start >= spool->offset + sizeof(nexrad_unknown_header)
+          && memcmp(spool->data + start - sizeof(nexrad_unknown_header),
+                    NEXRAD_HEADER_UNKNOWN_SIGNATURE, 4) == 0) {
+            start -= sizeof(nexrad_unknown_header);
+        }
+
+        /*
+         * Skip signatures which do not begin a valid message, and stop at one
+         * which is too close to the end of the spool to tell.
+         */
+        if ((valid = _spool_valid_at(spool, offset)) < 0) {
+            goto incomplete;
+        } else if (valid == 0) {
+            offset++;
+
+            continue;
+        }
+
+        message_header = (nexrad_message_header *)(spool->data + header_offset);
+
+        end = header_offset + be32toh(message_header->size);
+
+        /*
+         * A message which runs past the end of the spool, or which is not
+         * followed by anything which could follow a message, may have been
+         * cut short and followed by another message.  Should another valid
+         * message begin within it, skip to that message instead.
+         */
+        if (end > spool->size || !_spool_boundary_at(spool, end)) {
+            next = _spool_find_resync(spool, offset, end);
+
+            if (next < spool->size) {
+                offset = next;
+
+                continue;
+            }
+        }
+
+        if (end > spool->size) {
+            goto incomplete;
+        }
+
+        /*
+         * Likewise, include the unknown footer when it immediately follows
+         * the message.
+         */
+        if (end + 4 <= spool->size
+          && memcmp(spool->data + end, NEXRAD_MESSAGE_UNKNOWN_FOOTER, 4) == 0) {
+            end += 4;
+        }
+
+        spool->offset = end;
+
+        if (len)
+            *len = end - start;
+
+        return spool->data + start;
+    }
+
+    return NULL;
+
+incomplete:
+    /*
+     * Leave the offset at the start of a message truncated by the end of the
+     * spool, so that it may be read in full once the rest of it arrives.
+     */
+    spool->offset = start;
+
+    return NULL;
+}
+
+nexrad_message *nexrad_spool_read_message(nexrad_spool *spool, nexrad_message_ctx *ctx) {
+    void *data;
+    size_t len;
+
+    while ((data = nexrad_spool_find_message(spool, &len)) != NULL) {
+        nexrad_message *message;
+
+        if ((message = nexrad_message_open_buf_ctx(data, len, ctx)) != NULL) {
+            return message;
+        }
+    }
+
+    return NULL;
+}
+
+size_t nexrad_spool_get_offset(nexrad_spool *spool) {
+    if (spool == NULL) {
+        return 0;
+    }
+
+    return spool->offset;
+}
+
+void nexrad_spool_close(nexrad_spool *spool) {
+    if (spool == NULL) {
+        return;
+    }
+
+    if (spool->mapped_size > 0) {
+        munmap(spool->data, spool->mapped_size);
+    }
+
+    spool->data        = NULL;
+    spool->size        = 0;
+    spool->mapped_size = 0;
+    spool->offset      = 0;
+
+    free(spool);
+}
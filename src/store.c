@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "util.h"
+#include "message_internal.h"
+
+#include <nexrad/store.h>
+
+#define STORE_SUFFIX      ".l3"
+#define STORE_NAME_LEN    (16 + sizeof(STORE_SUFFIX) - 1)
+#define STORE_NAME_SIZE   64
+
+/*
+ * The modification time of a transcoded message serves as its time of last
+ * use for the purposes of eviction, and is updated upon reuse no more often
+ * than this many seconds, sparing a write to the directory on every open.
+ */
+#define STORE_TOUCH_INTERVAL 60
+
+struct _nexrad_message_store {
+    int      dirfd;
+    size_t   budget;
+    size_t   bytes;  /* Approximate total size of transcoded messages */
+    unsigned serial; /* Distinguishes temporary files of this process */
+};
+
+struct store_file {
+    char            name[STORE_NAME_LEN + 1];
+    off_t           size;
+    struct timespec mtime;
+};
+
+/*
+ * Name a transcoded message for the original file's identity, rather than its
+ * contents, so that it may be found without reading the original.  Names are
+ * stored on disk, and so the key is laid out in a fixed byte order.  As file
+ * identities may be reused, a copy found under a name is checked against the
+ * original before it is used.
+ */
+static void _store_name(struct stat *st, char *name, size_t len) {
+    struct {
+        uint64_t dev;
+        uint64_t ino;
+        uint64_t size;
+        int64_t  mtime_sec;
+        int64_t  mtime_nsec;
+    } key;
+
+    memset(&key, '\0', sizeof(key));
+
+    key.dev        = htole64(st->st_dev);
+    key.ino        = htole64(st->st_ino);
+    key.size       = htole64(st->st_size);
+    key.mtime_sec  = htole64(st->st_mtim.tv_sec);
+    key.mtime_nsec = htole64(st->st_mtim.tv_nsec);
+
+    snprintf(name, len, "%016" PRIx64 STORE_SUFFIX, hash64_le(&key, sizeof(key)));
+}
+
+static int _store_file_name(const char *name) {
+    size_t len = strlen(name);
+
+    return len == STORE_NAME_LEN
+        && strcmp(name + len - (sizeof(STORE_SUFFIX) - 1), STORE_SUFFIX) == 0;
+}
+
+static int _store_file_compare(const void *a, const void *b) {
+    const struct store_file *fa = a, *fb = b;
+
+    if (fa->mtime.tv_sec != fb->mtime.tv_sec) {
+        return fa->mtime.tv_sec < fb->mtime.tv_sec? -1: 1;
+    }
+
+    if (fa->mtime.tv_nsec != fb->mtime.tv_nsec) {
+        return fa->mtime.tv_nsec < fb->mtime.tv_nsec? -1: 1;
+    }
+
+    return 0;
+}
+
+nexrad_message_store *nexrad_message_store_open(const char *dir, size_t budget) {
+    nexrad_message_store *store;
+
+    if (dir == NULL) {
+        errno = EINVAL;
+
+        goto error_invalid;
+    }
+
+    if ((store = malloc(sizeof(*store))) == NULL) {
+        goto error_malloc;
+    }
+
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        goto error_mkdir;
+    }
+
+    if ((store->dirfd = open(dir, O_RDONLY | O_DIRECTORY)) < 0) {
+        goto error_open;
+    }
+
+    store->budget = budget;
+    store->bytes  = 0;
+    store->serial = 0;
+
+    /*
+     * Take stock of the transcoded messages already present, and remove any
+     * in excess of the budget given.
+     */
+    if (nexrad_message_store_evict(store) < 0) {
+        goto error_evict;
+    }
+
+    return store;
+
+error_evict:
+    close(store->dirfd);
+
+error_open:
+error_mkdir:
+    free(store);
+
+error_malloc:
+error_invalid:
+    return NULL;
+}
+
+ssize_t nexrad_message_store_evict(nexrad_message_store *store) {
+    struct store_file *files = NULL;
+    struct dirent *entry;
+    size_t count = 0, size = 0, total = 0, i;
+    ssize_t removed = 0;
+    DIR *dir;
+    int fd;
+
+    if (store == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    if ((fd = dup(store->dirfd)) < 0) {
+        goto error_dup;
+    }
+
+    if ((dir = fdopendir(fd)) == NULL) {
+        close(fd);
+
+        goto error_opendir;
+    }
+
+    rewinddir(dir);
+
+    while ((entry = readdir(dir)) != NULL) {
+        struct stat st;
+
+        if (!_store_file_name(entry->d_name)) {
+            continue;
+        }
+
+        if (fstatat(store->dirfd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        if (count == size) {
+            struct store_file *tmp;
+
+            size = size? size * 2: 64;
+
+            if ((tmp = realloc(files, size * sizeof(*files))) == NULL) {
+                goto error_realloc;
+            }
+
+            files = tmp;
+        }
+
+        memcpy(files[count].name, entry->d_name, STORE_NAME_LEN + 1);
+
+        files[count].size  = st.st_size;
+        files[count].mtime = st.st_mtim;
+
+        total += st.st_size;
+        count++;
+    }
+
+    closedir(dir);
+
+    /*
+     * Once over budget, evict down to somewhat less than the budget, so that
+     * the store is not scanned again upon every message subsequently added.
+     */
+    if (total > store->budget) {
+        size_t target = store->budget - store->budget / 8;
+
+        qsort(files, count, sizeof(*files), _store_file_compare);
+
+        for (i=0; i<count && total > target; i++) {
+            if (unlinkat(store->dirfd, files[i].name, 0) < 0 && errno != ENOENT) {
+                continue;
+            }
+
+            total -= files[i].size;
+            removed++;
+        }
+    }
+
+    free(files);
+
+    store->bytes = total;
+
+    return removed;
+
+error_realloc:
+    free(files);
+    closedir(dir);
+
+error_opendir:
+error_dup:
+    return -1;
+}
+
+static int _message_compressed(nexrad_message *message) {
+    nexrad_product_description *description = nexrad_message_get_product_description(message);
+
+    return nexrad_product_type_supports_compression(be16toh(description->type))
+        && be16toh(description->attributes.compression.method) != NEXRAD_PRODUCT_COMPRESSION_NONE;
+}
+
+/*
+ * Write a transcoded copy of a message to a temporary file within the store,
+ * and rename it into place once complete, so that concurrent readers never
+ * see a partially written message.  The temporary file is named uniquely to
+ * this process and call, and created exclusively, so that writers of the
+ * same message, in this process or any other, never share one.
+ */
+static int _store_write(nexrad_message_store *store, nexrad_message *message, const char *name) {
+    char tmp[STORE_NAME_SIZE];
+    ssize_t size;
+    int fd;
+
+    snprintf(tmp, sizeof(tmp), "%.*s.%d.%u.tmp", (int)STORE_NAME_LEN, name,
+        (int)getpid(), __sync_fetch_and_add(&store->serial, 1));
+
+    if ((fd = openat(store->dirfd, tmp, O_WRONLY | O_CREAT | O_EXCL, 0644)) < 0) {
+        goto error_open;
+    }
+
+    if ((size = message_write_decoded(message, fd)) < 0) {
+        goto error_write;
+    }
+
+    if (close(fd) < 0) {
+        goto error_close;
+    }
+
+    if (renameat(store->dirfd, tmp, store->dirfd, name) < 0) {
+        goto error_rename;
+    }
+
+    if (__sync_add_and_fetch(&store->bytes, size) > store->budget) {
+        nexrad_message_store_evict(store);
+    }
+
+    return 0;
+
+error_write:
+    close(fd);
+
+error_close:
+error_rename:
+    unlinkat(store->dirfd, tmp, 0);
+
+error_open:
+    return -1;
+}
+
+static void _store_touch(nexrad_message_store *store, const char *name) {
+    struct stat st;
+
+    if (fstatat(store->dirfd, name, &st, 0) < 0) {
+        return;
+    }
+
+    if (st.st_mtime + STORE_TOUCH_INTERVAL < time(NULL)) {
+        utimensat(store->dirfd, name, NULL, 0);
+    }
+}
+
+/*
+ * Open the transcoded copy of the message in the original file given, failing
+ * with `errno` set to EINVAL should it turn out to be a copy of some other
+ * message, judging by its station, product, sequence number and time of
+ * generation.
+ */
+static nexrad_message *_store_open_copy(nexrad_message_store *store, int fd, const char *name, nexrad_message_ctx *ctx) {
+    nexrad_message_info original, copy;
+    nexrad_message *message;
+    int copyfd, err;
+
+    if ((copyfd = openat(store->dirfd, name, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (nexrad_message_peek_fd(copyfd, &copy) < 0) {
+        goto error_peek;
+    }
+
+    if (nexrad_message_peek_fd(fd, &original) < 0) {
+        goto error_peek;
+    }
+
+    if (strcmp(copy.station, original.station) != 0
+      || strcmp(copy.product_code, original.product_code) != 0
+      || copy.seq != original.seq
+      || copy.gen_timestamp != original.gen_timestamp) {
+        errno = EINVAL;
+
+        goto error_mismatch;
+    }
+
+    if ((message = nexrad_message_open_fd_ctx(copyfd, ctx)) == NULL) {
+        goto error_message_open;
+    }
+
+    close(copyfd);
+
+    return message;
+
+error_message_open:
+error_mismatch:
+error_peek:
+    err = errno;
+
+    close(copyfd);
+
+    errno = err;
+
+error_open:
+    return NULL;
+}
+
+/*
+ * Open the transcoded copy of a message, or failing that, the original, which
+ * is then added to the store.  `*addedp` is set to 1 if a transcoded copy was
+ * added to the store.
+ */
+static nexrad_message *_store_open(nexrad_message_store *store, const char *path, nexrad_message_ctx *ctx, int *addedp) {
+    nexrad_message *message;
+    char name[STORE_NAME_SIZE];
+    struct stat st;
+    int fd;
+
+    *addedp = 0;
+
+    if (store == NULL || path == NULL) {
+        errno = EINVAL;
+
+        goto error_invalid;
+    }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        goto error_fstat;
+    }
+
+    _store_name(&st, name, sizeof(name));
+
+    if ((message = _store_open_copy(store, fd, name, ctx)) != NULL) {
+        close(fd);
+
+        _store_touch(store, name);
+
+        return message;
+    }
+
+    /*
+     * A transcoded copy which is invalid, or a copy of some other message, is
+     * of no use, and is replaced by a new one; one which could not be opened
+     * for any other reason, such as running short of descriptors or memory,
+     * may well be fine, and is left alone.
+     */
+    if (errno == EINVAL) {
+        unlinkat(store->dirfd, name, 0);
+    }
+
+    if ((message = nexrad_message_open_fd_ctx(fd, ctx)) == NULL) {
+        goto error_message_open;
+    }
+
+    close(fd);
+
+    if (_message_compressed(message) && _store_write(store, message, name) == 0) {
+        *addedp = 1;
+    }
+
+    return message;
+
+error_message_open:
+error_fstat:
+    close(fd);
+
+error_open:
+error_invalid:
+    return NULL;
+}
+
+nexrad_message *nexrad_message_store_open_message(nexrad_message_store *store, const char *path, nexrad_message_ctx *ctx) {
+    int added;
+
+    return _store_open(store, path, ctx, &added);
+}
+
+int nexrad_message_store_add(nexrad_message_store *store, const char *path, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+    int added;
+
+    if ((message = _store_open(store, path, ctx, &added)) == NULL) {
+        return -1;
+    }
+
+    nexrad_message_destroy(message);
+
+    return added;
+}
+
+void nexrad_message_store_close(nexrad_message_store *store) {
+    if (store == NULL) {
+        return;
+    }
+
+    close(store->dirfd);
+
+    memset(store, '\0', sizeof(*store));
+
+    free(store);
+}
@@ -29,10 +29,18 @@ nexrad_chunk *nexrad_symbology_block_open(nexrad_symbology_block *block) {
     return nexrad_chunk_open(block, NEXRAD_CHUNK_SYMBOLOGY_BLOCK);
 }
 
+int nexrad_symbology_block_init(nexrad_chunk *iterator, nexrad_symbology_block *block) {
+    return nexrad_chunk_init(iterator, block, NEXRAD_CHUNK_SYMBOLOGY_BLOCK);
+}
+
 nexrad_chunk *nexrad_symbology_block_read_layer(nexrad_chunk *block) {
     return nexrad_chunk_read_block_layer(block, NEXRAD_CHUNK_SYMBOLOGY_LAYER);
 }
 
+int nexrad_symbology_block_read_layer_init(nexrad_chunk *block, nexrad_chunk *layer) {
+    return nexrad_chunk_read_block_layer_init(block, layer, NEXRAD_CHUNK_SYMBOLOGY_LAYER);
+}
+
 void nexrad_symbology_layer_next_packet(nexrad_chunk *layer, size_t size) {
     nexrad_chunk_next(layer, size);
 }
@@ -26,6 +26,18 @@
 
 #include <nexrad/tabular.h>
 
+int nexrad_tabular_block_init(nexrad_tabular_text *text, nexrad_tabular_block *block) {
+    if (text == NULL || block == NULL) return -1;
+
+    text->current    = (char *)block + sizeof(nexrad_tabular_block);
+    text->page       = 1;
+    text->line       = 1;
+    text->pages_left = be16toh(block->pages);
+    text->bytes_left = be32toh(block->header.size);
+
+    return 0;
+}
+
 nexrad_tabular_text *nexrad_tabular_block_open(nexrad_tabular_block *block) {
     nexrad_tabular_text *text;
 
@@ -35,11 +47,7 @@ nexrad_tabular_text *nexrad_tabular_block_open(nexrad_tabular_block *block) {
         goto error_malloc;
     }
 
-    text->current    = (char *)block + sizeof(nexrad_tabular_block);
-    text->page       = 1;
-    text->line       = 1;
-    text->pages_left = be16toh(block->pages);
-    text->bytes_left = be32toh(block->header.size);
+    nexrad_tabular_block_init(text, block);
 
     return text;
 
@@ -45,3 +45,59 @@ int safecpy(char *dest, char *src, size_t destlen, size_t srclen) {
 
     return 0;
 }
+
+#define HASH64_PRIME1 0x87c37b91114253d5ULL
+#define HASH64_PRIME2 0x4cf5ad432745937fULL
+
+static inline uint64_t _rotl64(uint64_t v, int bits) {
+    return (v << bits) | (v >> (64 - bits));
+}
+
+static inline uint64_t _fmix64(uint64_t v) {
+    v ^= v >> 33;
+    v *= 0xff51afd7ed558ccdULL;
+    v ^= v >> 33;
+    v *= 0xc4ceb9fe1a85ec53ULL;
+    v ^= v >> 33;
+
+    return v;
+}
+
+static inline uint64_t _load64le(const uint8_t *p) {
+    return (uint64_t)p[0]       | (uint64_t)p[1] << 8
+         | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24
+         | (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40
+         | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+static inline uint64_t _hash64(const uint8_t *p, size_t len, int le) {
+    uint64_t h = len * HASH64_PRIME2, v;
+    size_t i;
+
+    for (i=0; i+8<=len; i+=8) {
+        if (le) {
+            v = _load64le(p + i);
+        } else {
+            memcpy(&v, p + i, sizeof(v));
+        }
+
+        h ^= _rotl64(v * HASH64_PRIME1, 31) * HASH64_PRIME2;
+        h  = _rotl64(h, 27) * 5 + 0x52dce729;
+    }
+
+    for (v=0; i<len; i++) {
+        v = (v << 8) | p[i];
+    }
+
+    h ^= _rotl64(v * HASH64_PRIME1, 31) * HASH64_PRIME2;
+
+    return _fmix64(h);
+}
+
+uint64_t hash64(const void *buf, size_t len) {
+    return _hash64(buf, len, 0);
+}
+
+uint64_t hash64_le(const void *buf, size_t len) {
+    return _hash64(buf, len, 1);
+}
@@ -24,6 +24,7 @@
 #ifndef _UTIL_H
 #define _UTIL_H
 
+#include <stdint.h>
 #include <sys/types.h>
 #include "config.h"
 
@@ -65,4 +66,18 @@
 
 int safecpy(char *dest, char *src, size_t destlen, size_t srclen);
 
+/*
+ * Compute a 64-bit hash of the contents of `buf`, suitable for identifying
+ * identical data within a single process; hash values depend upon host byte
+ * order, and are not meant to be stored.
+ */
+uint64_t hash64(const void *buf, size_t len);
+
+/*
+ * Compute the same hash as hash64() would on a little-endian host, regardless
+ * of host byte order, such that hash values may be stored.  Multibyte fields
+ * within `buf` must themselves be laid out in little-endian byte order.
+ */
+uint64_t hash64_le(const void *buf, size_t len);
+
 #endif /* _UTIL_H */
@@ -0,0 +1,748 @@
+/*
+ * Copyright (c) 2016 Dynamic Weather Solutions, Inc. Distributed under the
+ * terms of the MIT license.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <zlib.h>
+#include <bzlib.h>
+#include "message_internal.h"
+
+#include <nexrad/wrapped.h>
+
+#define WRAPPED_INPUT_SIZE   65536
+#define WRAPPED_INITIAL_SIZE 262144
+
+#define TAR_BLOCK_SIZE    512
+#define TAR_NAME_MAX      1024
+#define TAR_SIZE_OFFSET   124
+#define TAR_SIZE_LEN       12
+#define TAR_CHKSUM_OFFSET 148
+#define TAR_CHKSUM_LEN      8
+#define TAR_TYPE_OFFSET   156
+#define TAR_MAGIC_OFFSET  257
+#define TAR_PREFIX_OFFSET 345
+#define TAR_PREFIX_LEN    155
+#define TAR_NAME_LEN      100
+
+enum wrapped_type {
+    WRAPPED_NONE,
+    WRAPPED_GZIP,
+    WRAPPED_BZIP2
+};
+
+/*
+ * A sequential reader of data which may be gzip or bzip2 compressed, read
+ * either from a file descriptor, or from memory.
+ */
+struct wrapped_stream {
+    int fd; /* File descriptor, or -1 when reading from memory */
+
+    uint8_t * in;  /* Input not yet consumed */
+    size_t    len; /* Size of input in buffer */
+    size_t    pos; /* Offset of next unconsumed input byte */
+    uint8_t * buf; /* Input buffer, when reading from a file descriptor */
+    int       eof; /* Set when no more input is to be had */
+
+    enum wrapped_type type;
+
+    z_stream  z;
+    bz_stream bz;
+    int       end; /* Set at the end of each compressed stream */
+};
+
+struct _nexrad_message_tar {
+    struct wrapped_stream stream;
+    nexrad_message_ctx *  ctx;
+
+    char name[TAR_NAME_MAX + 1];
+    char longname[TAR_NAME_MAX + 1]; /* GNU long name for next member */
+};
+
+static enum wrapped_type _wrapped_type(const uint8_t *buf, size_t len) {
+    if (len >= 2 && buf[0] == 0x1f && buf[1] == 0x8b) {
+        return WRAPPED_GZIP;
+    }
+
+    if (len >= 4 && memcmp(buf, "BZh", 3) == 0 && buf[3] >= '1' && buf[3] <= '9') {
+        return WRAPPED_BZIP2;
+    }
+
+    return WRAPPED_NONE;
+}
+
+static int _decoder_init(struct wrapped_stream *stream) {
+    switch (stream->type) {
+        case WRAPPED_GZIP: {
+            memset(&stream->z, '\0', sizeof(stream->z));
+
+            return inflateInit2(&stream->z, 15 + 16) == Z_OK? 0: -1;
+        }
+
+        case WRAPPED_BZIP2: {
+            memset(&stream->bz, '\0', sizeof(stream->bz));
+
+            return BZ2_bzDecompressInit(&stream->bz, 0, 0) == BZ_OK? 0: -1;
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static void _decoder_end(struct wrapped_stream *stream) {
+    switch (stream->type) {
+        case WRAPPED_GZIP:  inflateEnd(&stream->z);           break;
+        case WRAPPED_BZIP2: BZ2_bzDecompressEnd(&stream->bz); break;
+
+        default: {
+            break;
+        }
+    }
+}
+
+static int _stream_fill(struct wrapped_stream *stream) {
+    ssize_t len;
+
+    if (stream->pos < stream->len || stream->eof) {
+        return 0;
+    }
+
+    if (stream->fd < 0) {
+        stream->eof = 1;
+
+        return 0;
+    }
+
+    while ((len = read(stream->fd, stream->buf, WRAPPED_INPUT_SIZE)) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+
+    stream->in  = stream->buf;
+    stream->len = len;
+    stream->pos = 0;
+    stream->eof = len == 0;
+
+    return 0;
+}
+
+/*
+ * Prepare a stream to read the data at `buf` if not NULL, or otherwise from
+ * `fd`, determining whether it is compressed from its first bytes.
+ */
+static int _stream_init(struct wrapped_stream *stream, int fd, void *buf, size_t len) {
+    memset(stream, '\0', sizeof(*stream));
+
+    stream->fd = buf? -1: fd;
+
+    if (buf) {
+        stream->in  = buf;
+        stream->len = len;
+    } else {
+        if ((stream->buf = malloc(WRAPPED_INPUT_SIZE)) == NULL) {
+            goto error_malloc;
+        }
+
+        if (_stream_fill(stream) < 0) {
+            goto error_fill;
+        }
+    }
+
+    stream->type = _wrapped_type(stream->in, stream->len);
+
+    if (_decoder_init(stream) < 0) {
+        goto error_decoder_init;
+    }
+
+    return 0;
+
+error_decoder_init:
+error_fill:
+    free(stream->buf);
+
+error_malloc:
+    return -1;
+}
+
+static void _stream_cleanup(struct wrapped_stream *stream) {
+    _decoder_end(stream);
+
+    free(stream->buf);
+
+    stream->buf = NULL;
+}
+
+/*
+ * Decompress as much of the input at hand as will fit in `len` bytes at
+ * `dest`, writing the number of bytes consumed and produced.
+ */
+static int _stream_decode(struct wrapped_stream *stream, void *dest, size_t len, size_t *consumed, size_t *produced) {
+    size_t avail = stream->len - stream->pos;
+    int ret;
+
+    if (stream->type == WRAPPED_GZIP) {
+        stream->z.next_in   = stream->in + stream->pos;
+        stream->z.avail_in  = avail;
+        stream->z.next_out  = dest;
+        stream->z.avail_out = len;
+
+        ret = inflate(&stream->z, Z_NO_FLUSH);
+
+        *consumed = avail - stream->z.avail_in;
+        *produced = len   - stream->z.avail_out;
+
+        if (ret == Z_STREAM_END) {
+            stream->end = 1;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            return -1;
+        }
+    } else {
+        stream->bz.next_in   = (char *)stream->in + stream->pos;
+        stream->bz.avail_in  = avail;
+        stream->bz.next_out  = dest;
+        stream->bz.avail_out = len;
+
+        ret = BZ2_bzDecompress(&stream->bz);
+
+        *consumed = avail - stream->bz.avail_in;
+        *produced = len   - stream->bz.avail_out;
+
+        if (ret == BZ_STREAM_END) {
+            stream->end = 1;
+        } else if (ret != BZ_OK) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Read up to `len` bytes from a stream, returning fewer only at the end of
+ * input, or -1 on failure.  Concatenated compressed streams, as produced by
+ * some tools, are read as one.
+ */
+static ssize_t _stream_read(struct wrapped_stream *stream, void *dest, size_t len) {
+    size_t done = 0;
+
+    while (done < len) {
+        size_t avail, consumed, produced;
+
+        if (_stream_fill(stream) < 0) {
+            return -1;
+        }
+
+        avail = stream->len - stream->pos;
+
+        if (stream->type == WRAPPED_NONE) {
+            if (avail == 0) {
+                break;
+            }
+
+            consumed = produced = avail < len - done? avail: len - done;
+
+            memcpy((char *)dest + done, stream->in + stream->pos, produced);
+        } else {
+            if (stream->end) {
+                if (avail == 0 || _wrapped_type(stream->in + stream->pos, avail) != stream->type) {
+                    break;
+                }
+
+                _decoder_end(stream);
+
+                stream->end = 0;
+
+                if (_decoder_init(stream) < 0) {
+                    return -1;
+                }
+            }
+
+            if (_stream_decode(stream, (char *)dest + done, len - done, &consumed, &produced) < 0) {
+                errno = EINVAL;
+
+                return -1;
+            }
+
+            /*
+             * Should the decompressor make no progress when out of input,
+             * then the compressed stream is truncated.
+             */
+            if (consumed == 0 && produced == 0 && !stream->end && (avail > 0 || stream->eof)) {
+                errno = EINVAL;
+
+                return -1;
+            }
+        }
+
+        stream->pos += consumed;
+        done        += produced;
+    }
+
+    return done;
+}
+
+static int _stream_skip(struct wrapped_stream *stream, size_t len) {
+    char scratch[4096];
+
+    while (len > 0) {
+        size_t chunk = len < sizeof(scratch)? len: sizeof(scratch);
+        ssize_t ret;
+
+        if ((ret = _stream_read(stream, scratch, chunk)) < 0) {
+            return -1;
+        }
+
+        if (ret < chunk) {
+            errno = EINVAL;
+
+            return -1;
+        }
+
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/*
+ * Read the remainder of a stream into a buffer lent by `ctx`, grown as
+ * needed, followed by zeroed slack as for messages read from files.
+ */
+static void *_stream_read_all(struct wrapped_stream *stream, nexrad_message_ctx *ctx, size_t *sizep, size_t *capp) {
+    size_t size = 0, cap;
+    void *data;
+
+    if ((data = message_ctx_data_take(ctx, WRAPPED_INITIAL_SIZE, &cap)) == NULL) {
+        goto error_data_take;
+    }
+
+    for (;;) {
+        size_t want = cap - MESSAGE_READ_SLACK - size, newcap;
+        ssize_t len;
+        void *tmp;
+
+        if ((len = _stream_read(stream, (char *)data + size, want)) < 0) {
+            goto error_stream_read;
+        }
+
+        size += len;
+
+        if (len < want) {
+            break;
+        }
+
+        if (cap >= NEXRAD_MESSAGE_MAX_SIZE + MESSAGE_READ_SLACK) {
+            errno = EFBIG;
+
+            goto error_stream_read;
+        }
+
+        newcap = cap * 2 > NEXRAD_MESSAGE_MAX_SIZE + MESSAGE_READ_SLACK?
+            NEXRAD_MESSAGE_MAX_SIZE + MESSAGE_READ_SLACK: cap * 2;
+
+        /*
+         * Only record the new capacity once the buffer has actually grown,
+         * as it is returned to the context with its capacity upon failure.
+         */
+        if ((tmp = realloc(data, newcap)) == NULL) {
+            goto error_stream_read;
+        }
+
+        data = tmp;
+        cap  = newcap;
+    }
+
+    memset((char *)data + size, '\0', MESSAGE_READ_SLACK);
+
+    *sizep = size;
+    *capp  = cap;
+
+    return data;
+
+error_stream_read:
+    message_ctx_data_give(ctx, data, cap);
+
+error_data_take:
+    return NULL;
+}
+
+/*
+ * Open a message from a buffer lent by `ctx`, returning the buffer to `ctx`
+ * should the message prove invalid.
+ */
+static nexrad_message *_wrapped_message(void *data, size_t size, size_t cap, nexrad_message_ctx *ctx) {
+    nexrad_message *message;
+
+    if (size < MESSAGE_MIN_SIZE || (message = message_open_decoded(data, size, NULL, 0, 0, ctx)) == NULL) {
+        message_ctx_data_give(ctx, data, cap);
+
+        errno = EINVAL;
+
+        return NULL;
+    }
+
+    return message;
+}
+
+nexrad_message *nexrad_message_open_wrapped_ctx(const char *path, nexrad_message_ctx *ctx) {
+    struct wrapped_stream stream;
+    nexrad_message *message;
+    size_t size, cap;
+    void *data;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (_stream_init(&stream, fd, NULL, 0) < 0) {
+        goto error_stream_init;
+    }
+
+    /*
+     * Files which are not compressed are opened as usual, which is free to
+     * map the file rather than read it, as the file is read by offset.
+     */
+    if (stream.type == WRAPPED_NONE) {
+        _stream_cleanup(&stream);
+
+        message = nexrad_message_open_fd_ctx(fd, ctx);
+
+        close(fd);
+
+        return message;
+    }
+
+    if ((data = _stream_read_all(&stream, ctx, &size, &cap)) == NULL) {
+        goto error_stream_read_all;
+    }
+
+    _stream_cleanup(&stream);
+
+    close(fd);
+
+    return _wrapped_message(data, size, cap, ctx);
+
+error_stream_read_all:
+    _stream_cleanup(&stream);
+
+error_stream_init:
+    close(fd);
+
+error_open:
+    return NULL;
+}
+
+nexrad_message *nexrad_message_open_wrapped(const char *path) {
+    return nexrad_message_open_wrapped_ctx(path, NULL);
+}
+
+nexrad_message_tar *nexrad_message_tar_open(const char *path, nexrad_message_ctx *ctx) {
+    nexrad_message_tar *tar;
+    int fd;
+
+    if ((tar = calloc(1, sizeof(*tar))) == NULL) {
+        goto error_calloc;
+    }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        goto error_open;
+    }
+
+    if (_stream_init(&tar->stream, fd, NULL, 0) < 0) {
+        goto error_stream_init;
+    }
+
+    tar->ctx = ctx;
+
+    return tar;
+
+error_stream_init:
+    close(fd);
+
+error_open:
+    free(tar);
+
+error_calloc:
+    return NULL;
+}
+
+static uint64_t _tar_number(const uint8_t *field, size_t len) {
+    uint64_t value = 0;
+    size_t i = 0;
+
+    /*
+     * GNU tar stores values too large for octal fields in base-256, marked by
+     * the high bit of the first byte.
+     */
+    if (field[0] & 0x80) {
+        value = field[0] & 0x7f;
+
+        for (i=1; i<len; i++) {
+            value = (value << 8) | field[i];
+        }
+
+        return value;
+    }
+
+    while (i < len && field[i] == ' ') {
+        i++;
+    }
+
+    for (; i<len && field[i] >= '0' && field[i] <= '7'; i++) {
+        value = (value << 3) | (field[i] - '0');
+    }
+
+    return value;
+}
+
+static int _tar_header_valid(const uint8_t *header) {
+    uint64_t sum = 0;
+    size_t i;
+
+    for (i=0; i<TAR_BLOCK_SIZE; i++) {
+        if (i >= TAR_CHKSUM_OFFSET && i < TAR_CHKSUM_OFFSET + TAR_CHKSUM_LEN) {
+            sum += ' ';
+        } else {
+            sum += header[i];
+        }
+    }
+
+    return sum == _tar_number(header + TAR_CHKSUM_OFFSET, TAR_CHKSUM_LEN);
+}
+
+static int _tar_header_empty(const uint8_t *header) {
+    size_t i;
+
+    for (i=0; i<TAR_BLOCK_SIZE; i++) {
+        if (header[i] != '\0') {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void _tar_member_name(nexrad_message_tar *tar, const uint8_t *header) {
+    const char *name   = (const char *)header,
+               *prefix = (const char *)header + TAR_PREFIX_OFFSET;
+
+    if (tar->longname[0] != '\0') {
+        memcpy(tar->name, tar->longname, sizeof(tar->name));
+    } else if (memcmp(header + TAR_MAGIC_OFFSET, "ustar", 5) == 0 && prefix[0] != '\0') {
+        snprintf(tar->name, sizeof(tar->name), "%.*s/%.*s",
+            (int)strnlen(prefix, TAR_PREFIX_LEN), prefix,
+            (int)strnlen(name, TAR_NAME_LEN), name);
+    } else {
+        snprintf(tar->name, sizeof(tar->name), "%.*s",
+            (int)strnlen(name, TAR_NAME_LEN), name);
+    }
+
+    tar->longname[0] = '\0';
+}
+
+/*
+ * Read a member of `size` bytes, unwrapping it should it be compressed.
+ * Returns 1 with the contents of the member written to `datap`, 0 if the
+ * member was read but could not be unwrapped, or -1 on failure.
+ */
+static int _tar_read_member(nexrad_message_tar *tar, size_t size, void **datap, size_t *sizep, size_t *capp) {
+    struct wrapped_stream member;
+    size_t cap;
+    ssize_t len;
+    void *data;
+
+    if ((data = message_ctx_data_take(tar->ctx, size + MESSAGE_READ_SLACK, &cap)) == NULL) {
+        goto error_data_take;
+    }
+
+    if ((len = _stream_read(&tar->stream, data, size)) < 0) {
+        goto error_stream_read;
+    }
+
+    if (len < size) {
+        errno = EINVAL;
+
+        goto error_stream_read;
+    }
+
+    if (_wrapped_type(data, size) == WRAPPED_NONE) {
+        memset((char *)data + size, '\0', MESSAGE_READ_SLACK);
+
+        *datap = data;
+        *sizep = size;
+        *capp  = cap;
+
+        return 1;
+    }
+
+    if (_stream_init(&member, -1, data, size) < 0) {
+        goto error_stream_read;
+    }
+
+    *datap = _stream_read_all(&member, tar->ctx, sizep, capp);
+
+    _stream_cleanup(&member);
+
+    message_ctx_data_give(tar->ctx, data, cap);
+
+    return *datap? 1: 0;
+
+error_stream_read:
+    message_ctx_data_give(tar->ctx, data, cap);
+
+error_data_take:
+    return -1;
+}
+
+int nexrad_message_tar_read(nexrad_message_tar *tar, nexrad_message **message, const char **name) {
+    uint8_t header[TAR_BLOCK_SIZE];
+
+    if (tar == NULL || message == NULL) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    for (;;) {
+        uint64_t size, padding;
+        ssize_t len;
+        size_t data_size, cap;
+        void *data;
+        int type, ret;
+
+        if ((len = _stream_read(&tar->stream, header, TAR_BLOCK_SIZE)) < 0) {
+            return -1;
+        }
+
+        /*
+         * A tar file ends with zeroed blocks, though a missing end marker is
+         * tolerated.
+         */
+        if (len == 0 || (len == TAR_BLOCK_SIZE && _tar_header_empty(header))) {
+            return 0;
+        }
+
+        if (len < TAR_BLOCK_SIZE || !_tar_header_valid(header)) {
+            errno = EINVAL;
+
+            return -1;
+        }
+
+        size    = _tar_number(header + TAR_SIZE_OFFSET, TAR_SIZE_LEN);
+        padding = (TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+        type    = header[TAR_TYPE_OFFSET];
+
+        /*
+         * A GNU long name member holds the name of the member to follow.
+         */
+        if (type == 'L') {
+            size_t keep = size < TAR_NAME_MAX? size: TAR_NAME_MAX;
+
+            if (_stream_read(&tar->stream, tar->longname, keep) < (ssize_t)keep) {
+                goto error_truncated;
+            }
+
+            tar->longname[keep] = '\0';
+
+            if (_stream_skip(&tar->stream, size - keep + padding) < 0) {
+                return -1;
+            }
+
+            continue;
+        }
+
+        /*
+         * Skip members other than regular files, and files which could not
+         * possibly hold a message.
+         */
+        if ((type != '0' && type != '\0') || size < MESSAGE_MIN_SIZE || size > NEXRAD_MESSAGE_MAX_SIZE) {
+            tar->longname[0] = '\0';
+
+            if (_stream_skip(&tar->stream, size + padding) < 0) {
+                return -1;
+            }
+
+            continue;
+        }
+
+        _tar_member_name(tar, header);
+
+        if ((ret = _tar_read_member(tar, size, &data, &data_size, &cap)) < 0) {
+            return -1;
+        }
+
+        if (_stream_skip(&tar->stream, padding) < 0) {
+            if (ret) {
+                message_ctx_data_give(tar->ctx, data, cap);
+            }
+
+            return -1;
+        }
+
+        /*
+         * Members which fail to decompress are skipped.
+         */
+        if (ret == 0) {
+            continue;
+        }
+
+        if ((*message = _wrapped_message(data, data_size, cap, tar->ctx)) == NULL) {
+            continue;
+        }
+
+        if (name) {
+            *name = tar->name;
+        }
+
+        return 1;
+    }
+
+error_truncated:
+    errno = EINVAL;
+
+    return -1;
+}
+
+void nexrad_message_tar_close(nexrad_message_tar *tar) {
+    if (tar == NULL) {
+        return;
+    }
+
+    if (tar->stream.fd >= 0) {
+        close(tar->stream.fd);
+    }
+
+    _stream_cleanup(&tar->stream);
+
+    free(tar);
+}